@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 
 // ====================================================
@@ -20,7 +21,11 @@ static const uint8_t COMM_PMK[16]{'s', 'h', 'o', 'w', 'e', 'r', 'c', 't', 'r', '
 static const uint8_t COMM_LMK[16]{'s', 't', 'a', 't', 'i', 'c', '_', 'l', 'm', 'k', '_', 'u', 'i', 'c', 't', 'r'};  // Local Master Key
 
 // --- Protocol version ---
-constexpr uint8_t COMM_PROTOCOL_VERSION = 1;
+// v1: COMM_Payload only (UI command, Control ACK/ERR).
+// v2: adds typed frames (COMM_FrameHeader first), pushed by Control without a
+//     request. COMM_Payload is unchanged and still accepted; receivers tell
+//     the two apart by length, so a v1 peer simply drops v2 frames.
+constexpr uint8_t COMM_PROTOCOL_VERSION = 2;
 
 // --- Flag bit masks ---
 constexpr uint8_t COMM_FLAG_ACK = 1 << 0;  // Acknowledgment bit
@@ -31,6 +36,11 @@ constexpr uint8_t COMM_FLAG_FLOW_VALID = 1 << 4;  // Flow data included/valid
 // bits 5–7 reserved
 
 // --- Payload Structure ---
+// UI → Control: flowLpm is the flow target (COMM_FLAG_FLOW_VALID set) or
+// unused (clear: valves open as far as the mix allows).
+// Control → UI (ACK): ms and seq echo the packet being acknowledged (the UI
+// times the round trip from ms), setpointF carries the outlet temperature,
+// flowLpm the measured flow.
 typedef struct __attribute__((packed)) {
   uint32_t ms;      // timestamp (ms)
   uint16_t seq;     // sequence number
@@ -39,6 +49,59 @@ typedef struct __attribute__((packed)) {
   uint8_t flags;    // status bits (COMM_FLAG_*)
 } COMM_Payload;
 
+// --- Typed frames (v2) ---
+constexpr uint8_t COMM_FRAME_MAGIC = 0xC5;  // First byte of every typed frame
+
+enum COMM_FrameType : uint8_t {
+  COMM_FRAME_TELEMETRY = 1,  // Control → UI status push (COMM_TelemetryFrame)
+};
+
+typedef struct __attribute__((packed)) {
+  uint8_t magic;    // COMM_FRAME_MAGIC
+  uint8_t version;  // sender's COMM_PROTOCOL_VERSION
+  uint8_t type;     // COMM_FrameType
+  uint8_t len;      // whole frame size in bytes (newer versions may append fields)
+} COMM_FrameHeader;
+
+// COMM_TelemetryFrame::flags
+constexpr uint8_t COMM_TEL_OUTLET_VALID = 1 << 0;  // outletF valid
+constexpr uint8_t COMM_TEL_HOT_VALID = 1 << 1;     // hotF valid
+constexpr uint8_t COMM_TEL_COLD_VALID = 1 << 2;    // coldF valid
+constexpr uint8_t COMM_TEL_FLOW_VALID = 1 << 3;    // flowLpm valid
+constexpr uint8_t COMM_TEL_RUN = 1 << 4;           // Control is running the mix
+// bits 5–7 reserved
+
+typedef struct __attribute__((packed)) {
+  COMM_FrameHeader hdr;
+  uint32_t ms;         // Control millis() when captured
+  uint16_t seq;        // telemetry frame counter (gaps = lost frames)
+  float outletF;       // outlet temperature (°F, filtered)
+  float hotF;          // hot supply (°F, filtered)
+  float coldF;         // cold supply (°F, filtered)
+  float ratio;         // mix ratio in use (0 = all cold, 1 = all hot)
+  float flowLpm;       // measured flow (L/min)
+  uint32_t faultMask;  // active faults, bit n = FaultCode n (control/faults.h)
+  uint8_t flags;       // status bits (COMM_TEL_*)
+  // Appended: Control's view of the UI → Control link (link_quality.h)
+  int8_t rssiDbm;      // RSSI of UI frames, moving average (0 = none yet)
+  uint8_t lossPct;     // UI packets missing from the seq run, rolling (%)
+  uint8_t dupPct;      // UI packets received twice, rolling (%)
+} COMM_TelemetryFrame;
+
+// Telemetry frames from a sender without the link fields end here
+constexpr size_t COMM_TELEMETRY_BASE_BYTES = offsetof(COMM_TelemetryFrame, rssiDbm);
+
+static_assert(sizeof(COMM_TelemetryFrame) != sizeof(COMM_Payload), "v2 frames are told from v1 by length");
+
+// True if data is a typed frame of this type whose header length and buffer
+// both hold at least minLen bytes (fields appended by a newer sender are ignored)
+inline bool commIsFrame(const uint8_t* data, size_t len, COMM_FrameType type, size_t minLen) {
+  if (len < minLen || len < sizeof(COMM_FrameHeader) || len == sizeof(COMM_Payload)) return false;
+  const COMM_FrameHeader* hdr = (const COMM_FrameHeader*) data;
+  return hdr->magic == COMM_FRAME_MAGIC && hdr->version >= 2 && hdr->type == type && hdr->len >= minLen &&
+         hdr->len <= len;
+}
+
 // ====================================================
 // Setpoint configurations
 // ====================================================
@@ -50,3 +113,12 @@ constexpr float SETPOINT_STEP_F = 1.0f;       // Increment/decrement step
 
 constexpr float SETPOINT_PRESET_A_F = 98.0f;   // Preset A
 constexpr float SETPOINT_PRESET_B_F = 105.0f;  // Preset B
+
+// ====================================================
+// Flow target
+// ====================================================
+
+constexpr float FLOW_TARGET_DEFAULT_LPM = 0.0f;  // 0 = no target (full flow)
+constexpr float FLOW_TARGET_MIN_LPM = 0.15f;     // Lowest selectable target
+constexpr float FLOW_TARGET_MAX_LPM = 0.60f;     // Highest selectable target (above: full flow)
+constexpr float FLOW_TARGET_STEP_LPM = 0.05f;    // Increment/decrement step
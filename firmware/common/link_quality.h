@@ -0,0 +1,169 @@
+/*
+ * ================================================================
+ *  Module: link_quality
+ *  Purpose: Link-quality accumulator shared by both units. The comm
+ *           layer reports what it observes per frame (delivered,
+ *           lost, duplicate, a round-trip time, an RSSI) and this
+ *           keeps the totals, the loss and duplicate counts over the
+ *           last LINK_QUALITY_WINDOW outcomes, the RTT smoothed as in
+ *           TCP (RFC 6298: SRTT gain 1/8, RTTVAR gain 1/4, RTO =
+ *           SRTT + 4·RTTVAR) and the RSSI range and moving average.
+ *           Every update is O(1); the window is a pair of bit
+ *           histories. Not thread-safe: the caller serializes.
+ *
+ *  Dependencies:
+ *    - none
+ *
+ *  Interface:
+ *    LinkQuality
+ *      void delivered();
+ *      void lost(uint32_t n = 1);
+ *      void duplicate();
+ *      void rtt(uint32_t ms);
+ *      void rssi(int8_t dBm);
+ *      void reset();
+ *      LinkQualityStats stats() const;
+ * ================================================================
+ */
+
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+constexpr size_t LINK_QUALITY_WINDOW = 64;  // outcomes in the rolling counts (bits of a uint64_t)
+
+struct LinkQualityStats {
+  uint32_t delivered;        // outcomes since reset: got through
+  uint32_t lost;             // ... never got through
+  uint32_t duplicates;       // ... arrived again (or after being given up)
+  uint8_t windowCount;       // outcomes in the rolling window (≤ LINK_QUALITY_WINDOW)
+  uint8_t windowLost;        // ... of which lost
+  uint8_t windowDuplicates;  // ... of which duplicates
+  float lossPct;             // windowLost / (windowCount - windowDuplicates)
+  float duplicatePct;        // windowDuplicates / windowCount
+  uint32_t rttSamples;       // 0: no round trips measured (all RTT fields 0)
+  uint32_t rttLastMs;
+  uint32_t rttMinMs;
+  uint32_t rttMaxMs;
+  float rttSmoothMs;         // SRTT
+  float rttVarMs;            // RTTVAR
+  uint32_t rtoMs;            // SRTT + 4·RTTVAR, rounded up: a timeout that covers nearly every ACK
+  uint32_t rssiSamples;      // 0: no frame received (all RSSI fields 0)
+  int8_t rssiLastDbm;
+  int8_t rssiMinDbm;
+  int8_t rssiMaxDbm;
+  float rssiMeanDbm;         // moving average, gain 1/16
+};
+
+class LinkQuality {
+ public:
+  // A frame (or round trip) got through
+  void delivered() {
+    push(false, false);
+    delivered_++;
+  }
+
+  // n frames never arrived (a sequence gap counts each missing number)
+  void lost(uint32_t n = 1) {
+    lost_ += n;
+    for (uint32_t i = 0; i < n && i < LINK_QUALITY_WINDOW; ++i) push(true, false);
+  }
+
+  // A frame already counted (delivered or lost) arrived again
+  void duplicate() {
+    push(false, true);
+    duplicates_++;
+  }
+
+  void rtt(uint32_t ms) {
+    const float r = (float) ms;
+    if (rttSamples_ == 0) {
+      srtt_ = r;
+      rttVar_ = r / 2.0f;
+      rttMin_ = rttMax_ = ms;
+    } else {
+      const float err = r - srtt_;
+      rttVar_ += ((err < 0.0f ? -err : err) - rttVar_) / 4.0f;
+      srtt_ += err / 8.0f;
+      if (ms < rttMin_) rttMin_ = ms;
+      if (ms > rttMax_) rttMax_ = ms;
+    }
+    rttLast_ = ms;
+    rttSamples_++;
+  }
+
+  void rssi(int8_t dBm) {
+    if (rssiSamples_ == 0) {
+      rssiMean_ = dBm;
+      rssiMin_ = rssiMax_ = dBm;
+    } else {
+      rssiMean_ += (dBm - rssiMean_) / 16.0f;
+      if (dBm < rssiMin_) rssiMin_ = dBm;
+      if (dBm > rssiMax_) rssiMax_ = dBm;
+    }
+    rssiLast_ = dBm;
+    rssiSamples_++;
+  }
+
+  void reset() { *this = LinkQuality(); }
+
+  LinkQualityStats stats() const {
+    LinkQualityStats st{};
+    st.delivered = delivered_;
+    st.lost = lost_;
+    st.duplicates = duplicates_;
+    st.windowCount = count_;
+    st.windowLost = (uint8_t) __builtin_popcountll(lostBits_);
+    st.windowDuplicates = (uint8_t) __builtin_popcountll(dupBits_);
+    const uint8_t expected = st.windowCount - st.windowDuplicates;
+    st.lossPct = expected ? 100.0f * st.windowLost / expected : 0.0f;
+    st.duplicatePct = st.windowCount ? 100.0f * st.windowDuplicates / st.windowCount : 0.0f;
+    st.rttSamples = rttSamples_;
+    if (rttSamples_) {
+      st.rttLastMs = rttLast_;
+      st.rttMinMs = rttMin_;
+      st.rttMaxMs = rttMax_;
+      st.rttSmoothMs = srtt_;
+      st.rttVarMs = rttVar_;
+      st.rtoMs = (uint32_t) ceilf(srtt_ + 4.0f * rttVar_);
+    }
+    st.rssiSamples = rssiSamples_;
+    if (rssiSamples_) {
+      st.rssiLastDbm = rssiLast_;
+      st.rssiMinDbm = rssiMin_;
+      st.rssiMaxDbm = rssiMax_;
+      st.rssiMeanDbm = rssiMean_;
+    }
+    return st;
+  }
+
+ private:
+  // Shift one outcome into the window; the oldest falls out at bit 63
+  void push(bool lost, bool dup) {
+    lostBits_ = (lostBits_ << 1) | (lost ? 1u : 0u);
+    dupBits_ = (dupBits_ << 1) | (dup ? 1u : 0u);
+    if (count_ < LINK_QUALITY_WINDOW) count_++;
+  }
+
+  uint64_t lostBits_ = 0;
+  uint64_t dupBits_ = 0;
+  uint8_t count_ = 0;
+  uint32_t delivered_ = 0;
+  uint32_t lost_ = 0;
+  uint32_t duplicates_ = 0;
+
+  uint32_t rttSamples_ = 0;
+  uint32_t rttLast_ = 0;
+  uint32_t rttMin_ = 0;
+  uint32_t rttMax_ = 0;
+  float srtt_ = 0.0f;
+  float rttVar_ = 0.0f;
+
+  uint32_t rssiSamples_ = 0;
+  int8_t rssiLast_ = 0;
+  int8_t rssiMin_ = 0;
+  int8_t rssiMax_ = 0;
+  float rssiMean_ = 0.0f;
+};
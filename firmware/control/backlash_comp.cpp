@@ -0,0 +1,139 @@
+#include "backlash_comp.h"
+
+#include <math.h>
+
+#include "feedforward.h"
+
+// Offset of the commanded ratio over the ratio the outlet shows, averaged
+// over one rest after moving in one direction, in opening units (times the
+// total: at total t a stem short by d passes t·r - d, i.e. ratio r - d/t)
+struct Rest {
+  bool valid;
+  uint32_t endMs;
+  float ratio;
+  float offset;
+  float width;  // compensation in force while it was taken
+};
+
+static BacklashStats s_stats;
+static int s_dir = 0;                  // -1 / +1 direction of motion, 0 unknown
+static bool s_hasRatio = false;
+static float s_extremeRatio = 0.0f;    // furthest ratio in s_dir (first ratio while s_dir == 0)
+static float s_anchorRatio = 0.0f;     // ratio at the last move
+static float s_anchorTotal = 0.0f;     // total opening at the last move
+static uint32_t s_lastMoveMs = 0;
+
+static Rest s_rest[2];                 // last completed rest per direction (index: s_dir > 0)
+static uint32_t s_restSamples = 0;     // samples in the current rest
+static float s_restOffsetSum = 0.0f;
+
+// Ratio that would give outletF at steady state (feedforward model inverted);
+// NAN when the model cannot resolve it
+static float effectiveRatio(float outletF, float hotF, float coldF, float flowLpm) {
+  const float span = hotF - coldF;
+  if (isnan(outletF) || isnan(span) || span < FF_MIN_SPAN_F) return NAN;
+  const float hotFraction = (feedforwardMixTargetF(outletF, flowLpm) - coldF) / span;
+  return feedforwardRatioForHotFraction(hotFraction);
+}
+
+// Pair a finished rest with the last one in the other direction:
+// offset_up - offset_down = play - mean compensation
+static void learn(const Rest& rest, int dir) {
+  Rest& other = s_rest[dir < 0];
+  if (other.valid && rest.endMs - other.endMs <= BACKLASH_PAIR_MAX_MS &&
+      fabsf(rest.ratio - other.ratio) <= BACKLASH_PAIR_RATIO) {
+    const float upMinusDown = (dir > 0) ? rest.offset - other.offset : other.offset - rest.offset;
+    const float sample = upMinusDown + 0.5f * (rest.width + other.width);
+    const float w = s_stats.width + BACKLASH_GAIN * (sample - s_stats.width);
+    s_stats.width = w < 0.0f ? 0.0f : (w > BACKLASH_MAX_RATIO ? BACKLASH_MAX_RATIO : w);
+    s_stats.measured++;
+    other.valid = false;
+  }
+  s_rest[dir > 0] = rest;
+}
+
+// Close the current rest (the ratio moved, or control stopped)
+static void endRest(uint32_t nowMs) {
+  if (s_dir != 0 && s_restSamples >= BACKLASH_REST_MIN_SAMPLES) {
+    s_stats.rests++;
+    learn(Rest{true, nowMs, s_anchorRatio, s_restOffsetSum / (float) s_restSamples, s_stats.width}, s_dir);
+  }
+  s_restSamples = 0;
+  s_restOffsetSum = 0.0f;
+}
+
+void backlashCompInit() {
+  s_stats = BacklashStats{};
+  s_stats.width = BACKLASH_INIT_RATIO;
+  s_rest[0].valid = s_rest[1].valid = false;
+  s_dir = 0;
+  s_hasRatio = false;
+  s_restSamples = 0;
+  s_restOffsetSum = 0.0f;
+}
+
+void backlashCompReset() {
+  s_restSamples = 0;  // valves were moved elsewhere: drop the rest in progress
+  s_restOffsetSum = 0.0f;
+  s_dir = 0;
+  s_hasRatio = false;
+}
+
+float backlashCompUpdate(float ratio,
+                         float total,
+                         uint32_t nowMs,
+                         float outletF,
+                         float hotF,
+                         float coldF,
+                         float flowLpm,
+                         bool flowValid) {
+  if (!s_hasRatio) {
+    s_extremeRatio = s_anchorRatio = ratio;
+    s_anchorTotal = total;
+    s_lastMoveMs = nowMs;
+    s_hasRatio = true;
+  }
+
+  // Direction of motion, with BACKLASH_REVERSAL_EPS of hysteresis
+  if (s_dir == 0) {
+    if (fabsf(ratio - s_extremeRatio) >= BACKLASH_REVERSAL_EPS) {
+      s_dir = (ratio > s_extremeRatio) ? 1 : -1;
+      s_extremeRatio = ratio;
+    }
+  } else if ((ratio - s_extremeRatio) * (float) s_dir >= 0.0f) {
+    s_extremeRatio = ratio;
+  } else if ((s_extremeRatio - ratio) * (float) s_dir >= BACKLASH_REVERSAL_EPS) {
+    s_stats.reversals++;
+    s_dir = -s_dir;
+    s_extremeRatio = ratio;
+  }
+
+  // A rest is the ratio and total holding still; sample it once the outlet
+  // has settled (pipe transport plus BACKLASH_SETTLE_MS)
+  const bool totalMoved = fabsf(total - s_anchorTotal) >= BACKLASH_REVERSAL_EPS;
+  if (fabsf(ratio - s_anchorRatio) >= BACKLASH_REVERSAL_EPS || totalMoved) {
+    endRest(nowMs);
+    s_anchorRatio = ratio;
+    s_anchorTotal = total;
+    s_lastMoveMs = nowMs;
+    if (totalMoved) {
+      // Both valves moved the same way: no up/down side until the ratio moves
+      s_dir = 0;
+      s_extremeRatio = ratio;
+    }
+  } else if (flowValid && flowLpm >= FF_MIN_FLOW_LPM && ratio > BACKLASH_RATIO_MARGIN &&
+             ratio < 1.0f - BACKLASH_RATIO_MARGIN) {
+    const uint32_t settleMs = (uint32_t) (FF_OUTLET_PIPE_L / flowLpm * 60000.0f) + BACKLASH_SETTLE_MS;
+    const float effective = effectiveRatio(outletF, hotF, coldF, flowLpm);
+    if (nowMs - s_lastMoveMs >= settleMs && !isnan(effective)) {
+      s_restOffsetSum += total * (ratio - effective);
+      s_restSamples++;
+    }
+  }
+
+  return s_stats.width;
+}
+
+const BacklashStats& backlashCompStats() {
+  return s_stats;
+}
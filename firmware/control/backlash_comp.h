@@ -0,0 +1,67 @@
+/*
+ * ================================================================
+ *  Module: backlash_comp
+ *  Purpose: Learns the servo + valve stem play for the inverse
+ *           backlash in valve_mix (valveMixSetPlay). The MG996R gear
+ *           train and valve stem have play, so after a valve reverses
+ *           it does not move until the play is taken up; small trims
+ *           near setpoint are lost and the integrator winds up. Each
+ *           valve's opening is offset by half the play in its own
+ *           direction of motion (a step of one play width on each
+ *           reversal), so ratio moves (valves in opposite directions)
+ *           and flow moves (both the same way) are both covered.
+ *           The width is learned online. Whenever the ratio rests
+ *           after moving one way, the settled outlet is run back
+ *           through the feedforward model to the ratio the valves
+ *           actually deliver; the stems sit short of the command by
+ *           half the uncovered play, on the side they came from. The
+ *           difference between a rest after moving up and one after
+ *           moving down is that play, and valve-model errors shared
+ *           by both rests cancel. Widths are fractions of full valve
+ *           opening (ratio units at total opening 1).
+ *
+ *  Dependencies:
+ *    - config.h       (BACKLASH_*, FF_OUTLET_PIPE_L, FF_MIN_FLOW_LPM, FF_MIN_SPAN_F)
+ *    - feedforward.h  (model inversion)
+ *
+ *  Interface:
+ *    void backlashCompInit();
+ *    void backlashCompReset();
+ *    float backlashCompUpdate(float ratio, float total, uint32_t nowMs, float outletF, float hotF,
+ *                             float coldF, float flowLpm, bool flowValid);
+ *    const BacklashStats& backlashCompStats();
+ * ================================================================
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "config.h"
+
+struct BacklashStats {
+  float width;         // current play estimate (fraction of full opening)
+  uint32_t reversals;  // direction reversals of the commanded ratio
+  uint32_t rests;      // settled rests sampled
+  uint32_t measured;   // up/down rest pairs folded into the estimate
+};
+
+// Width back to BACKLASH_INIT_RATIO, direction unknown
+void backlashCompInit();
+
+// Forget the direction of motion and the rest in progress (valves were moved
+// elsewhere, e.g. closed); the width estimate is kept
+void backlashCompReset();
+
+// Fold in one control step (ratio and total as sent to applyMixFlow(), the
+// filtered outlet and line readings) and return the play for valveMixSetPlay()
+float backlashCompUpdate(float ratio,
+                         float total,
+                         uint32_t nowMs,
+                         float outletF,
+                         float hotF,
+                         float coldF,
+                         float flowLpm,
+                         bool flowValid);
+
+const BacklashStats& backlashCompStats();
@@ -2,10 +2,15 @@
 
 #include <Arduino.h>
 #include <EspNowLink.h>
+#include <math.h>
 
 #include "../common/config.h"
+#include "../common/link_quality.h"
+#include "config.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/portmacro.h"
+#include "freertos/task.h"
+#include "spsc_ring.h"
 
 // RX sequence tracking
 static CommCommand s_lastCmd{};  // last command sent
@@ -15,40 +20,135 @@ static unsigned long s_lastRxMs = 0;  // millis() when last valid packet arrived
 // Protects s_lastCmd and s_newCmd
 static portMUX_TYPE s_cmdMux = portMUX_INITIALIZER_UNLOCKED;
 
-// Latest outlet temperature to mirror back to UI
-static float s_outletTempF = 0.0f;
-static bool s_outletTempValid = false;
-static float s_flowLpm = 0.0f;
-static bool s_flowValid = false;
+// Latest state to mirror back to UI (ACKs read it from the comm task)
+static CommTelemetry s_telemetry{};
 static portMUX_TYPE s_tempMux = portMUX_INITIALIZER_UNLOCKED;
 
+// Telemetry push (control task only)
+static unsigned long s_lastPushMs = 0;
+static uint16_t s_pushSeq = 0;
+
+static void (*s_rxHook)() = nullptr;
+
+// Link quality of the UI → Control direction (updated by the comm task). The
+// UI numbers each message once and retransmits under the same seq, so a gap
+// in the seq run is a message lost on every try and a repeat is a duplicate.
+static LinkQuality s_link;
+static uint16_t s_seqHigh = 0;  // highest UI seq seen (0 = none yet)
+static uint64_t s_seqSeen = 0;  // bit n set: seq s_seqHigh - n received
+static portMUX_TYPE s_linkMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Received frame as copied by on_rx; longer frames keep their length (and
+// get an ERR) but only the first COMM_RX_SLOT_BYTES
+struct RxSlot {
+  uint32_t rxUs;
+  uint32_t rxMs;
+  int8_t rssiDbm;
+  uint16_t len;
+  uint8_t data[COMM_RX_SLOT_BYTES];
+};
+
+static_assert(COMM_RX_SLOT_BYTES >= sizeof(COMM_Payload) && COMM_RX_SLOT_BYTES >= sizeof(COMM_TelemetryFrame),
+              "COMM_RX_SLOT_BYTES must hold every known frame");
+
+static SpscRing<RxSlot, COMM_RX_QUEUE_LEN> s_rxRing;  // Wi-Fi task → comm task
+static TaskHandle_t s_commTask = nullptr;
+
+// Written only by on_rx (Wi-Fi task) / only by the comm task; a snapshot may
+// mix two passes
+static uint32_t s_rxFrames = 0;
+static uint32_t s_cbSumUs = 0;
+static uint32_t s_cbMaxUs = 0;
+static uint32_t s_processed = 0;
+static uint32_t s_acks = 0;
+static uint32_t s_ackFails = 0;
+static uint32_t s_ackLatencyMaxUs = 0;
+static uint32_t s_ackLatencySumUs = 0;
+
+// Wi-Fi task context: copy into the ring and wake the comm task, nothing else
 static void on_rx(const uint8_t src_mac[6], const uint8_t* data, size_t len, void* ctx) {
+  const uint32_t startUs = micros();
+
+  RxSlot slot;
+  slot.rxUs = startUs;
+  slot.rxMs = millis();
+  slot.rssiDbm = espnow_link_last_rssi();  // of this frame while in the callback
+  slot.len = (uint16_t) (len > UINT16_MAX ? UINT16_MAX : len);
+  memcpy(slot.data, data, len < COMM_RX_SLOT_BYTES ? len : COMM_RX_SLOT_BYTES);
+  if (s_rxRing.push(slot) && s_commTask) xTaskNotifyGive(s_commTask);
+
+  const uint32_t tookUs = micros() - startUs;
+  s_rxFrames++;
+  s_cbSumUs += tookUs;
+  if (tookUs > s_cbMaxUs) s_cbMaxUs = tookUs;
+}
+
+// Count one UI packet as delivered (after any gap), late or duplicate
+// (call with s_linkMux held)
+static void trackSeqLocked(uint16_t seq) {
+  int32_t d = (int16_t) (seq - s_seqHigh);
+  if (d > 0 && seq < s_seqHigh) d--;  // wrapped past 0, which the UI never sends
+  if (s_seqHigh != 0 && d > 0) {
+    if (d > 1) s_link.lost((uint32_t) (d - 1));
+    s_seqSeen = d < (int32_t) LINK_QUALITY_WINDOW ? (s_seqSeen << d) | 1u : 1u;
+    s_seqHigh = seq;
+    s_link.delivered();
+  } else if (s_seqHigh != 0 && -d < (int32_t) LINK_QUALITY_WINDOW) {
+    const uint64_t bit = (uint64_t) 1u << -d;
+    if (s_seqSeen & bit) {
+      s_link.duplicate();
+    } else {
+      s_seqSeen |= bit;  // late; its gap has already been counted as lost
+      s_link.delivered();
+    }
+  } else {
+    // First packet, or far behind: the UI restarted its numbering
+    s_seqHigh = seq;
+    s_seqSeen = 1u;
+    s_link.delivered();
+  }
+}
+
+// Comm task: parse one frame, store the command, send ACK/ERR
+static void handleFrame(const RxSlot& slot) {
   COMM_Payload ack{};
   ack.ms = millis();
 
   CommCommand cmd{};
   cmd.lastOk = false;
 
-  if (len == sizeof(COMM_Payload)) {
-    s_lastRxMs = millis();
+  portENTER_CRITICAL(&s_linkMux);
+  s_link.rssi(slot.rssiDbm);
+  portEXIT_CRITICAL(&s_linkMux);
+
+  if (slot.len == sizeof(COMM_Payload)) {
+    s_lastRxMs = slot.rxMs;
     // Valid packet: extract data and prepare ACK
     COMM_Payload p;
-    memcpy(&p, data, sizeof(p));
+    memcpy(&p, slot.data, sizeof(p));
 
     cmd.setpointF = p.setpointF;
+    cmd.flowTargetLpm = (p.flags & COMM_FLAG_FLOW_VALID) ? p.flowLpm : 0.0f;
     cmd.runFlag = (p.flags & COMM_FLAG_RUN);
     cmd.lastSeq = p.seq;
     cmd.lastOk = true;
 
+    if (p.seq != 0) {
+      portENTER_CRITICAL(&s_linkMux);
+      trackSeqLocked(p.seq);
+      portEXIT_CRITICAL(&s_linkMux);
+    }
+
+    ack.ms = p.ms;  // echoed for the UI's round-trip time
     ack.seq = p.seq;
     ack.flags = COMM_FLAG_ACK;
     portENTER_CRITICAL(&s_tempMux);
-    ack.setpointF = s_outletTempF;
-    if (s_outletTempValid) {
+    ack.setpointF = s_telemetry.outletF;
+    if (s_telemetry.outletValid) {
       ack.flags |= COMM_FLAG_TEMP_VALID;
     }
-    ack.flowLpm = s_flowLpm;
-    if (s_flowValid) {
+    ack.flowLpm = s_telemetry.flowLpm;
+    if (s_telemetry.flowValid) {
       ack.flags |= COMM_FLAG_FLOW_VALID;
     }
     portEXIT_CRITICAL(&s_tempMux);
@@ -67,8 +167,36 @@ static void on_rx(const uint8_t src_mac[6], const uint8_t* data, size_t len, voi
   s_newCmd = true;
   portEXIT_CRITICAL(&s_cmdMux);
 
-  // Send ACK/ERR back to UI (ignore send error here)
-  (void) espnow_link_send(&ack, sizeof(ack));
+  // Send ACK/ERR back to UI (failures are only counted)
+  if (espnow_link_send(&ack, sizeof(ack)) == ENL_OK) {
+    s_acks++;
+  } else {
+    s_ackFails++;
+  }
+  const uint32_t latencyUs = micros() - slot.rxUs;
+  s_ackLatencySumUs += latencyUs;
+  if (latencyUs > s_ackLatencyMaxUs) s_ackLatencyMaxUs = latencyUs;
+  s_processed++;
+
+  if (s_rxHook) s_rxHook();
+}
+
+size_t commService() {
+  size_t n = 0;
+  RxSlot slot;
+  while (s_rxRing.pop(slot)) {
+    handleFrame(slot);
+    n++;
+  }
+  return n;
+}
+
+static void commTask(void* arg) {
+  (void) arg;
+  for (;;) {
+    (void) ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    (void) commService();
+  }
 }
 
 static void on_tx(const uint8_t dst_mac[6], bool ok, void* ctx) {
@@ -76,6 +204,12 @@ static void on_tx(const uint8_t dst_mac[6], bool ok, void* ctx) {
 }
 
 bool commInit() {
+  if (!s_commTask &&
+      xTaskCreatePinnedToCore(commTask, "comm", COMM_TASK_STACK_BYTES, nullptr, COMM_TASK_PRIORITY, &s_commTask,
+                              COMM_TASK_CORE) != pdPASS) {
+    return false;
+  }
+
   EspNowLinkConfig config{
       .peerMac = COMM_UI_MAC,
       .channel = COMM_CHANNEL,
@@ -110,11 +244,66 @@ void commMarkLinkLost() {
   s_lastRxMs = 0;
 }
 
-void commUpdateOutletTemp(float outletTempF, bool tempValid, float flowLpm, bool flowValid) {
+void commPublishTelemetry(const CommTelemetry& t, unsigned long nowMs) {
   portENTER_CRITICAL(&s_tempMux);
-  s_outletTempF = outletTempF;
-  s_outletTempValid = tempValid;
-  s_flowLpm = flowLpm;
-  s_flowValid = flowValid;
+  s_telemetry = t;
   portEXIT_CRITICAL(&s_tempMux);
+
+  // Only while the UI is heard: unicast to an absent peer burns airtime on retries
+  if (COMM_TELEMETRY_PUSH_MS == 0) return;
+  const unsigned long lastRxMs = s_lastRxMs;
+  if (lastRxMs == 0 || (unsigned long) (nowMs - lastRxMs) > COMM_LINK_TIMEOUT_MS) return;
+  if (s_lastPushMs != 0 && (unsigned long) (nowMs - s_lastPushMs) < COMM_TELEMETRY_PUSH_MS) return;
+  s_lastPushMs = nowMs;
+
+  COMM_TelemetryFrame f{};
+  f.hdr.magic = COMM_FRAME_MAGIC;
+  f.hdr.version = COMM_PROTOCOL_VERSION;
+  f.hdr.type = COMM_FRAME_TELEMETRY;
+  f.hdr.len = sizeof(f);
+  f.ms = nowMs;
+  f.seq = ++s_pushSeq;
+  f.outletF = t.outletF;
+  f.hotF = t.hotF;
+  f.coldF = t.coldF;
+  f.ratio = t.ratio;
+  f.flowLpm = t.flowLpm;
+  f.faultMask = t.faultMask;
+  const LinkQualityStats link = commLinkQuality();
+  f.rssiDbm = (int8_t) lroundf(link.rssiMeanDbm);
+  f.lossPct = (uint8_t) lroundf(link.lossPct);
+  f.dupPct = (uint8_t) lroundf(link.duplicatePct);
+  if (t.outletValid) f.flags |= COMM_TEL_OUTLET_VALID;
+  if (t.hotValid) f.flags |= COMM_TEL_HOT_VALID;
+  if (t.coldValid) f.flags |= COMM_TEL_COLD_VALID;
+  if (t.flowValid) f.flags |= COMM_TEL_FLOW_VALID;
+  if (t.runFlag) f.flags |= COMM_TEL_RUN;
+  (void) espnow_link_send(&f, sizeof(f));  // best effort; the next frame supersedes it
+}
+
+void commSetRxHook(void (*hook)()) {
+  s_rxHook = hook;
+}
+
+CommRxStats commRxStats() {
+  CommRxStats st{};
+  st.frames = s_rxFrames;
+  st.dropped = s_rxRing.dropped();
+  st.processed = s_processed;
+  st.depth = (uint32_t) s_rxRing.size();
+  st.highWater = s_rxRing.highWater();
+  st.callbackMeanUs = s_rxFrames ? s_cbSumUs / s_rxFrames : 0;
+  st.callbackMaxUs = s_cbMaxUs;
+  st.acks = s_acks;
+  st.ackFails = s_ackFails;
+  st.ackLatencyMeanUs = s_processed ? s_ackLatencySumUs / s_processed : 0;
+  st.ackLatencyMaxUs = s_ackLatencyMaxUs;
+  return st;
+}
+
+LinkQualityStats commLinkQuality() {
+  portENTER_CRITICAL(&s_linkMux);
+  const LinkQualityStats st = s_link.stats();
+  portEXIT_CRITICAL(&s_linkMux);
+  return st;
 }
@@ -6,45 +6,115 @@
  *           run-state commands from the UI Unit via ESP-NOW.
  *
  *  Communication:
- *    - Receives COMM_Payload packets from UI Unit
- *    - Validates payload length and updates last received command
- *    - Sends ACK or ERR response back to UI
+ *    - Receives COMM_Payload packets from UI Unit (setpoint, run flag,
+ *      optional flow target)
+ *    - The ESP-NOW receive callback (Wi-Fi task) only copies each frame
+ *      into a preallocated ring slot and wakes the comm task; the comm
+ *      task validates it, updates the last received command and sends
+ *      the ACK or ERR response back to UI. The radio callback stays
+ *      short and takes no locks, so back-to-back packets are not lost
+ *      behind an ACK send. Callback time, ring depth and RX → ACK
+ *      latency are counted (commRxStats)
+ *    - Pushes COMM_TelemetryFrame (protocol v2) every
+ *      COMM_TELEMETRY_PUSH_MS while the UI is heard, so the display
+ *      follows the outlet without waiting for the next UI packet
+ *    - Link quality of the UI → Control direction (commLinkQuality):
+ *      RSSI of every frame, and UI packets lost (gaps in the seq run)
+ *      or received twice (retransmits whose ACK was lost). ACKs echo
+ *      the packet's ms so the UI can time the round trip; Control has
+ *      no RTT of its own (nothing it sends is acknowledged). The loss,
+ *      duplicate and RSSI figures ride along in each telemetry frame
  *
  *  Dependencies:
  *    - <stdint.h>   (basic integer types)
  *    - EspNowLink   (transport layer)
- *    - config.h     (COMM_* constants and MAC addresses)
+ *    - spsc_ring.h  (callback → comm task ring)
+ *    - FreeRTOS     (comm task)
+ *    - ../common/config.h (COMM_* protocol, MAC addresses)
+ *    - ../common/link_quality.h (loss/duplicate/RSSI accounting)
+ *    - config.h     (COMM_LINK_TIMEOUT_MS, COMM_TELEMETRY_PUSH_MS, COMM_RX_*, COMM_TASK_*)
  *
  *  Interface:
  *    bool commInit();
  *    bool commPollCommand(CommCommand& outCmd);
- *    void commUpdateOutletTemp(float outletTempF, bool tempValid, float flowLpm, bool flowValid);
+ *    size_t commService();
+ *    CommRxStats commRxStats();
+ *    LinkQualityStats commLinkQuality();
+ *    void commPublishTelemetry(const CommTelemetry& t, unsigned long nowMs);
+ *    void commSetRxHook(void (*hook)());
  *
  *  Data Structures:
  *    struct CommCommand {
  *      float setpointF;    // desired setpoint (°F)
+ *      float flowTargetLpm; // desired flow (L/min), 0 = none
  *      bool  runFlag;      // true=ON, false=OFF
  *      uint32_t lastSeq;   // last received sequence number
  *      bool  lastOk;       // true=valid packet, false=error
  *    };
+ *
+ *    struct CommTelemetry {  // Control state reported to the UI
+ *      float outletF, hotF, coldF, ratio, flowLpm;
+ *      bool  outletValid, hotValid, coldValid, flowValid;
+ *      uint32_t faultMask;  // faultMask() bits
+ *      bool  runFlag;
+ *    };
  * ================================================================
  */
 
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 
+#include "../common/link_quality.h"
+
 // Holds the latest command received from the UI
 struct CommCommand {
   float setpointF;
+  float flowTargetLpm;  // 0 when the UI sent no target (COMM_FLAG_FLOW_VALID clear)
   bool runFlag;
   uint32_t lastSeq;
   bool lastOk;
 };
 
-// Initialize ESP-NOW communication for Control Unit
+// Control state reported to the UI (ACK mirror and telemetry frames)
+struct CommTelemetry {
+  float outletF;
+  float hotF;
+  float coldF;
+  float ratio;
+  float flowLpm;
+  bool outletValid;
+  bool hotValid;
+  bool coldValid;
+  bool flowValid;
+  uint32_t faultMask;
+  bool runFlag;
+};
+
+// Receive-path counters since boot (callback and ring, comm task, ACKs)
+struct CommRxStats {
+  uint32_t frames;            // frames seen by the receive callback
+  uint32_t dropped;           // ... not queued because the ring was full
+  uint32_t processed;         // frames handled by the comm task
+  uint32_t depth;             // ring occupancy now
+  uint32_t highWater;         // deepest ring occupancy seen
+  uint32_t callbackMeanUs;    // receive callback duration
+  uint32_t callbackMaxUs;
+  uint32_t acks;              // ACK/ERR sends accepted by ESP-NOW
+  uint32_t ackFails;          // ... rejected
+  uint32_t ackLatencyMeanUs;  // frame received → ACK handed to ESP-NOW
+  uint32_t ackLatencyMaxUs;
+};
+
+// Initialize ESP-NOW communication for Control Unit (starts the comm task)
 bool commInit();
 
+// Handle every frame queued by the receive callback: store the command and
+// send the ACK/ERR. Run by the comm task; exposed so a host simulation can
+// play that task. Returns the number of frames handled.
+size_t commService();
+
 // Poll for a new command from the UI (returns true if new data received)
 bool commPollCommand(CommCommand& outCmd);
 
@@ -54,5 +124,16 @@ unsigned long commLastRxMs();
 // Mark link as lost (resets last RX timestamp)
 void commMarkLinkLost();
 
-// Provide latest outlet temperature so ACK packets can mirror it back to the UI
-void commUpdateOutletTemp(float outletTempF, bool tempValid, float flowLpm, bool flowValid);
+// Latest state for the UI: ACKs mirror outlet and flow from it, and a
+// telemetry frame is sent when COMM_TELEMETRY_PUSH_MS has passed and the
+// UI has been heard within COMM_LINK_TIMEOUT_MS. Call once per control pass.
+void commPublishTelemetry(const CommTelemetry& t, unsigned long nowMs);
+
+// Called from the comm task after each packet is stored, e.g. to wake the
+// control task. Must not block.
+void commSetRxHook(void (*hook)());
+
+CommRxStats commRxStats();
+
+// UI → Control link: RSSI, rolling loss and duplicates (rttSamples stays 0)
+LinkQualityStats commLinkQuality();
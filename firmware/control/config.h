@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 
 using DeviceAddress = uint8_t[8];
@@ -9,12 +10,43 @@ using DeviceAddress = uint8_t[8];
 // ====================================================
 
 constexpr uint8_t TEMP_PIN_ONEWIRE = 4;           // DS18B20 data line (GPIO 4)
-constexpr uint8_t TEMP_RESOLUTION = 9;            // 9-bit (~93.75 ms conversion, 0.5°C step)
+constexpr uint8_t TEMP_RESOLUTION = 9;            // Start-up / transient resolution (~93.75 ms conversion, 0.5°C step)
 constexpr unsigned TEMP_CONVERSION_TIME_MS = 94;  // Max conversion time at 9-bit resolution
-constexpr unsigned TEMP_LOOP_DT_MS = 100;         // 10 Hz polling rate
+constexpr unsigned TEMP_LOOP_DT_MS = 100;         // Nominal outlet sample period (9-bit, back-to-back)
 constexpr float TEMP_MIN_VALID_C = -60.0f;        // Minimum valid temperature (°C)
 constexpr float TEMP_MAX_VALID_C = 125.0f;        // Maximum valid temperature (°C)
-constexpr float TEMP_EMA_ALPHA = 0.20f;           // EMA filter (τ ≈ 0.4 s @10 Hz)
+constexpr float TEMP_EMA_TAU_S = 0.4f;            // EMA filter time constant (α = 0.2 at 10 Hz)
+
+// Per-sensor scheduling: each sensor converts on its own period (addressed
+// Convert T) and its own resolution. A sensor runs at TEMP_RESOLUTION while
+// its reading moves, and switches to the settled resolution once
+// TEMP_SETTLE_SAMPLES readings in a row stay within TEMP_SETTLE_BAND_C.
+constexpr unsigned TEMP_OUTLET_PERIOD_MS = 0;     // Outlet: 0 = next conversion as soon as one is read
+constexpr unsigned TEMP_LINE_PERIOD_MS = 500;     // Hot/cold lines (period is at least the conversion time)
+constexpr uint8_t TEMP_OUTLET_SETTLED_RES = 11;   // 0.125°C, 375 ms conversion
+constexpr uint8_t TEMP_LINE_SETTLED_RES = 12;     // 0.0625°C, 750 ms conversion
+constexpr float TEMP_SETTLE_BAND_C = 0.6f;        // Leaving this band (from the run's first reading) = transient
+constexpr uint8_t TEMP_SETTLE_SAMPLES = 5;        // Readings inside the band before switching to fine
+constexpr unsigned TEMP_TRANSIENT_HOLD_MS = 10000; // temperatureMarkTransient(): stay coarse this long (covers transport delay)
+
+// Scratchpad reads per temperatureService() call, outlet first. One read is
+// ~5.4 ms of bus time; a finished conversion not read this call is read on the
+// next one, so no single call (or pipeline sensor release) holds the bus for
+// the whole batch.
+constexpr uint8_t TEMP_MAX_READS_PER_SERVICE = 1;
+
+// DS18B20 worst-case conversion time: 93.75 ms at 9 bits, doubling per bit
+constexpr unsigned tempConversionMs(uint8_t bits) {
+  return (bits >= 12) ? 750 : (bits == 11) ? 375 : (bits == 10) ? 188 : 94;
+}
+// Longest time between two readings of a sensor (settled resolution; the
+// period is at least the conversion time): outlet 375 ms, lines 750 ms
+constexpr unsigned TEMP_OUTLET_MAX_PERIOD_MS =
+    TEMP_OUTLET_PERIOD_MS > tempConversionMs(TEMP_OUTLET_SETTLED_RES) ? TEMP_OUTLET_PERIOD_MS
+                                                                      : tempConversionMs(TEMP_OUTLET_SETTLED_RES);
+constexpr unsigned TEMP_LINE_MAX_PERIOD_MS =
+    TEMP_LINE_PERIOD_MS > tempConversionMs(TEMP_LINE_SETTLED_RES) ? TEMP_LINE_PERIOD_MS
+                                                                  : tempConversionMs(TEMP_LINE_SETTLED_RES);
 
 // Plausibility window for outlet control logic (°F)
 constexpr float OUTLET_MIN_PLAUSIBLE_F = 32.0f;
@@ -52,6 +84,42 @@ constexpr unsigned SERVO_COLD_MIN_US = 1120;  // µs at fully open position
 constexpr unsigned SERVO_COLD_MAX_US = 2080;  // µs at fully closed position
 constexpr unsigned SERVO_GUARD_US = 15;       // Guard offset to avoid hard stops
 
+// Valve flow curves: entry i is the pulse width at which that valve alone
+// passes i / (VALVE_LUT_POINTS - 1) of its full flow. applyMixRatio() opens hot
+// to `ratio` and cold to `1 - ratio` of full flow, so the ratio is the hot
+// share of the mix.
+// SIM PLACEHOLDERS, not a measurement: the tables below are a straight remap
+// of the shower_sim valve model's dead/full travel (FF_VALVE_DEAD_FRAC /
+// FF_VALVE_FULL_FRAC), so hot stops at 1360 µs, not at the calibrated soft
+// limit. Replace them with the firmware/tools/m1_servo_calibration [K]
+// capture of each valve before enabling the LUT on hardware.
+// In shower_sim the LUT is what decouples flow from temperature: flow-target
+// steps disturb the outlet by ≤ 1.9 °F with it and up to 5.5 °F without.
+// false = straight µs lerp between SERVO_*_MAX_US and SERVO_*_MIN_US.
+constexpr bool VALVE_LUT_ENABLED = false;
+constexpr size_t VALVE_LUT_POINTS = 11;
+constexpr uint16_t VALVE_HOT_LUT_US[VALVE_LUT_POINTS] = {2035, 1968, 1900, 1833, 1765, 1698, 1630, 1563, 1495, 1428, 1360};
+constexpr uint16_t VALVE_COLD_LUT_US[VALVE_LUT_POINTS] = {2032, 1960, 1888, 1816, 1744, 1672, 1600, 1528, 1456, 1384, 1312};
+
+// Servo PWM: both valves on one LEDC timer, driven through the ESP-IDF LEDC
+// driver. Duty is written only when it changes; both update requests go out in
+// one critical section, so both channels normally latch at the same period
+// start (valve_mix.cpp writePulses()). false (or LEDC setup failure) = ESP32Servo.
+constexpr bool SERVO_LEDC_DIRECT = true;
+constexpr uint32_t SERVO_PWM_HZ = 50;          // Servo frame rate
+constexpr uint8_t SERVO_LEDC_RES_BITS = 16;    // Duty resolution (16 bits @ 50 Hz ≈ 0.31 µs per count)
+constexpr uint8_t SERVO_LEDC_TIMER = 0;        // LEDC timer shared by both channels
+constexpr uint8_t SERVO_LEDC_CH_HOT = 0;       // LEDC channel, hot valve
+constexpr uint8_t SERVO_LEDC_CH_COLD = 1;      // LEDC channel, cold valve
+
+// Hold: once both pulse widths have stayed within SERVO_HOLD_BAND_US for
+// SERVO_HOLD_AFTER_MS, PWM stops and the valves hold by gear/stem friction
+// (no stall current, no motor heating). A larger move, valveMixCloseAll()
+// (fault, E-stop, stop) drives them again in the same call.
+constexpr bool SERVO_HOLD_ENABLED = true;
+constexpr unsigned SERVO_HOLD_AFTER_MS = 5000;  // Steady time before the outputs stop
+constexpr float SERVO_HOLD_BAND_US = 3.0f;      // Moves smaller than this stay held
+
 // ====================================================
 // Flow Sensor (YF-S201)
 // ====================================================
@@ -61,6 +129,27 @@ constexpr float FLOW_K_PULSES_PER_ML = 7.5f;   // K-factor: pulses per mL of wat
 constexpr unsigned FLOW_WINDOW_MS = 500;       // Sampling window (ms)
 constexpr unsigned FLOW_FILTER_TAU_MS = 1000;  // EMA time constant for flow smoothing (ms)
 
+// Pulse counting backend. true = PCNT peripheral (hardware counter + glitch
+// filter, no interrupts); false or PCNT init failure = GPIO ISR per edge.
+constexpr bool FLOW_USE_PCNT = true;
+constexpr uint32_t FLOW_PCNT_GLITCH_NS = 10000;  // Ignore pulses shorter than this (max 12787 ns: 1023 APB cycles)
+constexpr int FLOW_PCNT_LIMIT = 32767;           // Counter wraps to 0 here; read at least every FLOW_PCNT_LIMIT pulses
+
+// Reciprocal (period) measurement, opt-in: a GPIO ISR timestamps each edge and
+// the rate comes from the newest inter-pulse periods, updated on every pulse
+// instead of every FLOW_WINDOW_MS. The trade-off is ISR load for low-flow
+// response: FLOW_USE_PCNT is ignored and every pulse interrupts (7.5 per mL,
+// ~1250/s at 10 L/min), while a flow start or stop at a trickle shows within
+// tens of ms instead of a 0.5 s window plus a 1 s EMA. The temperature loop
+// does not gain from it in shower_sim (settle, reciprocal vs PCNT: q 0.25
+// start 11.0 vs 10.6 s, hot step 25.4 vs 19.0 s; q 0.6 start 12.0 vs 5.3 s).
+// false = PCNT windowed counting, no interrupts.
+constexpr bool FLOW_RECIPROCAL = false;
+constexpr size_t FLOW_EDGE_RING = 16;               // Edge timestamps kept (power of two)
+constexpr unsigned FLOW_PERIOD_SPAN_MS = 100;       // Average the periods of the newest edges within this span
+constexpr unsigned FLOW_ZERO_TIMEOUT_MS = 250;      // No edge for this long = zero flow
+constexpr unsigned FLOW_RECIP_FILTER_TAU_MS = 250;  // EMA time constant for lpm / Hz in this mode (ms)
+
 // ====================================================
 // Emergency Stop Switch
 // ====================================================
@@ -82,8 +171,237 @@ constexpr float PID_OUTPUT_SLEW_FAST_PER_SEC = 3.0f; // Fast slew when far from
 constexpr float PID_SLEW_ERROR_THRESH_F = 3.0f;   // Error threshold to use fast slew
 constexpr bool PID_LOG_CSV = true;   // Enable CSV logging (time_ms,out_f,set_f,error_f,ratio)
 
+// --- Feedforward mixing (feedforward.h) ---
+// Base ratio recomputed every control step from the hot/cold line
+// temperatures and flow; the PID only trims around it (±FF_TRIM_LIMIT).
+// The trim follows a reference model (transport delay + outlet sensor lag)
+// instead of the raw setpoint, so it does not fight the feedforward on a
+// setpoint step. false = legacy one-shot initial mixing, then full-range PID.
+constexpr bool FF_ENABLED = true;
+constexpr float FF_TRIM_LIMIT = 0.30f;       // PID trim authority (± ratio)
+constexpr float FF_REF_TAU_S = 2.0f;         // Outlet sensor lag in the trim's reference model
+constexpr float FF_OUTLET_PIPE_L = 0.02f;    // Mixing tee → outlet sensor volume (transport delay = V / flow)
+constexpr float FF_LINE_TAU_S = 2.0f;        // Extra smoothing of hot/cold line temps (DS18B20 LSB jitter)
+constexpr float FF_LINE_LEAD_S = 4.0f;       // Lead on line temps: cancels this much of the sensor/fitting lag
+constexpr float FF_MIN_SPAN_F = 5.0f;        // Hold the last base ratio if hot - cold is smaller
+constexpr float FF_VALVE_DEAD_FRAC = 0.05f;  // Valve curve: stem travel before the port opens (0–1)
+constexpr float FF_VALVE_FULL_FRAC = 0.80f;  // Valve curve: stem travel where the port is fully open
+constexpr float FF_PIPE_LOSS_LPM = 0.01f;    // Outlet pipe loss: T_out = amb + (T_mix - amb)·exp(-k / flow)
+constexpr float FF_AMBIENT_F = 72.0f;        // Ambient temperature for the pipe-loss term
+constexpr float FF_MIN_FLOW_LPM = 0.10f;     // Flow floor for the loss term (no/low flow)
+
+// --- Outlet estimator (outlet_estimator.h) ---
+// Two-state Kalman filter: outlet sensor body temperature + model bias.
+// Predicts the water at the sensor from the commanded ratio, line
+// temperatures and flow (through the feedforward model and the pipe
+// transport delay) and corrects it with each raw outlet reading. With
+// EST_ENABLED the PID acts on the estimate instead of the EMA-filtered reading
+// once one pipe volume has flowed since the model (re)started.
+// Off by default: in shower_sim it only pays off for a supply disturbance at
+// low flow (q 0.25 hot step settles in 13 s instead of 25 s). Everywhere else
+// it is slower: q 0.6 startup 8.4 → 11.7 s and setpoint steps 2.6 → 5.7 s,
+// q 0.25 startup 18 → 28 s. The gains cannot be raised to use the lead
+// (they oscillate at 1.5x). With false the estimate is still computed
+// (TemperatureReading::estimateF) but does not drive the loop.
+constexpr bool EST_ENABLED = false;
+constexpr float EST_SENSOR_TAU_S = 2.0f;         // Outlet DS18B20 + fitting lag
+constexpr float EST_SENSOR_NOISE_F2S = 0.02f;    // Process noise on the sensor state (°F²/s)
+constexpr float EST_BIAS_NOISE_F2S = 0.01f;      // Process noise on the model bias (°F²/s)
+constexpr float EST_MEAS_NOISE_F = 0.05f;        // Sensor noise on top of quantization (1-sigma, °F)
+constexpr float EST_INIT_BIAS_STD_F = 5.0f;      // Bias uncertainty when (re)started
+constexpr float EST_REF_TAU_S = 0.3f;            // Trim reference lag when acting on the estimate
+
+// --- Backlash compensation (backlash_comp.h) ---
+// Servo + stem play as a fraction of full opening, learned online: when the
+// ratio rests, the settled outlet is turned back into the ratio actually
+// delivered (feedforward model). A rest after moving up minus one after moving
+// down is the play not yet covered. valve_mix adds half the estimate to each
+// valve in that valve's direction of motion.
+constexpr bool BACKLASH_COMP_ENABLED = true;
+constexpr float BACKLASH_INIT_RATIO = 0.0f;        // Width estimate at boot
+constexpr float BACKLASH_MAX_RATIO = 0.06f;        // Width estimate ceiling
+constexpr float BACKLASH_REVERSAL_EPS = 0.01f;     // Ratio move that counts as motion / a reversal
+constexpr unsigned BACKLASH_SETTLE_MS = 6000;      // Outlet settling after a move (pipe transport is added)
+constexpr uint32_t BACKLASH_REST_MIN_SAMPLES = 10; // Settled samples for a rest to count
+constexpr uint32_t BACKLASH_PAIR_MAX_MS = 120000;  // Up/down rests further apart are not paired
+constexpr float BACKLASH_PAIR_RATIO = 0.05f;       // ... nor rests at ratios further apart than this
+constexpr float BACKLASH_RATIO_MARGIN = 0.05f;     // No rests near the ends (a valve at its stop)
+constexpr float BACKLASH_GAIN = 0.5f;              // Weight of each up/down pair in the estimate
+
+// --- Flow control (flow_control.h) ---
+// Second output: with a flow target from the UI, both valve openings are
+// scaled by a common total (applyMixFlow) while the ratio keeps the hot
+// share. The total integrates the flow error, normalized by the present
+// opening/flow (flow grows less than linearly with opening behind the outlet
+// restriction). A target change rescales the opening at once. The loop is
+// far faster than the temperature loop, and the feedforward/estimator use the
+// measured flow, so neither output disturbs the other.
+constexpr bool FLOW_CTRL_ENABLED = true;
+constexpr float FLOW_CTRL_TI_S = 1.0f;            // Integral time (relative opening per relative error)
+constexpr float FLOW_CTRL_DEADBAND_FRAC = 0.02f;  // Hold the opening within ±2 % of the target
+constexpr float FLOW_OPEN_MIN = 0.15f;            // Smallest total opening while running
+constexpr float FLOW_OPEN_MAX = 1.0f;             // Full opening (also the value without a target)
+constexpr float FLOW_OPEN_SLEW_PER_SEC = 1.0f;    // Total opening slew (both valves move in proportion)
+
+// --- Sensor health (sensor_health.h) ---
+// Rolling statistics per sensor over the last HEALTH_WINDOW_MS, or the last
+// HEALTH_WINDOW_SAMPLES samples if those span less (fast flow updates).
+constexpr unsigned HEALTH_WINDOW_MS = 5000;      // Statistics window
+constexpr size_t HEALTH_WINDOW_SAMPLES = 64;     // Ring per sensor (power of two; outlet at 10 Hz = 50)
+
+// --- Gain scheduling (gain_schedule.h) ---
+// Kp/Ki/Kd bilinearly interpolated from filtered flow × setpoint; clamped
+// at the table edges. Transport delay grows as 1/flow, so low flow needs
+// lower gains; mid-range setpoints (both valves part-open) have the
+// steepest valve curve. false = fixed PID_KP/PID_KI/PID_KD.
+// Settling is NOT constant across flow, and no table makes it so: the outlet
+// pipe's transport delay (FF_OUTLET_PIPE_L / flow: 6 s at 0.2 L/min, 1.5 s
+// at 0.8) is a floor the trim cannot beat. In shower_sim with the feedforward
+// on, 5-10 °F setpoint steps settle within ~0.5 s of that floor at every
+// flow (0.2 L/min: 6.2-6.4 s, 0.8: 2.0-2.1 s). With the FF valve/loss
+// constants deliberately off (dead 0.10, full 0.70, loss 0.02) the integral
+// has model error to remove, and 10 °F steps take 12.7-13.3 s at 0.2 L/min
+// vs 4.0-4.5 s at 0.8. Lower gains trade flow-step disturbance rejection for
+// little gain here (0.3x: flow steps take 35-46 s to settle).
+constexpr bool GAIN_SCHED_ENABLED = true;
+constexpr float GAIN_SCHED_FLOW_TAU_S = 3.0f;  // Extra smoothing of FlowReading.lpm before lookup
+constexpr size_t GAIN_SCHED_FLOW_POINTS = 4;
+constexpr size_t GAIN_SCHED_SET_POINTS = 2;
+constexpr float GAIN_SCHED_FLOW_LPM[GAIN_SCHED_FLOW_POINTS] = {0.20f, 0.30f, 0.45f, 0.80f};
+constexpr float GAIN_SCHED_SETPOINT_F[GAIN_SCHED_SET_POINTS] = {90.0f, 105.0f};
+constexpr float GAIN_SCHED_KP[GAIN_SCHED_SET_POINTS][GAIN_SCHED_FLOW_POINTS] = {
+    {0.0042f, 0.0056f, 0.0056f, 0.0056f},  // 90 °F
+    {0.0056f, 0.0070f, 0.0070f, 0.0070f},  // 105 °F
+};
+constexpr float GAIN_SCHED_KI[GAIN_SCHED_SET_POINTS][GAIN_SCHED_FLOW_POINTS] = {
+    {0.0011f, 0.0011f, 0.0021f, 0.0021f},
+    {0.0011f, 0.0014f, 0.0021f, 0.0021f},
+};
+constexpr float GAIN_SCHED_KD[GAIN_SCHED_SET_POINTS][GAIN_SCHED_FLOW_POINTS] = {
+    {0.0f, 0.0f, 0.0f, 0.0f},
+    {0.0f, 0.0f, 0.0f, 0.0f},
+};
+
 // ====================================================
 // Safety / Communication
 // ====================================================
 
-constexpr unsigned COMM_LINK_TIMEOUT_MS = 2000;  // Link-loss timeout (ms)
+constexpr unsigned COMM_LINK_TIMEOUT_MS = 2000;   // Link-loss timeout (ms)
+constexpr unsigned COMM_TELEMETRY_PUSH_MS = 200;  // Telemetry frame (v2) push interval to the UI (ms; 5 Hz, 0 = off)
+
+// --- Receive path (communication.h) ---
+// The ESP-NOW receive callback only copies each frame into a ring slot; the
+// comm task parses it and sends the ACK. The task runs above the log drainer
+// on the Wi-Fi core and sleeps until a frame arrives.
+constexpr unsigned COMM_RX_QUEUE_LEN = 8;      // Ring slots (power of two); frames beyond are dropped and counted
+constexpr unsigned COMM_RX_SLOT_BYTES = 48;    // Bytes kept per frame (COMM_Payload and v2 frames fit)
+constexpr uint8_t COMM_TASK_CORE = 0;          // With the Wi-Fi task
+constexpr uint8_t COMM_TASK_PRIORITY = 3;
+constexpr unsigned COMM_TASK_STACK_BYTES = 3072;
+
+// --- Fault evaluation (faults.h rule table) ---
+constexpr float FAULT_TEMP_HYST_F = 2.0f;         // Bounds faults clear this far inside the limits
+constexpr float FAULT_RAPID_HYST_F = 2.0f;        // Swing must drop this far below TEMP_RAPID_DELTA_F
+constexpr unsigned FAULT_ESTOP_CLEAR_MS = 100;    // Switch released this long before clearing
+// A bad read leaves a reading invalid until the next good one (one sample
+// period); a failed Convert T start is retried one conversion later, so up to
+// two periods. The sensor faults set after three periods of the slowest
+// schedule of that sensor, so a single glitch never closes the valves.
+constexpr unsigned FAULT_OUTLET_SENSOR_SET_MS = 3 * TEMP_OUTLET_MAX_PERIOD_MS;  // 1125 ms
+constexpr unsigned FAULT_LINE_SENSOR_SET_MS = 3 * TEMP_LINE_MAX_PERIOD_MS;      // 2250 ms
+constexpr unsigned FAULT_SENSOR_CLEAR_MS = 1000;  // Valid this long before clearing
+// The sensor rules read the sensor_health table. Besides not ok, a sensor is
+// at fault when its last fresh sample is older than two of its slowest periods
+// (still valid but no longer updating), or when FAULT_SENSOR_ERROR_LIMIT of
+// its reads failed (no temperature after the CRC retry) within the window.
+// Each failed read counts once, so a single glitch never closes the valves;
+// a short invalid spell ends before the set delay, so without the count a
+// flaky sensor or bus would never latch.
+constexpr unsigned FAULT_OUTLET_SENSOR_STALE_MS = 2 * TEMP_OUTLET_MAX_PERIOD_MS;  // 750 ms
+constexpr unsigned FAULT_LINE_SENSOR_STALE_MS = 2 * TEMP_LINE_MAX_PERIOD_MS;      // 1500 ms
+constexpr unsigned FAULT_SENSOR_ERROR_LIMIT = 3;                // Errors within FAULT_SENSOR_ERROR_WINDOW_MS
+constexpr unsigned FAULT_SENSOR_ERROR_WINDOW_MS = HEALTH_WINDOW_MS;
+constexpr unsigned FAULT_BOUNDS_SET_MS = 0;       // Out-of-bounds trips immediately
+constexpr unsigned FAULT_BOUNDS_CLEAR_MS = 1000;
+constexpr unsigned FAULT_RAPID_CLEAR_MS = 2000;   // Calm this long after a jump before clearing
+
+// ====================================================
+// Superloop Scheduling
+// ====================================================
+
+// true = loop() sleeps on a task notification until the next DS18B20 sample is
+// due, a UI packet arrives or the E-stop changes; false = fixed delay(12) polling
+constexpr bool CONTROL_EVENT_DRIVEN = true;
+constexpr unsigned CONTROL_IDLE_MAX_MS = 20;  // Longest sleep (link/flow housekeeping, 50 Hz telemetry)
+
+// ====================================================
+// Execution Pipeline (FreeRTOS tasks)
+// ====================================================
+
+// false = classic superloop in loop(); true = pinned sensor/control/comm/log tasks
+constexpr bool CONTROL_PIPELINE_ENABLED = false;
+
+// Task periods (ms); the control task runs at a fixed rate via vTaskDelayUntil.
+// The sensor task instead wakes when temperatureNextSampleMs() says a read is
+// due, at most PIPE_SENSOR_PERIOD_MS apart (flow, E-stop); each wake-up reads
+// one scratchpad (TEMP_MAX_READS_PER_SERVICE, ~6.5 ms worst case), so the
+// period only has to cover one read, not the ~21 ms three-sensor batch. A
+// short control period then bounds the wait for the next step: 3 ms keeps
+// sample-to-actuation latency under the delay(12) superloop (pipeline_sim:
+// mean 7.7 ms / max 10.2 ms vs 9.5 / 10.7 ms) for ~6% of core 1.
+constexpr unsigned PIPE_SENSOR_PERIOD_MS = 10;
+constexpr unsigned PIPE_CONTROL_PERIOD_MS = 3;
+constexpr unsigned PIPE_COMM_PERIOD_MS = 10;
+constexpr unsigned PIPE_LOG_PERIOD_MS = 20;
+
+// Core affinity (WiFi/ESP-NOW runs on core 0, Arduino loop on core 1)
+constexpr uint8_t PIPE_SENSOR_CORE = 1;
+constexpr uint8_t PIPE_CONTROL_CORE = 1;
+constexpr uint8_t PIPE_COMM_CORE = 0;
+constexpr uint8_t PIPE_LOG_CORE = 0;
+
+// Task priorities (higher preempts lower on the same core)
+constexpr uint8_t PIPE_SENSOR_PRIORITY = 4;
+constexpr uint8_t PIPE_CONTROL_PRIORITY = 5;
+constexpr uint8_t PIPE_COMM_PRIORITY = 3;
+constexpr uint8_t PIPE_LOG_PRIORITY = 1;
+
+// Bounded queue depths between stages (oldest data is kept, new data dropped when full)
+constexpr unsigned PIPE_SENSOR_QUEUE_LEN = 4;
+constexpr unsigned PIPE_CMD_QUEUE_LEN = 4;
+constexpr unsigned PIPE_TASK_STACK_BYTES = 4096;
+
+// ====================================================
+// Log ring (control path → low-priority drainer)
+// ====================================================
+
+// One record per TELEMETRY_PERIOD_MS-gated push: 64 hold ~1.3 s at the
+// event-driven ≈48 Hz, ~0.8 s at the pipeline's ≈83 Hz, before the drainer
+// (every LOG_DRAIN_PERIOD_MS) must catch up. shower_sim high-water: 2.
+constexpr unsigned LOG_RING_CAPACITY = 64;     // Records (power of two)
+constexpr unsigned LOG_DRAIN_PERIOD_MS = 10;   // Drainer wake-up period (superloop mode)
+constexpr uint8_t LOG_DRAIN_CORE = 0;          // Off the control core
+constexpr uint8_t LOG_DRAIN_PRIORITY = 1;      // Lowest application priority
+constexpr unsigned LOG_DRAIN_STACK_BYTES = 3072;
+
+// ====================================================
+// Profiler (per-stage CPU cycle histograms)
+// ====================================================
+
+constexpr bool PROFILER_ENABLED = true;         // Record cycle counts for each loop stage
+constexpr char PROFILER_DUMP_KEY = 'p';         // Serial key: dump histogram summary
+constexpr char PROFILER_RESET_KEY = 'r';        // Serial key: clear histograms
+constexpr unsigned PROFILER_LOOP_BUDGET_US = 12000;  // Budget reported against the LOOP stage
+
+// ====================================================
+// Telemetry (logger output format)
+// ====================================================
+
+// true = COBS-framed binary frames (telemetry.h; decode with firmware/host telemetry_decode)
+// false = legacy text CSV at LOGGER_PERIOD_MS. Both require PID_LOG_CSV.
+constexpr bool TELEMETRY_BINARY = true;
+// Minimum spacing of log records / binary frames. A record goes out on the
+// first control pass after this has elapsed, so the rate follows the loop:
+// ≈48 Hz event-driven (a pass at least every CONTROL_IDLE_MAX_MS; shower_sim
+// 14475 records in 300 s), ≈83 Hz in the pipeline (every 4th 3 ms step).
+constexpr unsigned TELEMETRY_PERIOD_MS = 10;
@@ -23,52 +23,88 @@
 #include <stdio.h>
 
 #include "../common/config.h"
+#include "backlash_comp.h"
 #include "communication.h"
 #include "config.h"
+#include "faults.h"
+#include "feedforward.h"
+#include "flow_control.h"
 #include "flow_sensor.h"
+#include "gain_schedule.h"
+#include "outlet_estimator.h"
+#include "sensor_health.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "log_ring.h"
 #include "pid.h"
+#include "pipeline.h"
+#include "profiler.h"
+#include "telemetry.h"
 #include "temperature.h"
 #include "valve_mix.h"
 
 static constexpr uint16_t LOOP_DELAY_MS = 12;
 static constexpr uint16_t LOGGER_PERIOD_MS = 100;
+static constexpr int LOGGER_CSV_LINE_MAX = 96;  // longest CSV row incl. newline
 static PID pi(PID_KP, PID_KI, PID_KD, PID_OUT_MIN, PID_OUT_MAX);
 
 static float setpointF = SETPOINT_DEFAULT_F;
+static float flowTargetLpm = FLOW_TARGET_DEFAULT_LPM;  // 0 = no flow target
 static bool runFlag = false;
 static uint32_t lastOutletSampleMs = 0;
 static bool loggerHeaderPrinted = false;
 static float lastRatio = 0.0f;
 static float lastU = 0.0f;
-static float lastHotRapidF = 0.0f;
-static float lastColdRapidF = 0.0f;
-static uint32_t lastHotRapidMs = 0;
-static uint32_t lastColdRapidMs = 0;
-static void logCsvIfDue(unsigned long nowMs, const TemperatureReading& outlet, bool linkOk);
+static void logCsvIfDue(unsigned long nowMs, const SensorFrame& frame, bool linkOk);
+static void writeLogRecord(const LogRecord& rec);
+static bool logSinkReady();
 static bool estopPressed();
-
-enum class FaultCode : uint8_t {
-  None = 0,
-  EStop,
-  LinkLoss,
-  OutletSensorFault,
-  OutletOutOfBounds,
-  HotSensorFault,
-  ColdSensorFault,
-  HotOutOfBounds,
-  ColdOutOfBounds,
-  HotRapidChange,
-  ColdRapidChange,
-};
+static bool senseInputs(SensorFrame& frame);
+static bool pollCommand(CommCommand& cmd);
+static void controlStep(const SensorFrame& frame, const CommCommand* cmd);
+static void serviceConsole();
+static void waitForWork();
 
 static FaultCode activeFault = FaultCode::None;
 
-static void enterSafeState(const char* reason) {
-  if (reason != nullptr) {
-    Serial.println(reason);
+// Event-driven superloop: loop() blocks on its task notification
+static TaskHandle_t s_loopTask = nullptr;
+
+static void wakeLoop() {
+  if (s_loopTask) xTaskNotifyGive(s_loopTask);
+}
+
+static void IRAM_ATTR onEstopEdge() {
+  BaseType_t woken = pdFALSE;
+  if (s_loopTask) vTaskNotifyGiveFromISR(s_loopTask, &woken);
+  if (woken) portYIELD_FROM_ISR();
+}
+
+// Print one line per fault transition (bounded: at most one per rule per pass)
+static void reportFaultChanges(const FaultStatus& faults) {
+  const uint32_t changed = faults.raised | faults.cleared;
+  if (changed == 0) return;
+
+  char msg[96];
+  for (uint8_t code = 1; code < static_cast<uint8_t>(FaultCode::COUNT); ++code) {
+    const FaultCode fc = static_cast<FaultCode>(code);
+    if (!(changed & faultBit(fc))) continue;
+    faultFormatMessage(fc, (faults.raised & faultBit(fc)) != 0, msg, sizeof(msg));
+    Serial.println(msg);
   }
-  valveMixCloseAll();
+}
+
+// Valves are closed once on entry; reassert (new fault, E-stop) closes and
+// drives them again even if they are already closed and held
+static bool s_valvesSafe = false;
+
+static void enterSafeState(bool reassert) {
+  if (!s_valvesSafe || reassert) valveMixCloseAll();
+  s_valvesSafe = true;
   pi.reset();
+  feedforwardReset();
+  backlashCompReset();
+  flowControlReset();
   lastOutletSampleMs = 0;
 }
 
@@ -91,28 +127,220 @@ void setup() {
 
   valveMixInit();
   valveMixCloseAll();
+  faultInit();
+  gainScheduleInit();
+  feedforwardInit();
+  outletEstimatorInit();
+  backlashCompInit();
+  flowControlInit();
+  sensorHealthInit();
+  if (FF_ENABLED) {
+    pi.setOutputLimits(-FF_TRIM_LIMIT, FF_TRIM_LIMIT);  // PID becomes a trim around the feedforward
+  }
+
+  if (CONTROL_PIPELINE_ENABLED) {
+    const PipelineHooks hooks{
+        .sense = senseInputs,
+        .comm = pollCommand,
+        .control = controlStep,
+        .log = writeLogRecord,
+        .logReady = logSinkReady,
+        .senseDueMs = temperatureNextSampleMs,
+    };
+    pipelineInit(hooks);
+    if (!pipelineStart()) {
+      Serial.println("PIPE ERROR: task start failed");
+      while (1) delay(1000);
+    }
+  } else {
+    if (PID_LOG_CSV) {
+      const LogSink sink{.ready = logSinkReady, .write = writeLogRecord};
+      if (!logRingStartDrainer(sink)) {
+        Serial.println("LOG ERROR: drainer task start failed");
+      }
+    }
+    if (CONTROL_EVENT_DRIVEN) {
+      s_loopTask = xTaskGetCurrentTaskHandle();
+      commSetRxHook(wakeLoop);
+      attachInterrupt(digitalPinToInterrupt(ESTOP_PIN), onEstopEdge, CHANGE);
+    }
+  }
 }
 
 void loop() {
-  (void) temperatureService();
-  (void) flowSensorUpdate();
+  // Pipeline mode: the pinned tasks do all the work
+  if (CONTROL_PIPELINE_ENABLED) {
+    serviceConsole();
+    delay(1000);
+    return;
+  }
+
+  // Wake-ups pending so far are serviced by this pass
+  if (CONTROL_EVENT_DRIVEN) (void) ulTaskNotifyTake(pdTRUE, 0);
+
+  {
+    ProfileScope prof(ProfStage::LOOP);
+    SensorFrame frame{};
+    (void) senseInputs(frame);
+
+    CommCommand cmd{};
+    const bool haveCmd = pollCommand(cmd);
+
+    controlStep(frame, haveCmd ? &cmd : nullptr);
+  }
+  serviceConsole();
+  waitForWork();
+}
+
+// Sleep until the next outlet sample is due (so the PID runs as soon as the
+// conversion is read), a UI packet or E-stop edge wakes us, or the idle cap.
+static void waitForWork() {
+  if (!CONTROL_EVENT_DRIVEN) {
+    delay(LOOP_DELAY_MS);
+    return;
+  }
+
+  const int32_t untilSampleMs = (int32_t) (temperatureNextSampleMs() - millis());
+  uint32_t waitMs = CONTROL_IDLE_MAX_MS;
+  if (untilSampleMs < (int32_t) waitMs) waitMs = untilSampleMs > 0 ? (uint32_t) untilSampleMs : 0;
+  if (waitMs > 0) (void) ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(waitMs));
+}
+
+// Single-key serial commands (profiler dump/reset)
+static void serviceConsole() {
+  if (!PROFILER_ENABLED) return;
+  while (Serial.available() > 0) {
+    const int c = Serial.read();
+    if (c == PROFILER_DUMP_KEY) {
+      profilerDump();
+      const LogRingStats st = logRingGetStats();
+      Serial.printf("# logring pushed %lu dropped %lu drained %lu high-water %lu/%u\n",
+                    (unsigned long) st.pushed,
+                    (unsigned long) st.dropped,
+                    (unsigned long) st.drained,
+                    (unsigned long) st.highWater,
+                    LOG_RING_CAPACITY);
+      const CommRxStats rx = commRxStats();
+      Serial.printf("# comm rx %lu dropped %lu processed %lu depth %lu high-water %lu/%u callback %lu/%lu us "
+                    "ack %lu fail %lu latency %lu/%lu us (mean/max)\n",
+                    (unsigned long) rx.frames,
+                    (unsigned long) rx.dropped,
+                    (unsigned long) rx.processed,
+                    (unsigned long) rx.depth,
+                    (unsigned long) rx.highWater,
+                    COMM_RX_QUEUE_LEN,
+                    (unsigned long) rx.callbackMeanUs,
+                    (unsigned long) rx.callbackMaxUs,
+                    (unsigned long) rx.acks,
+                    (unsigned long) rx.ackFails,
+                    (unsigned long) rx.ackLatencyMeanUs,
+                    (unsigned long) rx.ackLatencyMaxUs);
+      const LinkQualityStats link = commLinkQuality();
+      Serial.printf("# link ui->ctrl rssi %d dBm (mean %.1f, %d..%d) loss %.1f%% dup %.1f%% of last %u "
+                    "(total delivered %lu lost %lu dup %lu)\n",
+                    link.rssiLastDbm,
+                    link.rssiMeanDbm,
+                    link.rssiMinDbm,
+                    link.rssiMaxDbm,
+                    link.lossPct,
+                    link.duplicatePct,
+                    link.windowCount,
+                    (unsigned long) link.delivered,
+                    (unsigned long) link.lost,
+                    (unsigned long) link.duplicates);
+      const TempBusStats& bus = temperatureBusStats();
+      Serial.printf("# onewire reads %lu crc-errors %lu no-response %lu service-read %lu us (%u sensors) max %lu us\n",
+                    (unsigned long) bus.reads,
+                    (unsigned long) bus.crcErrors,
+                    (unsigned long) bus.noResponse,
+                    (unsigned long) bus.lastServiceReadUs,
+                    bus.lastServiceReads,
+                    (unsigned long) bus.maxServiceReadUs);
+      const SensorHealthReport& health = sensorHealthGet();
+      for (size_t i = 0; i < HEALTH_CHANNEL_COUNT; ++i) {
+        const SensorHealth& h = health.channel[i];
+        Serial.printf("# health %s ok %d n %u mean %.2f sd %.3f slope %.3f/s range %.2f..%.2f age %lu ms "
+                      "interval %.1f±%.1f ms crc %lu no-response %lu failed %lu dropouts %lu\n",
+                      sensorHealthName(static_cast<HealthChannel>(i)),
+                      h.ok ? 1 : 0,
+                      h.windowSamples,
+                      h.mean,
+                      h.stddev,
+                      h.slopePerS,
+                      h.minValue,
+                      h.maxValue,
+                      (unsigned long) h.ageMs,
+                      h.intervalMs,
+                      h.intervalJitterMs,
+                      (unsigned long) h.crcErrors,
+                      (unsigned long) h.noResponse,
+                      (unsigned long) h.failedReads,
+                      (unsigned long) h.dropouts);
+      }
+    } else if (c == PROFILER_RESET_KEY) {
+      profilerReset();
+      logRingResetStats();
+      Serial.println("# profiler reset");
+    }
+  }
+}
+
+// Sample every input the control step needs into a self-contained frame
+static bool senseInputs(SensorFrame& frame) {
+  bool tempFresh;
+  bool flowFresh;
+  {
+    ProfileScope prof(ProfStage::TEMP);
+    tempFresh = temperatureService();
+  }
+  {
+    ProfileScope prof(ProfStage::FLOW);
+    flowFresh = flowSensorUpdate();
+  }
+
+  frame.hot = temperatureGetReading(TempSensor::HOT);
+  frame.cold = temperatureGetReading(TempSensor::COLD);
+  frame.outlet = temperatureGetReading(TempSensor::OUTLET);
+  frame.flow = flowSensorGet();
+  frame.estop = estopPressed();
 
+  static bool lastEstop = false;
+  const bool estopChanged = (frame.estop != lastEstop);
+  lastEstop = frame.estop;
+  return tempFresh || flowFresh || frame.estop || estopChanged;
+}
+
+static bool pollCommand(CommCommand& cmd) {
+  ProfileScope prof(ProfStage::COMM);
+  return commPollCommand(cmd);
+}
+
+// One pass of command handling, fault detection and PID actuation
+static void controlStep(const SensorFrame& frame, const CommCommand* cmd) {
   const unsigned long nowMs = millis();
   const unsigned long lastRxMs = commLastRxMs();
   const bool linkOk =
       (lastRxMs != 0) && ((unsigned long) (nowMs - lastRxMs) <= COMM_LINK_TIMEOUT_MS);
-  const FlowReading flow = flowSensorGet();
-
-  CommCommand cmd{};
-  if (commPollCommand(cmd)) {
-    if (cmd.lastOk) {
-      setpointF = constrain(cmd.setpointF, SETPOINT_MIN_F, SETPOINT_MAX_F);
-      runFlag = cmd.runFlag;
+  const FlowReading& flow = frame.flow;
+  valveMixService();
+
+  if (cmd != nullptr) {
+    if (cmd->lastOk) {
+      const float newSetpointF = constrain(cmd->setpointF, SETPOINT_MIN_F, SETPOINT_MAX_F);
+      if (newSetpointF != setpointF || (cmd->runFlag && !runFlag)) {
+        temperatureMarkTransient(TempSensor::OUTLET);  // fast samples for the step response
+      }
+      setpointF = newSetpointF;
+      flowTargetLpm = (cmd->flowTargetLpm > 0.0f)
+                          ? constrain(cmd->flowTargetLpm, FLOW_TARGET_MIN_LPM, FLOW_TARGET_MAX_LPM)
+                          : 0.0f;
+      runFlag = cmd->runFlag;
       if (!PID_LOG_CSV) {
-        Serial.printf("CTRL<-UI setpoint=%.1fF run=%s seq=%lu\n",
+        Serial.printf("CTRL<-UI setpoint=%.1fF flow=%.2f L/min run=%s seq=%lu\n",
                       setpointF,
+                      flowTargetLpm,
                       runFlag ? "ON" : "OFF",
-                      (unsigned long) cmd.lastSeq);
+                      (unsigned long) cmd->lastSeq);
       }
     } else {
       if (!PID_LOG_CSV) {
@@ -121,130 +349,52 @@ void loop() {
     }
   }
 
-  FaultCode detectedFault = FaultCode::None;
-  const char* faultMsg = nullptr;
-  char boundsMsg[96];
-  char hotBoundsMsg[96];
-  char coldBoundsMsg[96];
-  char rapidMsg[96];
-
-  const bool estop = estopPressed();
-  const TemperatureReading& outlet = temperatureGetReading(TempSensor::OUTLET);
-  const TemperatureReading& hot = temperatureGetReading(TempSensor::HOT);
-  const TemperatureReading& cold = temperatureGetReading(TempSensor::COLD);
-  commUpdateOutletTemp(outlet.filteredF, outlet.present && outlet.valid, flow.lpm, flow.sampleMs != 0);
-  if (estop) {
-    detectedFault = FaultCode::EStop;
-    faultMsg = "E-STOP: switch active → closing valves";
-    runFlag = false;
-  } else {
-    if (runFlag &&
-        (lastRxMs == 0 || (unsigned long) (nowMs - lastRxMs) > COMM_LINK_TIMEOUT_MS)) {
-      detectedFault = FaultCode::LinkLoss;
-      faultMsg = "LINK ERROR: No UI command for 2s → closing valves";
-      runFlag = false;
-      commMarkLinkLost();
-    }
-
-    if (detectedFault == FaultCode::None && runFlag) {
-      if (!hot.present || !hot.valid) {
-        detectedFault = FaultCode::HotSensorFault;
-        faultMsg = "TEMP ERROR: Hot sensor fault → closing valves";
-        runFlag = false;
-      } else if (!cold.present || !cold.valid) {
-        detectedFault = FaultCode::ColdSensorFault;
-        faultMsg = "TEMP ERROR: Cold sensor fault → closing valves";
-        runFlag = false;
-      } else if (hot.filteredF < HOT_MIN_PLAUSIBLE_F || hot.filteredF > HOT_MAX_PLAUSIBLE_F) {
-        detectedFault = FaultCode::HotOutOfBounds;
-        snprintf(hotBoundsMsg,
-                 sizeof(hotBoundsMsg),
-                 "TEMP ERROR: Hot %.1fF out of bounds (%.0f-%.0fF) → closing valves",
-                 hot.filteredF,
-                 HOT_MIN_PLAUSIBLE_F,
-                 HOT_MAX_PLAUSIBLE_F);
-        faultMsg = hotBoundsMsg;
-        runFlag = false;
-      } else if (cold.filteredF < COLD_MIN_PLAUSIBLE_F || cold.filteredF > COLD_MAX_PLAUSIBLE_F) {
-        detectedFault = FaultCode::ColdOutOfBounds;
-        snprintf(coldBoundsMsg,
-                 sizeof(coldBoundsMsg),
-                 "TEMP ERROR: Cold %.1fF out of bounds (%.0f-%.0fF) → closing valves",
-                 cold.filteredF,
-                 COLD_MIN_PLAUSIBLE_F,
-                 COLD_MAX_PLAUSIBLE_F);
-        faultMsg = coldBoundsMsg;
-        runFlag = false;
-      } else {
-        // Rapid change detection for hot/cold lines
-        if (hot.sampleMs != 0 && lastHotRapidMs != 0) {
-          const uint32_t dtMs = hot.sampleMs - lastHotRapidMs;
-          if (dtMs > 0 && dtMs <= TEMP_RAPID_WINDOW_MS &&
-              fabs(hot.filteredF - lastHotRapidF) >= TEMP_RAPID_DELTA_F) {
-            detectedFault = FaultCode::HotRapidChange;
-            snprintf(rapidMsg,
-                     sizeof(rapidMsg),
-                     "TEMP ERROR: Hot jump %.1fF in %lums → closing valves",
-                     fabs(hot.filteredF - lastHotRapidF),
-                     (unsigned long) dtMs);
-            faultMsg = rapidMsg;
-            runFlag = false;
-          }
-        }
-
-        if (detectedFault == FaultCode::None && cold.sampleMs != 0 && lastColdRapidMs != 0) {
-          const uint32_t dtMs = cold.sampleMs - lastColdRapidMs;
-          if (dtMs > 0 && dtMs <= TEMP_RAPID_WINDOW_MS &&
-              fabs(cold.filteredF - lastColdRapidF) >= TEMP_RAPID_DELTA_F) {
-            detectedFault = FaultCode::ColdRapidChange;
-            snprintf(rapidMsg,
-                     sizeof(rapidMsg),
-                     "TEMP ERROR: Cold jump %.1fF in %lums → closing valves",
-                     fabs(cold.filteredF - lastColdRapidF),
-                     (unsigned long) dtMs);
-            faultMsg = rapidMsg;
-            runFlag = false;
-          }
-        }
-
-        if (detectedFault == FaultCode::None) {
-          if (!outlet.present || !outlet.valid) {
-            detectedFault = FaultCode::OutletSensorFault;
-            faultMsg = "TEMP ERROR: Outlet sensor fault → closing valves";
-            runFlag = false;
-          } else if ((outlet.filteredF < OUTLET_MIN_PLAUSIBLE_F) ||
-                     (outlet.filteredF > OUTLET_MAX_PLAUSIBLE_F)) {
-            detectedFault = FaultCode::OutletOutOfBounds;
-            snprintf(boundsMsg,
-                     sizeof(boundsMsg),
-                     "TEMP ERROR: Outlet %.1fF out of bounds (%.0f-%.0fF) → closing valves",
-                     outlet.filteredF,
-                     OUTLET_MIN_PLAUSIBLE_F,
-                     OUTLET_MAX_PLAUSIBLE_F);
-            faultMsg = boundsMsg;
-            runFlag = false;
-          }
-        }
-      }
-    }
-  }
-
-  if (detectedFault != FaultCode::None) {
-    if (activeFault != detectedFault || detectedFault == FaultCode::OutletOutOfBounds) {
-      enterSafeState(faultMsg);
-    } else {
-      enterSafeState(nullptr);
-    }
-    activeFault = detectedFault;
-    logCsvIfDue(nowMs, outlet, linkOk);
-    delay(LOOP_DELAY_MS);
+  const bool estop = frame.estop;
+  const TemperatureReading& hot = frame.hot;
+  const TemperatureReading& cold = frame.cold;
+  sensorHealthUpdate(nowMs, hot, cold, frame.outlet, flow);
+  TemperatureReading outlet = frame.outlet;
+  outletEstimatorUpdate(outlet, hot, cold, lastRatio, flow);
+
+  FaultInputs faultIn{};
+  faultIn.nowMs = nowMs;
+  faultIn.estop = estop;
+  faultIn.runRequested = runFlag;
+  faultIn.lastRxMs = lastRxMs;
+  faultIn.hot = hot;
+  faultIn.cold = cold;
+  faultIn.outlet = outlet;
+  faultIn.health = &sensorHealthGet();
+  const FaultStatus& faults = faultEvaluate(faultIn);
+  reportFaultChanges(faults);
+
+  if (faults.mask & FAULT_DROPS_RUN_MASK) runFlag = false;
+  if (faults.raised & faultBit(FaultCode::LinkLoss)) commMarkLinkLost();
+  activeFault = faults.primary;
+
+  CommTelemetry tel{};
+  tel.outletF = outlet.filteredF;
+  tel.hotF = hot.filteredF;
+  tel.coldF = cold.filteredF;
+  tel.ratio = lastRatio;
+  tel.flowLpm = flow.lpm;
+  tel.outletValid = outlet.present && outlet.valid;
+  tel.hotValid = hot.present && hot.valid;
+  tel.coldValid = cold.present && cold.valid;
+  tel.flowValid = flow.sampleMs != 0;
+  tel.faultMask = faults.mask;
+  tel.runFlag = runFlag;
+  commPublishTelemetry(tel, nowMs);
+
+  if (faults.mask != 0) {
+    enterSafeState(faults.raised != 0);
+    logCsvIfDue(nowMs, frame, linkOk);
     return;
   }
 
   if (!runFlag) {
-    activeFault = FaultCode::None;
-    enterSafeState(nullptr);
-    logCsvIfDue(nowMs, outlet, linkOk);
+    enterSafeState(false);
+    logCsvIfDue(nowMs, frame, linkOk);
     if (!PID_LOG_CSV) {
       Serial.printf("RUN=OFF | OUT=%.2fF | SET=%.2fF | link=%s | flow=%.2f L/min\n",
                     outlet.filteredF,
@@ -252,32 +402,24 @@ void loop() {
                     linkOk ? "OK" : "LOST",
                     flow.lpm);
     }
-    delay(LOOP_DELAY_MS);
     return;
   }
 
-  activeFault = FaultCode::None;
-  if (hot.sampleMs != 0) {
-    lastHotRapidF = hot.filteredF;
-    lastHotRapidMs = hot.sampleMs;
-  }
-  if (cold.sampleMs != 0) {
-    lastColdRapidF = cold.filteredF;
-    lastColdRapidMs = cold.sampleMs;
-  }
-  const float outletTempF = outlet.filteredF;
+  // Act on the model estimate (no sensor lag) while the estimator has one
+  const bool useEstimate = EST_ENABLED && !isnan(outlet.estimateStdF);
+  const float outletTempF = useEstimate ? outlet.estimateF : outlet.filteredF;
   const uint32_t sampleMs = outlet.sampleMs;
   if (sampleMs == 0 || sampleMs == lastOutletSampleMs) {
-    logCsvIfDue(nowMs, outlet, linkOk);
-    delay(LOOP_DELAY_MS);
+    logCsvIfDue(nowMs, frame, linkOk);
     return;
   }
 
-  // Initial mixing logic using cold and hot sensors
+  // Initial mixing logic using cold and hot sensors (legacy path; the
+  // feedforward replaces it)
   static bool initialMixingDone = false;
 
   // Only do initial mixing if not done and outlet is far from setpoint
-  if (!initialMixingDone && hot.present && cold.present && hot.valid && cold.valid) {
+  if (!FF_ENABLED && !initialMixingDone && hot.present && cold.present && hot.valid && cold.valid) {
     // Extra smoothing filter for initial mixing
     static float hotFiltered = 0.0f;
     static float coldFiltered = 0.0f;
@@ -293,7 +435,11 @@ void loop() {
     if (fabs(hotF - coldF) > 0.1f) {
       float initialRatio = (setpointF - coldF) / (hotF - coldF);
       initialRatio = constrain(initialRatio, 0.0f, 1.0f);
-      applyMixRatio(initialRatio);
+      {
+        ProfileScope prof(ProfStage::MIX);
+        applyMixRatio(initialRatio);
+      }
+      s_valvesSafe = false;
       lastRatio = initialRatio;
       if (!PID_LOG_CSV) {
         Serial.printf("Initial mixing (filtered): HOT=%.2fF, COLD=%.2fF, SET=%.2fF, ratio=%.2f\n", hotF, coldF, setpointF, initialRatio);
@@ -303,25 +449,39 @@ void loop() {
         initialMixingDone = true;
         pi.reset(); // Reset PID for clean start
       }
-      logCsvIfDue(sampleMs, outlet, linkOk);
-      delay(LOOP_DELAY_MS);
+      logCsvIfDue(sampleMs, frame, linkOk);
       return;
     }
   }
 
-  // PID control after initial mixing
+  // PID control after initial mixing (or trim around the feedforward)
   initialMixingDone = true; // fallback if sensors not present/valid
   const float dtSec = (lastOutletSampleMs == 0)
                           ? (TEMP_LOOP_DT_MS / 1000.0f)
                           : (sampleMs - lastOutletSampleMs) / 1000.0f;
   lastOutletSampleMs = sampleMs;
 
-  float errorF = setpointF - outletTempF;
+  // With feedforward a setpoint change is carried by the base ratio; the trim
+  // only corrects deviation from the outlet's expected response to it
+  const float refLagS = useEstimate ? EST_REF_TAU_S : FF_REF_TAU_S;
+  const float refF = FF_ENABLED ? feedforwardReferenceF(setpointF, outletTempF, flow.lpm, dtSec, refLagS) : setpointF;
+  float errorF = refF - outletTempF;
   if (fabs(errorF) < PID_ERROR_DEADBAND_F) {
     errorF = 0.0f; // Hold near setpoint to avoid hunting
   }
 
-  const float rawRatio = pi.update(errorF, dtSec);
+  float rawRatio;
+  {
+    ProfileScope prof(ProfStage::PID);
+    if (GAIN_SCHED_ENABLED) {
+      const GainSet& gains = gainScheduleUpdate(flow.lpm, flow.sampleMs != 0, setpointF, dtSec);
+      pi.setGainsBumpless(gains.kp, gains.ki, gains.kd);
+    }
+    rawRatio = pi.update(errorF, dtSec);
+    if (FF_ENABLED) {
+      rawRatio += feedforwardUpdate(hot, cold, setpointF, flow.lpm, flow.sampleMs != 0, dtSec);
+    }
+  }
 
   // Slew-limit ratio to avoid abrupt swings; allow faster moves when far from setpoint
   const float slewPerSec = (fabs(errorF) > PID_SLEW_ERROR_THRESH_F)
@@ -333,10 +493,23 @@ void loop() {
   const float ratio = constrain(lastRatio + ratioStep, PID_OUT_MIN, PID_OUT_MAX);
   lastU = pi.lastOutput();
   lastRatio = ratio;
-  applyMixRatio(ratio);
+
+  // Second output: total opening for the flow target (full open without one)
+  const float total = flowControlUpdate(flowTargetLpm, flow.lpm, flow.sampleMs != 0, dtSec);
+  {
+    ProfileScope prof(ProfStage::MIX);
+    // The valves take up the learned play themselves; lastRatio (estimator,
+    // log) is the ratio the stems should end up at
+    if (BACKLASH_COMP_ENABLED) {
+      valveMixSetPlay(backlashCompUpdate(ratio, total, sampleMs, outlet.filteredF, hot.filteredF, cold.filteredF,
+                                         flow.lpm, flow.sampleMs != 0));
+    }
+    applyMixFlow(ratio, total);
+  }
+  s_valvesSafe = false;
 
   if (PID_LOG_CSV) {
-    logCsvIfDue(sampleMs, outlet, linkOk);
+    logCsvIfDue(sampleMs, frame, linkOk);
   } else {
     Serial.printf("RUN=ON | OUT=%.2fF / SET=%.2fF | error=%.2fF | ratio=%.2f | flow=%.2f L/min | link=%s\n",
                   outletTempF,
@@ -346,19 +519,68 @@ void loop() {
                   flow.lpm,
                   linkOk ? "OK" : "LOST");
   }
-
-  delay(LOOP_DELAY_MS);
 }
 
 static bool estopPressed() {
   return digitalRead(ESTOP_PIN) == LOW;
 }
 
-static void logCsvIfDue(unsigned long nowMs, const TemperatureReading& outlet, bool linkOk) {
+static void logCsvIfDue(unsigned long nowMs, const SensorFrame& frame, bool linkOk) {
   if (!PID_LOG_CSV) return;
 
   static unsigned long lastLogMs = 0;
-  if (lastLogMs != 0 && (nowMs - lastLogMs) < LOGGER_PERIOD_MS) {
+  const unsigned long periodMs = TELEMETRY_BINARY ? TELEMETRY_PERIOD_MS : LOGGER_PERIOD_MS;
+  if (lastLogMs != 0 && (nowMs - lastLogMs) < periodMs) {
+    return;
+  }
+  ProfileScope prof(ProfStage::LOG);
+
+  LogRecord rec{};
+  rec.ms = (uint32_t) nowMs;
+  rec.setpointF = setpointF;
+  rec.outletRawF = frame.outlet.rawF;
+  rec.outletFiltF = frame.outlet.filteredF;
+  rec.ratio = lastRatio;
+  rec.u = lastU;
+  rec.kp = pi.getKp();
+  rec.ki = pi.getKi();
+  rec.flowLpm = frame.flow.lpm;
+  rec.linkOk = linkOk;
+  rec.hotF = frame.hot.filteredF;
+  rec.coldF = frame.cold.filteredF;
+  rec.hotUs = (uint16_t) lastHotUs();
+  rec.coldUs = (uint16_t) lastColdUs();
+  rec.fault = (uint8_t) activeFault;
+  rec.runFlag = runFlag;
+  rec.estop = frame.estop;
+  rec.outletValid = frame.outlet.present && frame.outlet.valid;
+  rec.hotValid = frame.hot.present && frame.hot.valid;
+  rec.coldValid = frame.cold.present && frame.cold.valid;
+  rec.flowValid = frame.flow.sampleMs != 0;
+  const LinkQualityStats link = commLinkQuality();
+  rec.linkRssiDbm = (int8_t) lroundf(link.rssiMeanDbm);
+  rec.linkLossPct = link.lossPct;
+  rec.linkDupPct = link.duplicatePct;
+
+  // The drainer (or pipeline log task) owns the UART; never block the control step on it
+  if (CONTROL_PIPELINE_ENABLED) {
+    (void) pipelinePostLog(rec);
+  } else {
+    (void) logRingPush(rec);
+  }
+
+  lastLogMs = nowMs;
+}
+
+// Drainer side: only take a record when it fits in the UART TX buffer
+static bool logSinkReady() {
+  const int need = TELEMETRY_BINARY ? (int) TELEMETRY_MAX_ENCODED : LOGGER_CSV_LINE_MAX;
+  return Serial.availableForWrite() >= need;
+}
+
+static void writeLogRecord(const LogRecord& rec) {
+  if (TELEMETRY_BINARY) {
+    (void) telemetryWrite(rec);
     return;
   }
 
@@ -367,19 +589,15 @@ static void logCsvIfDue(unsigned long nowMs, const TemperatureReading& outlet, b
     loggerHeaderPrinted = true;
   }
 
-  const FlowReading flow = flowSensorGet();
-
   Serial.printf("%lu,%.1f,%.2f,%.2f,%.3f,%.3f,%.3f,%.3f,%.3f,%d\n",
-                (unsigned long) nowMs,
-                setpointF,
-                outlet.rawF,
-                outlet.filteredF,
-                lastRatio,
-                lastU,
-                pi.getKp(),
-                pi.getKi(),
-                flow.lpm,
-                linkOk ? 1 : 0);
-
-  lastLogMs = nowMs;
+                (unsigned long) rec.ms,
+                rec.setpointF,
+                rec.outletRawF,
+                rec.outletFiltF,
+                rec.ratio,
+                rec.u,
+                rec.kp,
+                rec.ki,
+                rec.flowLpm,
+                rec.linkOk ? 1 : 0);
 }
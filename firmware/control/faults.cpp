@@ -0,0 +1,309 @@
+#include "faults.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "rolling_stats.h"
+
+constexpr size_t FAULT_CODE_COUNT = static_cast<size_t>(FaultCode::COUNT);
+static_assert(FAULT_CODE_COUNT <= 32, "fault bitmask is 32 bits");
+
+// --- Rapid-change history (per supply line, run time only) ---
+// 10 Hz samples over TEMP_RAPID_WINDOW_MS fit with headroom
+static constexpr size_t RAPID_HISTORY = 16;
+
+struct SwingHistory {
+  RollingStats<RAPID_HISTORY> window{TEMP_RAPID_WINDOW_MS};
+  uint32_t lastSampleMs;
+};
+
+// --- Failed-read history (per DS18B20, from the health table's counter) ---
+static constexpr size_t ERROR_HISTORY = 8;
+static_assert(FAULT_SENSOR_ERROR_LIMIT <= ERROR_HISTORY, "error limit must fit the history");
+
+struct ErrorHistory {
+  RollingStats<ERROR_HISTORY> window{FAULT_SENSOR_ERROR_WINDOW_MS};
+  uint32_t lastCount;
+  bool primed;  // lastCount holds the counter as of a previous pass
+};
+
+// Per-pass view handed to every rule
+struct FaultContext {
+  const FaultInputs* in;
+  float hotSwingF;
+  float coldSwingF;
+  uint8_t sensorErrors[TEMP_SENSOR_COUNT];  // within FAULT_SENSOR_ERROR_WINDOW_MS
+};
+
+// excess > 0 means the rule is violated, in the rule's own units
+struct FaultCheck {
+  float excess;
+  float value;  // observed value, shown in the set message
+};
+
+// When a rule is checked relative to the RUN request
+enum class RunGate : uint8_t {
+  Always,
+  Run,       // only while RUN is requested; holds state otherwise
+  SetOnRun,  // raised only while RUN is requested; an active fault may clear without it
+};
+
+struct FaultRule {
+  FaultCode code;
+  const char* name;
+  FaultCheck (*check)(const FaultContext& ctx);
+  float hysteresis;  // an active fault clears only once excess < -hysteresis
+  uint16_t setMs;    // violation must persist this long to latch
+  uint16_t clearMs;  // and be gone this long to clear
+  RunGate gate;
+  const char* setFmt;  // printf format: observed value, then msgA, msgB
+  float msgA;
+  float msgB;
+};
+
+struct RuleState {
+  bool active;
+  bool pending;     // condition differs from 'active' since pendingMs
+  uint32_t pendingMs;
+  float value;      // observed value at the last transition
+};
+
+static SwingHistory s_hotSwing;
+static SwingHistory s_coldSwing;
+static ErrorHistory s_sensorErrors[TEMP_SENSOR_COUNT];
+static RuleState s_state[FAULT_CODE_COUNT];
+static FaultStatus s_status{};
+
+static FaultCheck flag(bool violated) {
+  return FaultCheck{violated ? 1.0f : -1.0f, 0.0f};
+}
+
+// Distance outside [lo, hi]; negative inside (distance to the nearer limit)
+static FaultCheck outside(float v, float lo, float hi) {
+  if (isnan(v)) return FaultCheck{-1.0f, v};
+  const float excess = (v < lo) ? (lo - v) : ((v > hi) ? (v - hi) : -min(v - lo, hi - v));
+  return FaultCheck{excess, v};
+}
+
+static bool usable(const TemperatureReading& r) {
+  return r.present && r.valid;
+}
+
+// --- Rules ---
+
+static FaultCheck checkEStop(const FaultContext& ctx) {
+  return flag(ctx.in->estop);
+}
+
+static FaultCheck checkLinkLoss(const FaultContext& ctx) {
+  const FaultInputs& in = *ctx.in;
+  const bool lost = (in.lastRxMs == 0) || ((uint32_t) (in.nowMs - in.lastRxMs) > COMM_LINK_TIMEOUT_MS);
+  return flag(lost);
+}
+
+// Not ok, stale, or flapping; the value shown is the age of the last fresh sample (s)
+static FaultCheck checkSensor(const FaultContext& ctx, TempSensor sensor, uint32_t staleMs) {
+  const size_t idx = static_cast<size_t>(sensor);
+  const SensorHealth& h = ctx.in->health->channel[idx];
+  const bool violated = !h.ok || h.ageMs > staleMs || ctx.sensorErrors[idx] >= FAULT_SENSOR_ERROR_LIMIT;
+  const float ageS = (h.ageMs == UINT32_MAX) ? INFINITY : h.ageMs / 1000.0f;
+  return FaultCheck{violated ? 1.0f : -1.0f, ageS};
+}
+
+static FaultCheck checkHotSensor(const FaultContext& ctx) {
+  return checkSensor(ctx, TempSensor::HOT, FAULT_LINE_SENSOR_STALE_MS);
+}
+static FaultCheck checkColdSensor(const FaultContext& ctx) {
+  return checkSensor(ctx, TempSensor::COLD, FAULT_LINE_SENSOR_STALE_MS);
+}
+static FaultCheck checkOutletSensor(const FaultContext& ctx) {
+  return checkSensor(ctx, TempSensor::OUTLET, FAULT_OUTLET_SENSOR_STALE_MS);
+}
+
+// Bounds rules only judge usable readings; an unusable sensor has its own rule
+static FaultCheck checkHotBounds(const FaultContext& ctx) {
+  if (!usable(ctx.in->hot)) return FaultCheck{-INFINITY, NAN};
+  return outside(ctx.in->hot.filteredF, HOT_MIN_PLAUSIBLE_F, HOT_MAX_PLAUSIBLE_F);
+}
+
+static FaultCheck checkColdBounds(const FaultContext& ctx) {
+  if (!usable(ctx.in->cold)) return FaultCheck{-INFINITY, NAN};
+  return outside(ctx.in->cold.filteredF, COLD_MIN_PLAUSIBLE_F, COLD_MAX_PLAUSIBLE_F);
+}
+
+static FaultCheck checkOutletBounds(const FaultContext& ctx) {
+  if (!usable(ctx.in->outlet)) return FaultCheck{-INFINITY, NAN};
+  return outside(ctx.in->outlet.filteredF, OUTLET_MIN_PLAUSIBLE_F, OUTLET_MAX_PLAUSIBLE_F);
+}
+
+static FaultCheck checkHotRapid(const FaultContext& ctx) {
+  return FaultCheck{ctx.hotSwingF - TEMP_RAPID_DELTA_F, ctx.hotSwingF};
+}
+
+static FaultCheck checkColdRapid(const FaultContext& ctx) {
+  return FaultCheck{ctx.coldSwingF - TEMP_RAPID_DELTA_F, ctx.coldSwingF};
+}
+
+// Table order = reporting priority (matches the original if/else ladder)
+static constexpr float RAPID_WINDOW_S = TEMP_RAPID_WINDOW_MS / 1000.0f;
+
+static const FaultRule kRules[] = {
+    // code, name, check, hysteresis, setMs, clearMs, gate, message, message args
+    {FaultCode::EStop, "estop", checkEStop, 0.0f, 0, FAULT_ESTOP_CLEAR_MS, RunGate::Always,
+     "E-STOP: switch active → closing valves", 0.0f, 0.0f},
+    {FaultCode::LinkLoss, "link-loss", checkLinkLoss, 0.0f, 0, 0, RunGate::SetOnRun,
+     "LINK ERROR: No UI command for 2s → closing valves", 0.0f, 0.0f},
+    {FaultCode::HotSensorFault, "hot-sensor", checkHotSensor, 0.0f, FAULT_LINE_SENSOR_SET_MS, FAULT_SENSOR_CLEAR_MS, RunGate::Always,
+     "TEMP ERROR: Hot sensor fault (last sample %.1fs ago) → closing valves", 0.0f, 0.0f},
+    {FaultCode::ColdSensorFault, "cold-sensor", checkColdSensor, 0.0f, FAULT_LINE_SENSOR_SET_MS, FAULT_SENSOR_CLEAR_MS, RunGate::Always,
+     "TEMP ERROR: Cold sensor fault (last sample %.1fs ago) → closing valves", 0.0f, 0.0f},
+    {FaultCode::HotOutOfBounds, "hot-bounds", checkHotBounds, FAULT_TEMP_HYST_F, FAULT_BOUNDS_SET_MS, FAULT_BOUNDS_CLEAR_MS, RunGate::Always,
+     "TEMP ERROR: Hot %.1fF out of bounds (%.0f-%.0fF) → closing valves", HOT_MIN_PLAUSIBLE_F, HOT_MAX_PLAUSIBLE_F},
+    {FaultCode::ColdOutOfBounds, "cold-bounds", checkColdBounds, FAULT_TEMP_HYST_F, FAULT_BOUNDS_SET_MS, FAULT_BOUNDS_CLEAR_MS, RunGate::Always,
+     "TEMP ERROR: Cold %.1fF out of bounds (%.0f-%.0fF) → closing valves", COLD_MIN_PLAUSIBLE_F, COLD_MAX_PLAUSIBLE_F},
+    {FaultCode::HotRapidChange, "hot-rapid", checkHotRapid, FAULT_RAPID_HYST_F, 0, FAULT_RAPID_CLEAR_MS, RunGate::Run,
+     "TEMP ERROR: Hot jump %.1fF in %.1fs → closing valves", RAPID_WINDOW_S, 0.0f},
+    {FaultCode::ColdRapidChange, "cold-rapid", checkColdRapid, FAULT_RAPID_HYST_F, 0, FAULT_RAPID_CLEAR_MS, RunGate::Run,
+     "TEMP ERROR: Cold jump %.1fF in %.1fs → closing valves", RAPID_WINDOW_S, 0.0f},
+    {FaultCode::OutletSensorFault, "outlet-sensor", checkOutletSensor, 0.0f, FAULT_OUTLET_SENSOR_SET_MS, FAULT_SENSOR_CLEAR_MS, RunGate::Always,
+     "TEMP ERROR: Outlet sensor fault (last sample %.1fs ago) → closing valves", 0.0f, 0.0f},
+    {FaultCode::OutletOutOfBounds, "outlet-bounds", checkOutletBounds, FAULT_TEMP_HYST_F, FAULT_BOUNDS_SET_MS, FAULT_BOUNDS_CLEAR_MS, RunGate::Always,
+     "TEMP ERROR: Outlet %.1fF out of bounds (%.0f-%.0fF) → closing valves", OUTLET_MIN_PLAUSIBLE_F, OUTLET_MAX_PLAUSIBLE_F},
+};
+
+static constexpr size_t RULE_COUNT = sizeof(kRules) / sizeof(kRules[0]);
+static_assert(RULE_COUNT == FAULT_CODE_COUNT - 1, "one rule per FaultCode");
+
+static const FaultRule* ruleFor(FaultCode code) {
+  for (const FaultRule& rule : kRules) {
+    if (rule.code == code) return &rule;
+  }
+  return nullptr;
+}
+
+// Add a fresh sample (if any) and return max-min over the rapid window
+static float updateSwing(SwingHistory& h, const TemperatureReading& r, uint32_t nowMs) {
+  if (usable(r) && r.sampleMs != 0 && r.sampleMs != h.lastSampleMs) {
+    h.window.add(r.sampleMs, r.filteredF);
+    h.lastSampleMs = r.sampleMs;
+  }
+  h.window.expire(nowMs);
+  return h.window.range();
+}
+
+static void resetSwing(SwingHistory& h) {
+  h.window.reset();
+  h.lastSampleMs = 0;
+}
+
+// Log new failed reads and return those in the window. One bad read counts
+// once: not its CRC retry, nor the dropout it causes.
+static uint8_t updateSensorErrors(ErrorHistory& h, const SensorHealth& health, uint32_t nowMs) {
+  const uint32_t count = health.failedReads;
+  if (h.primed) {
+    const uint32_t fresh = min(count - h.lastCount, (uint32_t) ERROR_HISTORY);
+    for (uint32_t n = 0; n < fresh; ++n) h.window.add(nowMs, 1.0f);
+  }
+  h.lastCount = count;
+  h.primed = true;
+  h.window.expire(nowMs);
+  return (uint8_t) h.window.count();
+}
+
+void faultInit() {
+  resetSwing(s_hotSwing);
+  resetSwing(s_coldSwing);
+  for (ErrorHistory& h : s_sensorErrors) {
+    h.window.reset();
+    h.primed = false;
+  }
+  memset(s_state, 0, sizeof(s_state));
+  s_status = FaultStatus{};
+}
+
+const FaultStatus& faultEvaluate(const FaultInputs& in) {
+  // Rapid-change history only spans time spent running (as before)
+  if (!in.runRequested) {
+    resetSwing(s_hotSwing);
+    resetSwing(s_coldSwing);
+  }
+  FaultContext ctx{&in, 0.0f, 0.0f, {}};
+  for (size_t idx = 0; idx < TEMP_SENSOR_COUNT; ++idx) {
+    ctx.sensorErrors[idx] = updateSensorErrors(s_sensorErrors[idx], in.health->channel[idx], in.nowMs);
+  }
+  if (in.runRequested) {
+    ctx.hotSwingF = updateSwing(s_hotSwing, in.hot, in.nowMs);
+    ctx.coldSwingF = updateSwing(s_coldSwing, in.cold, in.nowMs);
+  }
+
+  uint32_t mask = 0;
+  uint32_t raised = 0;
+  uint32_t cleared = 0;
+  FaultCode primary = FaultCode::None;
+
+  for (const FaultRule& rule : kRules) {
+    RuleState& st = s_state[static_cast<size_t>(rule.code)];
+
+    // Link loss drops RUN itself, so it must be able to clear with RUN off
+    const bool evaluate = rule.gate == RunGate::Always || in.runRequested ||
+                          (rule.gate == RunGate::SetOnRun && st.active);
+    if (evaluate) {
+      const FaultCheck c = rule.check(ctx);
+      const bool violated = st.active ? (c.excess > -rule.hysteresis) : (c.excess > 0.0f);
+
+      if (violated == st.active) {
+        st.pending = false;
+      } else {
+        if (!st.pending) {
+          st.pending = true;
+          st.pendingMs = in.nowMs;
+        }
+        const uint32_t holdMs = st.active ? rule.clearMs : rule.setMs;
+        if ((uint32_t) (in.nowMs - st.pendingMs) >= holdMs) {
+          st.active = violated;
+          st.pending = false;
+          st.value = c.value;
+          (violated ? raised : cleared) |= faultBit(rule.code);
+        }
+      }
+    }
+
+    if (st.active) {
+      mask |= faultBit(rule.code);
+      if (primary == FaultCode::None) primary = rule.code;
+    }
+  }
+
+  s_status = FaultStatus{mask, raised, cleared, primary};
+  return s_status;
+}
+
+uint32_t faultMask() {
+  return s_status.mask;
+}
+
+FaultCode faultPrimary(uint32_t mask) {
+  for (const FaultRule& rule : kRules) {
+    if (mask & faultBit(rule.code)) return rule.code;
+  }
+  return FaultCode::None;
+}
+
+const char* faultName(FaultCode code) {
+  const FaultRule* rule = ruleFor(code);
+  return rule ? rule->name : "none";
+}
+
+size_t faultFormatMessage(FaultCode code, bool raised, char* buf, size_t len) {
+  const FaultRule* rule = ruleFor(code);
+  if (!rule || len == 0) return 0;
+
+  int n;
+  if (raised) {
+    n = snprintf(buf, len, rule->setFmt, s_state[static_cast<size_t>(code)].value, rule->msgA, rule->msgB);
+  } else {
+    n = snprintf(buf, len, "FAULT CLEARED: %s", rule->name);
+  }
+  return n < 0 ? 0 : min((size_t) n, len - 1);
+}
@@ -0,0 +1,98 @@
+/*
+ * ================================================================
+ *  Module: faults
+ *  Purpose: Table-driven safety fault evaluator for the control
+ *           loop. Every rule in a compile-time table is checked on
+ *           each pass (fixed, bounded cost), producing a bitmask of
+ *           all simultaneous faults. Each rule has its own
+ *           hysteresis plus set (latch) and clear delays; messages
+ *           are formatted only when a fault's state changes.
+ *
+ *           Pure function of FaultInputs + time (no hardware access),
+ *           so the evaluator runs unchanged in host builds.
+ *
+ *  Dependencies:
+ *    - config.h        (limits, FAULT_* timing/hysteresis)
+ *    - rolling_stats.h (rapid-change and sensor-error windows; implementation only)
+ *    - sensor_health.h (SensorHealthReport for the sensor rules)
+ *    - temperature.h   (TemperatureReading)
+ *
+ *  Interface:
+ *    void faultInit();
+ *    const FaultStatus& faultEvaluate(const FaultInputs& in);
+ *    uint32_t faultMask();
+ *    FaultCode faultPrimary(uint32_t mask);
+ *    const char* faultName(FaultCode code);
+ *    size_t faultFormatMessage(FaultCode code, bool raised, char* buf, size_t len);
+ * ================================================================
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "config.h"
+#include "sensor_health.h"
+#include "temperature.h"
+
+// Values are sent in telemetry; append new codes at the end
+enum class FaultCode : uint8_t {
+  None = 0,
+  EStop,
+  LinkLoss,
+  OutletSensorFault,
+  OutletOutOfBounds,
+  HotSensorFault,
+  ColdSensorFault,
+  HotOutOfBounds,
+  ColdOutOfBounds,
+  HotRapidChange,
+  ColdRapidChange,
+  COUNT,
+};
+
+constexpr uint32_t faultBit(FaultCode code) {
+  return 1UL << static_cast<uint8_t>(code);
+}
+
+// Faults that also cancel the UI run request (operator must re-assert RUN)
+constexpr uint32_t FAULT_DROPS_RUN_MASK = faultBit(FaultCode::EStop) | faultBit(FaultCode::LinkLoss);
+
+// Everything the rules look at, captured once per control pass
+struct FaultInputs {
+  uint32_t nowMs;
+  bool estop;
+  bool runRequested;     // UI run flag; rapid-change rules hold their state and link loss cannot set while false
+  uint32_t lastRxMs;     // commLastRxMs() (0 = never / marked lost)
+  TemperatureReading hot;
+  TemperatureReading cold;
+  TemperatureReading outlet;
+  const SensorHealthReport* health;  // sensorHealthGet() after this pass's sensorHealthUpdate(); never null
+};
+
+struct FaultStatus {
+  uint32_t mask;     // faultBit() of every active fault
+  uint32_t raised;   // became active on this pass
+  uint32_t cleared;  // became inactive on this pass
+  FaultCode primary; // first active fault in rule-table order (None if mask == 0)
+};
+
+// Reset all rule state (all faults inactive)
+void faultInit();
+
+// Run every rule once; the returned status stays valid until the next call
+const FaultStatus& faultEvaluate(const FaultInputs& in);
+
+// Active fault bitmask from the last evaluation
+uint32_t faultMask();
+
+// First fault of a mask in rule-table (priority) order
+FaultCode faultPrimary(uint32_t mask);
+
+// Short identifier, e.g. "outlet-bounds"
+const char* faultName(FaultCode code);
+
+// Human-readable set/clear message using the value captured at the last
+// transition. Returns the formatted length.
+size_t faultFormatMessage(FaultCode code, bool raised, char* buf, size_t len);
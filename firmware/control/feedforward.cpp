@@ -0,0 +1,126 @@
+#include "feedforward.h"
+
+#include <math.h>
+
+static_assert(FF_VALVE_FULL_FRAC > FF_VALVE_DEAD_FRAC, "FF valve curve: full must exceed dead travel");
+
+static float s_hotF = 0.0f;   // smoothed line temperatures
+static float s_coldF = 0.0f;
+static float s_hotLeadF = 0.0f;  // with lag compensation
+static float s_coldLeadF = 0.0f;
+static bool s_seeded = false;
+static float s_ratio = 0.5f;
+static float s_refF = 0.0f;
+static bool s_refSeeded = false;
+
+// Setpoint history for the reference model's transport delay, one entry per
+// control step (12 s at 10 Hz covers FF_MIN_FLOW_LPM with the bench pipe)
+static constexpr size_t kRefHistoryLen = 128;
+static float s_refHistory[kRefHistoryLen];
+static size_t s_refHead = 0;
+
+static float clamp01(float x) { return x < 0.0f ? 0.0f : (x > 1.0f ? 1.0f : x); }
+
+// Relative port conductance for a stem opening (0 = closed, 1 = fully open).
+// valve_mix already linearizes through the measured curves when the LUT is on.
+static float portConductance(float open) {
+  if (VALVE_LUT_ENABLED) return clamp01(open);
+  return clamp01((open - FF_VALVE_DEAD_FRAC) / (FF_VALVE_FULL_FRAC - FF_VALVE_DEAD_FRAC));
+}
+
+// Hot share of the flow at ratio r (hot port opens with r, cold with 1 - r)
+static float hotFractionAt(float r) {
+  const float gHot = portConductance(r);
+  const float gCold = portConductance(1.0f - r);
+  const float g = gHot + gCold;
+  return (g > 0.0f) ? gHot / g : 0.5f;
+}
+
+void feedforwardInit() {
+  s_seeded = false;
+  s_ratio = 0.5f;
+  feedforwardReset();
+}
+
+void feedforwardReset() { s_refSeeded = false; }
+
+float feedforwardReferenceF(float setpointF, float outletF, float flowLpm, float dtSec, float lagSec) {
+  if (!s_refSeeded) {
+    // Water already in the pipe reaches the sensor first: start from the outlet
+    s_refF = outletF;
+    for (float& h : s_refHistory) h = outletF;
+    s_refSeeded = true;
+  }
+  s_refHead = (s_refHead + 1) % kRefHistoryLen;
+  s_refHistory[s_refHead] = setpointF;
+  if (dtSec <= 0.0f) return s_refF;
+
+  const float q = (flowLpm > FF_MIN_FLOW_LPM) ? flowLpm : FF_MIN_FLOW_LPM;
+  size_t lag = (size_t) (FF_OUTLET_PIPE_L / q * 60.0f / dtSec + 0.5f);
+  if (lag > kRefHistoryLen - 1) lag = kRefHistoryLen - 1;
+  const float delayedF = s_refHistory[(s_refHead + kRefHistoryLen - lag) % kRefHistoryLen];
+  s_refF += (dtSec / (lagSec + dtSec)) * (delayedF - s_refF);
+  return s_refF;
+}
+
+float feedforwardMixTargetF(float setpointF, float flowLpm) {
+  const float q = (flowLpm > FF_MIN_FLOW_LPM) ? flowLpm : FF_MIN_FLOW_LPM;
+  return FF_AMBIENT_F + (setpointF - FF_AMBIENT_F) * expf(FF_PIPE_LOSS_LPM / q);
+}
+
+float feedforwardOutletForRatioF(float ratio, float hotF, float coldF, float flowLpm) {
+  const float q = (flowLpm > FF_MIN_FLOW_LPM) ? flowLpm : FF_MIN_FLOW_LPM;
+  const float mixF = coldF + hotFractionAt(clamp01(ratio)) * (hotF - coldF);
+  return FF_AMBIENT_F + (mixF - FF_AMBIENT_F) * expf(-FF_PIPE_LOSS_LPM / q);
+}
+
+float feedforwardRatioForHotFraction(float hotFraction) {
+  const float f = clamp01(hotFraction);
+  if (f <= 0.0f) return 0.0f;
+  if (f >= 1.0f) return 1.0f;
+
+  // hotFractionAt() is monotonic in r; bisect to well below servo resolution
+  float lo = 0.0f;
+  float hi = 1.0f;
+  for (int i = 0; i < 16; ++i) {
+    const float mid = 0.5f * (lo + hi);
+    if (hotFractionAt(mid) < f) {
+      lo = mid;
+    } else {
+      hi = mid;
+    }
+  }
+  return 0.5f * (lo + hi);
+}
+
+float feedforwardUpdate(const TemperatureReading& hot,
+                        const TemperatureReading& cold,
+                        float setpointF,
+                        float flowLpm,
+                        bool flowValid,
+                        float dtSec) {
+  const bool linesOk = hot.present && hot.valid && cold.present && cold.valid;
+  if (!linesOk) return s_ratio;
+
+  if (!s_seeded) {
+    s_hotF = hot.filteredF;
+    s_coldF = cold.filteredF;
+    s_seeded = true;
+  } else if (dtSec > 0.0f) {
+    const float alpha = dtSec / (FF_LINE_TAU_S + dtSec);
+    s_hotF += alpha * (hot.filteredF - s_hotF);
+    s_coldF += alpha * (cold.filteredF - s_coldF);
+  }
+  // Slope of a first-order filter is (input - output) / tau
+  s_hotLeadF = s_hotF + FF_LINE_LEAD_S * (hot.filteredF - s_hotF) / FF_LINE_TAU_S;
+  s_coldLeadF = s_coldF + FF_LINE_LEAD_S * (cold.filteredF - s_coldF) / FF_LINE_TAU_S;
+
+  const float span = s_hotLeadF - s_coldLeadF;
+  if (span < FF_MIN_SPAN_F) return s_ratio;
+
+  const float mixF = feedforwardMixTargetF(setpointF, flowValid ? flowLpm : 0.0f);
+  s_ratio = feedforwardRatioForHotFraction((mixF - s_coldLeadF) / span);
+  return s_ratio;
+}
+
+float feedforwardRatio() { return s_ratio; }
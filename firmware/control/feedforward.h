@@ -0,0 +1,78 @@
+/*
+ * ================================================================
+ *  Module: feedforward
+ *  Purpose: Model-based base mix ratio for the outlet temperature
+ *           loop, recomputed every control step:
+ *             1. mix temperature needed at the tee so the outlet,
+ *                after pipe heat loss at the current flow, reads the
+ *                setpoint;
+ *             2. hot-flow fraction from the (smoothed) hot and cold
+ *                line temperatures;
+ *             3. valve ratio giving that fraction, by inverting the
+ *                valve opening curve (both valves see the same
+ *                pressure drop, so the flow split depends only on
+ *                the two port openings).
+ *           The PID adds a bounded trim on top, so a supply
+ *           temperature drift moves the base ratio directly instead
+ *           of waiting for the integrator. The trim's reference is
+ *           the setpoint passed through the expected outlet response
+ *           (transport delay + sensor lag), so a setpoint step does
+ *           not also wind up the trim while the new mix is in transit.
+ *
+ *  Dependencies:
+ *    - config.h       (FF_*)
+ *    - temperature.h  (TemperatureReading)
+ *
+ *  Interface:
+ *    void feedforwardInit();
+ *    void feedforwardReset();
+ *    float feedforwardUpdate(const TemperatureReading& hot, const TemperatureReading& cold,
+ *                            float setpointF, float flowLpm, bool flowValid, float dtSec);
+ *    float feedforwardRatio();
+ *    float feedforwardReferenceF(float setpointF, float outletF, float flowLpm, float dtSec, float lagSec);
+ *    float feedforwardMixTargetF(float setpointF, float flowLpm);
+ *    float feedforwardRatioForHotFraction(float hotFraction);
+ *    float feedforwardOutletForRatioF(float ratio, float hotF, float coldF, float flowLpm);
+ * ================================================================
+ */
+
+#pragma once
+
+#include "config.h"
+#include "temperature.h"
+
+// Forget the line-temperature filters and the held ratio
+void feedforwardInit();
+
+// Valves closed / control stopped: the next reference starts from the outlet
+void feedforwardReset();
+
+// Advance the line filters by dtSec and return the base ratio [0,1]. If either
+// line reading is unusable or the lines are closer than FF_MIN_SPAN_F, the
+// previous base ratio is held.
+float feedforwardUpdate(const TemperatureReading& hot,
+                        const TemperatureReading& cold,
+                        float setpointF,
+                        float flowLpm,
+                        bool flowValid,
+                        float dtSec);
+
+// Base ratio from the last update
+float feedforwardRatio();
+
+// Trim reference: setpoint through a model of the outlet response (transport
+// delay FF_OUTLET_PIPE_L / flow, then a first-order lag). Call once per
+// control step; seeded from outletF after init/reset. lagSec is the lag of the
+// signal the trim acts on (FF_REF_TAU_S for the sensor reading, EST_REF_TAU_S
+// for the outlet estimate).
+float feedforwardReferenceF(float setpointF, float outletF, float flowLpm, float dtSec, float lagSec);
+
+// Mix temperature at the tee that reaches the outlet sensor at setpointF
+float feedforwardMixTargetF(float setpointF, float flowLpm);
+
+// Valve ratio whose hot share of the total flow is hotFraction (0–1)
+float feedforwardRatioForHotFraction(float hotFraction);
+
+// Forward model: water temperature reaching the outlet sensor (after pipe
+// loss) for a valve ratio and line temperatures, once transport has settled
+float feedforwardOutletForRatioF(float ratio, float hotF, float coldF, float flowLpm);
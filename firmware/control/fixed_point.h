@@ -0,0 +1,68 @@
+/*
+ * ================================================================
+ *  Module: fixed_point
+ *  Purpose: Signed Q16.16 fixed-point value for integer-only math
+ *           (e.g. a control step run from an ISR, where the FPU must
+ *           not be touched). Conversions from float are constexpr so
+ *           constants built from config.h are scaled at compile time.
+ *
+ *           Range is ±32768 with a resolution of 1/65536. Products
+ *           are computed in 64 bits and rounded to nearest; float
+ *           conversion saturates instead of wrapping.
+ *
+ *  Dependencies:
+ *    - none
+ *
+ *  Interface:
+ *    struct Q16 { int32_t raw; ... };
+ *    constexpr Q16 Q16::fromFloat(float f);
+ *    constexpr Q16 Q16::fromRaw(int32_t raw);
+ *    constexpr Q16 Q16::fromInt(int32_t i);
+ *    constexpr float Q16::toFloat() const;
+ *    constexpr Q16 q16Mul(Q16 a, Q16 b);
+ *    constexpr int32_t q16RoundShift(int64_t v, int shift);
+ * ================================================================
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+struct Q16 {
+  static constexpr int FRAC_BITS = 16;
+  static constexpr int32_t ONE = 1L << FRAC_BITS;
+
+  int32_t raw;
+
+  static constexpr Q16 fromRaw(int32_t r) { return Q16{r}; }
+  static constexpr Q16 fromInt(int32_t i) { return Q16{i * ONE}; }
+
+  static constexpr Q16 fromFloat(float f) {
+    return Q16{f >= 32767.0f    ? INT32_MAX
+               : f <= -32768.0f ? INT32_MIN
+               : f >= 0.0f      ? (int32_t) (f * (float) ONE + 0.5f)
+                                : (int32_t) (f * (float) ONE - 0.5f)};
+  }
+
+  constexpr float toFloat() const { return (float) raw / (float) ONE; }
+};
+
+// Arithmetic shift right with round-half-up, saturated to int32
+constexpr int32_t q16RoundShift(int64_t v, int shift) {
+  const int64_t r = (v + (1LL << (shift - 1))) >> shift;
+  return r > INT32_MAX ? INT32_MAX : r < INT32_MIN ? INT32_MIN : (int32_t) r;
+}
+
+constexpr Q16 q16Mul(Q16 a, Q16 b) {
+  return Q16{q16RoundShift((int64_t) a.raw * b.raw, Q16::FRAC_BITS)};
+}
+
+constexpr Q16 operator+(Q16 a, Q16 b) { return Q16{a.raw + b.raw}; }
+constexpr Q16 operator-(Q16 a, Q16 b) { return Q16{a.raw - b.raw}; }
+constexpr Q16 operator-(Q16 a) { return Q16{-a.raw}; }
+constexpr bool operator<(Q16 a, Q16 b) { return a.raw < b.raw; }
+constexpr bool operator>(Q16 a, Q16 b) { return a.raw > b.raw; }
+constexpr bool operator<=(Q16 a, Q16 b) { return a.raw <= b.raw; }
+constexpr bool operator>=(Q16 a, Q16 b) { return a.raw >= b.raw; }
+constexpr bool operator==(Q16 a, Q16 b) { return a.raw == b.raw; }
+constexpr bool operator!=(Q16 a, Q16 b) { return a.raw != b.raw; }
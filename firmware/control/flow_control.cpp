@@ -0,0 +1,56 @@
+#include "flow_control.h"
+
+#include <math.h>
+
+static_assert(FLOW_OPEN_MIN > 0.0f && FLOW_OPEN_MIN < FLOW_OPEN_MAX && FLOW_OPEN_MAX <= 1.0f,
+              "flow control opening limits");
+
+static float s_open = FLOW_OPEN_MAX;  // sent to the valves (slew-limited)
+static float s_want = FLOW_OPEN_MAX;  // integrator / rescaled opening
+static float s_targetLpm = 0.0f;      // target of the last update (0 = none)
+
+static float clampOpen(float x) {
+  return x < FLOW_OPEN_MIN ? FLOW_OPEN_MIN : (x > FLOW_OPEN_MAX ? FLOW_OPEN_MAX : x);
+}
+
+void flowControlInit() {
+  s_open = s_want = FLOW_OPEN_MAX;
+  s_targetLpm = 0.0f;
+}
+
+void flowControlReset() { s_targetLpm = 0.0f; }
+
+float flowControlUpdate(float targetLpm, float flowLpm, bool flowValid, float dtSec) {
+  if (!FLOW_CTRL_ENABLED || targetLpm <= 0.0f) {
+    s_targetLpm = 0.0f;
+    s_open = s_want = FLOW_OPEN_MAX;
+    return s_open;
+  }
+
+  // New target: flow is roughly proportional to opening, so rescale at once
+  if (s_targetLpm > 0.0f && targetLpm != s_targetLpm) {
+    s_want = clampOpen(s_want * targetLpm / s_targetLpm);
+  }
+  s_targetLpm = targetLpm;
+  if (dtSec <= 0.0f) return s_open;
+
+  // d(ln open)/dt = relative error / Ti, with a deadband so the servos can
+  // hold; only once the output has caught up (the flow lags the slew)
+  if (flowValid && flowLpm >= FF_MIN_FLOW_LPM && s_open == s_want &&
+      fabsf(targetLpm - flowLpm) > FLOW_CTRL_DEADBAND_FRAC * targetLpm) {
+    const float relErr = (targetLpm - flowLpm) / flowLpm;
+    s_want = clampOpen(s_want * (1.0f + relErr * dtSec / FLOW_CTRL_TI_S));
+  }
+
+  // Both openings follow the total together, so the slower-moving valve
+  // does not leave a slug of off-ratio water at the tee
+  const float maxStep = FLOW_OPEN_SLEW_PER_SEC * dtSec;
+  if (fabsf(s_want - s_open) <= maxStep) {
+    s_open = s_want;
+  } else {
+    s_open += (s_want > s_open) ? maxStep : -maxStep;
+  }
+  return s_open;
+}
+
+float flowControlOpening() { return s_open; }
@@ -0,0 +1,53 @@
+/*
+ * ================================================================
+ *  Module: flow_control
+ *  Purpose: Flow half of the two-output (temperature + flow) loop.
+ *           The valves are driven in ratio/total coordinates
+ *           (applyMixFlow): the ratio sets the hot share of the mix,
+ *           the total scales both openings together. With the
+ *           linearized valve curves the hot share depends only on the
+ *           ratio and the flow only on the total, so the 2×2 plant is
+ *           diagonal and each output gets its own single loop: the
+ *           existing PID/feedforward on the ratio, and this one on the
+ *           total. The remaining cross-terms are handled where they
+ *           arise: pipe loss and transport delay change with flow, and
+ *           the feedforward, reference model and estimator already use
+ *           the measured flow; a ratio move that shifts flow (unequal
+ *           supply pressures) is corrected by this loop long before
+ *           the temperature loop reacts.
+ *
+ *           Flow behind the outlet restriction grows less than linearly
+ *           with opening, so the integral acts on the relative error and
+ *           moves the opening in proportion to itself (loop gain stays
+ *           the same across the range). A target change first rescales
+ *           the opening by new/old target; the integral removes the rest.
+ *
+ *  Dependencies:
+ *    - config.h  (FLOW_CTRL_*, FLOW_OPEN_*, FF_MIN_FLOW_LPM)
+ *
+ *  Interface:
+ *    void flowControlInit();
+ *    void flowControlReset();
+ *    float flowControlUpdate(float targetLpm, float flowLpm, bool flowValid, float dtSec);
+ *    float flowControlOpening();
+ * ================================================================
+ */
+
+#pragma once
+
+#include "config.h"
+
+// Opening back to FLOW_OPEN_MAX, no target
+void flowControlInit();
+
+// Control stopped (valves closed): the next run starts from the last opening
+void flowControlReset();
+
+// Total opening [FLOW_OPEN_MIN, FLOW_OPEN_MAX] for applyMixFlow(); call once
+// per control step. targetLpm <= 0 (or FLOW_CTRL_ENABLED = false) returns
+// FLOW_OPEN_MAX. The opening is held while the flow reading is missing or
+// below FF_MIN_FLOW_LPM (valves just opened).
+float flowControlUpdate(float targetLpm, float flowLpm, bool flowValid, float dtSec);
+
+// Opening from the last update
+float flowControlOpening();
@@ -1,64 +1,112 @@
 #include "flow_sensor.h"
 
 #include <Arduino.h>
+#include <driver/pulse_cnt.h>
 #include <math.h>
 
 #include "config.h"
 
 static volatile uint32_t s_pulseCount = 0;
+static volatile uint32_t s_edgeUs[FLOW_EDGE_RING];  // reciprocal mode: micros() of edge n at [n % ring]
+static uint32_t s_trainStart = 0;                  // first edge after the last zero-flow timeout
+static pcnt_unit_handle_t s_pcnt = nullptr;  // non-null: PCNT backend active
+static int s_lastPcntCount = 0;
 static uint32_t s_lastCount = 0;
 static uint32_t s_lastWindowMs = 0;
+static uint32_t s_lastPublishMs = 0;
 static float s_filteredHz = 0.0f;
 static float s_filteredLpm = 0.0f;
 static FlowReading s_lastReading{0.0f, 0.0f, 0.0f, 0.0f, 0, false};
 static bool s_initialized = false;
 
-// ISR: increment pulse count on rising edge
+static_assert((FLOW_EDGE_RING & (FLOW_EDGE_RING - 1)) == 0 && FLOW_EDGE_RING >= 2,
+              "FLOW_EDGE_RING must be a power of two");
+
+// ISR backend: increment pulse count on rising edge
 static void IRAM_ATTR onFlowPulse() {
   s_pulseCount++;
 }
 
+// Reciprocal mode: also timestamp the edge. The stamp is stored before the
+// count is published, so a reader that sees count n finds edges < n in place.
+static void IRAM_ATTR onFlowEdge() {
+  const uint32_t n = s_pulseCount;
+  s_edgeUs[n & (FLOW_EDGE_RING - 1)] = micros();
+  s_pulseCount = n + 1;
+}
+
+// Count rising edges in the PCNT peripheral: no interrupt per pulse, and the
+// glitch filter rejects ringing on the line. The counter wraps to 0 at
+// FLOW_PCNT_LIMIT; flowSensorUpdate() unwraps it, so no overflow ISR either.
+static bool startPcnt() {
+  pcnt_unit_config_t unitCfg{};
+  unitCfg.low_limit = -1;
+  unitCfg.high_limit = FLOW_PCNT_LIMIT;
+  pcnt_unit_handle_t unit = nullptr;
+  if (pcnt_new_unit(&unitCfg, &unit) != ESP_OK) return false;
+
+  pcnt_glitch_filter_config_t filterCfg{};
+  filterCfg.max_glitch_ns = FLOW_PCNT_GLITCH_NS;
+  pcnt_chan_config_t chanCfg{};
+  chanCfg.edge_gpio_num = FLOW_PIN;
+  chanCfg.level_gpio_num = -1;
+  pcnt_channel_handle_t chan = nullptr;
+  if (pcnt_unit_set_glitch_filter(unit, &filterCfg) != ESP_OK ||
+      pcnt_new_channel(unit, &chanCfg, &chan) != ESP_OK ||
+      pcnt_channel_set_edge_action(chan, PCNT_CHANNEL_EDGE_ACTION_INCREASE, PCNT_CHANNEL_EDGE_ACTION_HOLD) != ESP_OK ||
+      pcnt_unit_enable(unit) != ESP_OK || pcnt_unit_clear_count(unit) != ESP_OK ||
+      pcnt_unit_start(unit) != ESP_OK) {
+    if (chan) pcnt_del_channel(chan);
+    pcnt_del_unit(unit);
+    return false;
+  }
+  s_pcnt = unit;
+  s_lastPcntCount = 0;
+  return true;
+}
+
+// Running pulse total from whichever backend is active
+static uint32_t readPulseCount() {
+  if (s_pcnt) {
+    int now = 0;
+    pcnt_unit_get_count(s_pcnt, &now);
+    int delta = now - s_lastPcntCount;
+    if (delta < 0) delta += FLOW_PCNT_LIMIT;
+    s_lastPcntCount = now;
+    s_pulseCount += (uint32_t) delta;  // only written here when PCNT is active
+    return s_pulseCount;
+  }
+  return s_pulseCount;  // aligned 32-bit load: atomic against the ISR
+}
+
 bool flowSensorInit() {
   pinMode(FLOW_PIN, INPUT_PULLUP);
-  attachInterrupt(digitalPinToInterrupt(FLOW_PIN), onFlowPulse, RISING);
+  if (FLOW_RECIPROCAL) {
+    attachInterrupt(digitalPinToInterrupt(FLOW_PIN), onFlowEdge, RISING);
+  } else if (!FLOW_USE_PCNT || !startPcnt()) {
+    attachInterrupt(digitalPinToInterrupt(FLOW_PIN), onFlowPulse, RISING);
+  }
 
   const uint32_t now = millis();
   s_lastWindowMs = now;
+  s_lastPublishMs = now;
   s_lastReading.sampleMs = now;
   s_lastReading.fresh = false;
   s_initialized = true;
   return true;
 }
 
-bool flowSensorUpdate() {
-  if (!s_initialized) return false;
-
-  const uint32_t now = millis();
-  const uint32_t windowMs = now - s_lastWindowMs;
-  if (windowMs < FLOW_WINDOW_MS) {
-    return false;
-  }
-
-  noInterrupts();
-  const uint32_t count = s_pulseCount;
-  interrupts();
-
-  const uint32_t delta = count - s_lastCount;
-  s_lastCount = count;
-  s_lastWindowMs = now;
-
-  const uint32_t dtMs = windowMs == 0 ? 1 : windowMs;
-  const float hzRaw = (delta == 0) ? 0.0f : (1000.0f * delta) / (float) dtMs;
-  const float lpmRaw = (delta == 0)
-                           ? 0.0f
-                           : (hzRaw * 60.0f) / (FLOW_K_PULSES_PER_ML * 1000.0f);
+// Fold a raw frequency into the EMA and publish it as the current reading
+static void publish(uint32_t now, float hzRaw, uint32_t dtMs, unsigned tauMs) {
+  const float lpmRaw = (hzRaw <= 0.0f) ? 0.0f : (hzRaw * 60.0f) / (FLOW_K_PULSES_PER_ML * 1000.0f);
+  if (dtMs == 0) dtMs = 1;
 
   if (s_lastReading.sampleMs == 0) {
     // Seed the filter on the first measurement to avoid startup bias.
     s_filteredHz = hzRaw;
     s_filteredLpm = lpmRaw;
   } else {
-    float alpha = 1.0f - expf(-(float) dtMs / (float) FLOW_FILTER_TAU_MS);
+    float alpha = 1.0f - expf(-(float) dtMs / (float) tauMs);
     if (alpha < 0.0f) alpha = 0.0f;
     if (alpha > 1.0f) alpha = 1.0f;
     s_filteredHz += alpha * (hzRaw - s_filteredHz);
@@ -74,9 +122,91 @@ bool flowSensorUpdate() {
   reading.lpmRaw = lpmRaw;
 
   s_lastReading = reading;
+  s_lastPublishMs = now;
+}
+
+// Pulses counted over FLOW_WINDOW_MS
+static bool updateWindowed(uint32_t now) {
+  const uint32_t windowMs = now - s_lastWindowMs;
+  if (windowMs < FLOW_WINDOW_MS) {
+    return false;
+  }
+
+  const uint32_t count = readPulseCount();
+  const uint32_t delta = count - s_lastCount;
+  s_lastCount = count;
+  s_lastWindowMs = now;
+
+  const uint32_t dtMs = windowMs == 0 ? 1 : windowMs;
+  const float hzRaw = (delta == 0) ? 0.0f : (1000.0f * delta) / (float) dtMs;
+  publish(now, hzRaw, dtMs, FLOW_FILTER_TAU_MS);
+  return true;
+}
+
+// Frequency from edge timestamps: the periods of the newest edges (up to
+// FLOW_PERIOD_SPAN_MS of them), re-estimated whenever an edge arrives.
+// Between edges the open gap bounds the frequency from above, so a stop
+// shows as a decaying rate and reads zero after FLOW_ZERO_TIMEOUT_MS.
+static bool updateReciprocal(uint32_t now) {
+  // Lock-free snapshot: copy again if an edge landed during the copy. An edge
+  // in flight can only be overwriting the oldest slot, which is never used.
+  uint32_t edges[FLOW_EDGE_RING];
+  uint32_t count;
+  do {
+    count = s_pulseCount;
+    for (size_t i = 0; i < FLOW_EDGE_RING; ++i) edges[i] = s_edgeUs[i];
+  } while (count != s_pulseCount);
+  const uint32_t nowUs = micros();
+  const uint32_t dtMs = now - s_lastPublishMs;
+
+  const bool newEdges = count != s_lastCount;
+  s_lastCount = count;
+  if (count == s_trainStart) {
+    // Nothing since the last stop: republish zero at the windowed cadence
+    if (dtMs < FLOW_WINDOW_MS) return false;
+    publish(now, 0.0f, dtMs, FLOW_RECIP_FILTER_TAU_MS);
+    return true;
+  }
+
+  const uint32_t newest = count - 1;
+  const uint32_t newestUs = edges[newest & (FLOW_EDGE_RING - 1)];
+  const uint32_t gapUs = nowUs - newestUs;
+  if (gapUs >= FLOW_ZERO_TIMEOUT_MS * 1000UL) {
+    // Stopped: the next edge starts a new pulse train
+    s_trainStart = count;
+    publish(now, 0.0f, dtMs, FLOW_RECIP_FILTER_TAU_MS);
+    return true;
+  }
+
+  // Average the newest periods, not reaching past the ring or the train start
+  uint32_t oldest = newest;
+  const uint32_t firstValid = (count - s_trainStart > FLOW_EDGE_RING - 1) ? count - (FLOW_EDGE_RING - 1) : s_trainStart;
+  while (oldest > firstValid && newestUs - edges[(oldest - 1) & (FLOW_EDGE_RING - 1)] <= FLOW_PERIOD_SPAN_MS * 1000UL) {
+    oldest--;
+  }
+  if (oldest == newest && newest > firstValid) oldest--;  // always at least one period
+  if (oldest == newest) {
+    return false;  // single edge so far: no period yet
+  }
+  const uint32_t spanUs = newestUs - edges[oldest & (FLOW_EDGE_RING - 1)];
+  float hzRaw = spanUs == 0 ? 0.0f : 1e6f * (float) (newest - oldest) / (float) spanUs;
+
+  // No edge for longer than the last period: the rate is at most 1 / gap
+  const float gapHz = gapUs == 0 ? hzRaw : 1e6f / (float) gapUs;
+  const bool decaying = gapHz < hzRaw;
+  if (decaying) hzRaw = gapHz;
+
+  if (!newEdges && !decaying) return false;
+  publish(now, hzRaw, dtMs, FLOW_RECIP_FILTER_TAU_MS);
   return true;
 }
 
+bool flowSensorUpdate() {
+  if (!s_initialized) return false;
+  const uint32_t now = millis();
+  return FLOW_RECIPROCAL ? updateReciprocal(now) : updateWindowed(now);
+}
+
 FlowReading flowSensorGet() {
   return s_lastReading;
 }
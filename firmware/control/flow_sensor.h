@@ -1,10 +1,15 @@
 /*
  * ================================================================
  *  Module: flow_sensor
- *  Purpose: Interrupt-driven reader for the YF-S201 flow sensor on
- *           the control unit. Counts pulses, converts to Hz and
- *           liters per minute, and provides a cached reading for
- *           the control loop logger.
+ *  Purpose: Reader for the YF-S201 flow sensor on the control
+ *           unit. Counts pulses, converts to Hz and liters per
+ *           minute, and provides a cached reading for the control
+ *           loop logger. Pulses are counted by the PCNT peripheral
+ *           (FLOW_USE_PCNT, no interrupts) or, as a fallback, by a
+ *           GPIO ISR per rising edge. With FLOW_RECIPROCAL the ISR
+ *           timestamps edges instead and the rate is taken from the
+ *           newest pulse periods, re-estimated on every pulse; a gap
+ *           of FLOW_ZERO_TIMEOUT_MS reads as zero flow.
  *  Interface:
  *    bool flowSensorInit();
  *    bool flowSensorUpdate();
@@ -19,17 +24,18 @@
 // Snapshot of the most recent flow measurement (YF-S201)
 struct FlowReading {
   float lpm;        // Filtered liters per minute (EMA)
-  float lpmRaw;     // Instantaneous liters per minute for the last window
+  float lpmRaw;     // Instantaneous liters per minute (last window, or newest periods)
   float Hz;         // Filtered pulse frequency (EMA)
-  float HzRaw;      // Instantaneous pulse frequency for the last window
+  float HzRaw;      // Instantaneous pulse frequency (last window, or newest periods)
   uint32_t sampleMs;
   bool fresh;  // true if updated on the latest window
 };
 
-// Initialize the flow sensor GPIO + interrupt handler
+// Initialize the flow sensor GPIO + PCNT unit (or interrupt handler)
 bool flowSensorInit();
 
-// Update measurement if the sampling window elapsed (call each loop)
+// Update measurement if the sampling window elapsed, or in reciprocal mode
+// if pulses arrived / the open gap lowered the rate (call each loop)
 bool flowSensorUpdate();
 
 // Return the last computed measurement (may be stale if no pulses)
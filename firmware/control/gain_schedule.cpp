@@ -0,0 +1,69 @@
+#include "gain_schedule.h"
+
+static_assert(GAIN_SCHED_FLOW_POINTS >= 1 && GAIN_SCHED_SET_POINTS >= 1, "Gain schedule table is empty");
+
+static float s_flowLpm = 0.0f;
+static bool s_seeded = false;
+static GainSet s_gains{};
+
+// Segment index and fraction for x on an ascending breakpoint axis, clamped at both ends
+static void locate(const float* axis, size_t n, float x, size_t& i, float& frac) {
+  if (n < 2 || x <= axis[0]) {
+    i = 0;
+    frac = 0.0f;
+    return;
+  }
+  if (x >= axis[n - 1]) {
+    i = n - 2;
+    frac = 1.0f;
+    return;
+  }
+  i = 0;
+  while (x > axis[i + 1]) i++;
+  frac = (x - axis[i]) / (axis[i + 1] - axis[i]);
+}
+
+static float bilerp(const float table[GAIN_SCHED_SET_POINTS][GAIN_SCHED_FLOW_POINTS],
+                    size_t si, float sf, size_t fi, float ff) {
+  const size_t si1 = (GAIN_SCHED_SET_POINTS > 1) ? si + 1 : si;
+  const size_t fi1 = (GAIN_SCHED_FLOW_POINTS > 1) ? fi + 1 : fi;
+  const float lo = table[si][fi] + (table[si][fi1] - table[si][fi]) * ff;
+  const float hi = table[si1][fi] + (table[si1][fi1] - table[si1][fi]) * ff;
+  return lo + (hi - lo) * sf;
+}
+
+void gainScheduleInit() {
+  s_flowLpm = 0.0f;
+  s_seeded = false;
+  s_gains = gainScheduleLookup(0.0f, GAIN_SCHED_SETPOINT_F[0]);
+}
+
+GainSet gainScheduleLookup(float flowLpm, float setpointF) {
+  size_t fi;
+  size_t si;
+  float ff;
+  float sf;
+  locate(GAIN_SCHED_FLOW_LPM, GAIN_SCHED_FLOW_POINTS, flowLpm, fi, ff);
+  locate(GAIN_SCHED_SETPOINT_F, GAIN_SCHED_SET_POINTS, setpointF, si, sf);
+
+  GainSet g;
+  g.kp = bilerp(GAIN_SCHED_KP, si, sf, fi, ff);
+  g.ki = bilerp(GAIN_SCHED_KI, si, sf, fi, ff);
+  g.kd = bilerp(GAIN_SCHED_KD, si, sf, fi, ff);
+  return g;
+}
+
+const GainSet& gainScheduleUpdate(float flowLpm, bool flowValid, float setpointF, float dtSec) {
+  const float target = flowValid ? flowLpm : 0.0f;
+  if (!s_seeded) {
+    s_flowLpm = target;
+    s_seeded = true;
+  } else if (dtSec > 0.0f) {
+    const float alpha = dtSec / (GAIN_SCHED_FLOW_TAU_S + dtSec);
+    s_flowLpm += alpha * (target - s_flowLpm);
+  }
+  s_gains = gainScheduleLookup(s_flowLpm, setpointF);
+  return s_gains;
+}
+
+float gainScheduleFlowLpm() { return s_flowLpm; }
@@ -0,0 +1,48 @@
+/*
+ * ================================================================
+ *  Module: gain_schedule
+ *  Purpose: Flow- and setpoint-scheduled PID gains. Kp/Ki/Kd are
+ *           bilinearly interpolated from the GAIN_SCHED_* tables in
+ *           config.h, indexed by a smoothed flow rate and the
+ *           setpoint, and clamped at the table edges. Interpolation
+ *           keeps the gains continuous across cell boundaries; the
+ *           PID applies them with setGainsBumpless() so the output
+ *           does not step when they change.
+ *
+ *           Missing flow (no pulses / sensor absent) decays toward
+ *           zero and so selects the lowest-flow (most conservative)
+ *           gains.
+ *
+ *  Dependencies:
+ *    - config.h  (GAIN_SCHED_*)
+ *
+ *  Interface:
+ *    void gainScheduleInit();
+ *    const GainSet& gainScheduleUpdate(float flowLpm, bool flowValid, float setpointF, float dtSec);
+ *    GainSet gainScheduleLookup(float flowLpm, float setpointF);
+ *    float gainScheduleFlowLpm();
+ * ================================================================
+ */
+
+#pragma once
+
+#include "config.h"
+
+struct GainSet {
+  float kp;
+  float ki;
+  float kd;
+};
+
+// Reset the flow filter (first update seeds it)
+void gainScheduleInit();
+
+// Advance the flow filter by dtSec and return the gains for the current
+// operating point. Call once per control step.
+const GainSet& gainScheduleUpdate(float flowLpm, bool flowValid, float setpointF, float dtSec);
+
+// Pure table lookup (no filtering)
+GainSet gainScheduleLookup(float flowLpm, float setpointF);
+
+// Filtered flow used for the last lookup (L/min)
+float gainScheduleFlowLpm();
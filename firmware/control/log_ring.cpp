@@ -0,0 +1,74 @@
+#include "log_ring.h"
+
+#include <atomic>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "spsc_ring.h"
+
+static SpscRing<LogRecord, LOG_RING_CAPACITY> s_ring;
+static std::atomic<uint32_t> s_pushed{0};   // producer-owned
+static std::atomic<uint32_t> s_drained{0};  // consumer-owned
+static LogSink s_sink{};
+
+bool logRingPush(const LogRecord& rec) {
+  if (!s_ring.push(rec)) return false;
+  s_pushed.store(s_pushed.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  return true;
+}
+
+size_t logRingDrain(const LogSink& sink, size_t maxRecords) {
+  if (!sink.write) return 0;
+
+  size_t n = 0;
+  LogRecord rec;
+  while (n < maxRecords) {
+    if (sink.ready && !sink.ready()) break;
+    if (!s_ring.pop(rec)) break;
+    sink.write(rec);
+    n++;
+  }
+  if (n > 0) {
+    s_drained.store(s_drained.load(std::memory_order_relaxed) + (uint32_t) n, std::memory_order_relaxed);
+  }
+  return n;
+}
+
+size_t logRingService() {
+  return logRingDrain(s_sink, LOG_RING_CAPACITY);
+}
+
+static void drainTask(void* arg) {
+  (void) arg;
+  const TickType_t periodTicks = pdMS_TO_TICKS(LOG_DRAIN_PERIOD_MS) > 0 ? pdMS_TO_TICKS(LOG_DRAIN_PERIOD_MS) : 1;
+  TickType_t lastWake = xTaskGetTickCount();
+  for (;;) {
+    (void) logRingService();
+    vTaskDelayUntil(&lastWake, periodTicks);
+  }
+}
+
+bool logRingStartDrainer(const LogSink& sink) {
+  s_sink = sink;
+  return xTaskCreatePinnedToCore(drainTask,
+                                 "logdrain",
+                                 LOG_DRAIN_STACK_BYTES,
+                                 nullptr,
+                                 LOG_DRAIN_PRIORITY,
+                                 nullptr,
+                                 LOG_DRAIN_CORE) == pdPASS;
+}
+
+LogRingStats logRingGetStats() {
+  LogRingStats st{};
+  st.pushed = s_pushed.load(std::memory_order_relaxed);
+  st.dropped = s_ring.dropped();
+  st.drained = s_drained.load(std::memory_order_relaxed);
+  st.highWater = s_ring.highWater();
+  st.depth = (uint32_t) s_ring.size();
+  return st;
+}
+
+void logRingResetStats() {
+  s_ring.resetCounters();
+}
@@ -0,0 +1,69 @@
+/*
+ * ================================================================
+ *  Module: log_ring
+ *  Purpose: Decouples logger output from the control path. The
+ *           control step only copies a LogRecord into a lock-free
+ *           SPSC ring (spsc_ring.h); a low-priority drainer writes
+ *           records to the sink whenever the sink can take one
+ *           without blocking. If the drainer falls behind, new
+ *           records are dropped and counted instead of stalling
+ *           actuation.
+ *
+ *           Exactly one consumer may drain the ring: the drainer
+ *           task in superloop mode, or the pipeline log stage.
+ *
+ *  Dependencies:
+ *    - config.h     (LOG_RING_*, LOG_DRAIN_*)
+ *    - pipeline.h   (LogRecord)
+ *    - FreeRTOS     (drainer task)
+ *
+ *  Interface:
+ *    bool logRingPush(const LogRecord& rec);
+ *    size_t logRingDrain(const LogSink& sink, size_t maxRecords);
+ *    bool logRingStartDrainer(const LogSink& sink);
+ *    size_t logRingService();
+ *    LogRingStats logRingGetStats();
+ *    void logRingResetStats();
+ * ================================================================
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "config.h"
+#include "pipeline.h"
+
+// Where drained records go
+struct LogSink {
+  bool (*ready)();                     // optional: true if write() will not block
+  void (*write)(const LogRecord& rec);
+};
+
+struct LogRingStats {
+  uint32_t pushed;     // records accepted from the control path
+  uint32_t dropped;    // records rejected because the ring was full
+  uint32_t drained;    // records handed to the sink
+  uint32_t highWater;  // deepest ring occupancy seen
+  uint32_t depth;      // current occupancy
+};
+
+// Producer side (control path). Non-blocking; false if the record was dropped.
+bool logRingPush(const LogRecord& rec);
+
+// Consumer side: hand up to maxRecords to the sink, stopping early while the
+// sink reports it is not ready. Returns the number written.
+size_t logRingDrain(const LogSink& sink, size_t maxRecords);
+
+// Superloop mode: remember the sink and start the low-priority drainer task
+bool logRingStartDrainer(const LogSink& sink);
+
+// One drainer pass with the sink given to logRingStartDrainer(). Called by the
+// drainer task; exposed so a host simulation can play the drainer.
+size_t logRingService();
+
+LogRingStats logRingGetStats();
+
+// Clear drop/high-water counters
+void logRingResetStats();
@@ -0,0 +1,155 @@
+#include "outlet_estimator.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "feedforward.h"
+
+// Modelled outlet temperature as it left the tee, tagged with cumulative
+// volume. 160 entries cover the pipe volume down to FF_MIN_FLOW_LPM at 10 Hz.
+struct PipeSample {
+  float volL;
+  float modelF;
+};
+
+static constexpr size_t kHistoryLen = 160;
+static PipeSample s_history[kHistoryLen];
+static size_t s_historyHead = 0;
+static size_t s_historyCount = 0;
+static float s_volL = 0.0f;
+
+static bool s_running = false;
+static bool s_primed = false;  // pipe flushed since restart
+static uint32_t s_lastSampleMs = 0;
+static float s_sensorF = 0.0f;  // state: sensor body temperature
+static float s_biasF = 0.0f;    // state: water at sensor minus delayed model
+static float s_P[2][2];         // state covariance
+static float s_estimateF = NAN;
+static float s_estimateStdF = NAN;
+
+static bool usable(const TemperatureReading& r) { return r.present && r.valid; }
+
+static void pushHistory(float volL, float modelF) {
+  s_historyHead = (s_historyHead + 1) % kHistoryLen;
+  s_history[s_historyHead] = PipeSample{volL, modelF};
+  if (s_historyCount < kHistoryLen) s_historyCount++;
+}
+
+// Newest entry that had left the tee by volL (oldest kept if none did)
+static float delayedModelF(float volL) {
+  size_t idx = s_historyHead;
+  for (size_t n = 0; n < s_historyCount; ++n) {
+    if (s_history[idx].volL <= volL) return s_history[idx].modelF;
+    if (n + 1 < s_historyCount) idx = (idx + kHistoryLen - 1) % kHistoryLen;
+  }
+  return s_history[idx].modelF;
+}
+
+// DS18B20 quantization (one LSB, uniform) plus sensor noise, in °F²
+static float measurementVariance(uint8_t bits) {
+  if (bits < 9 || bits > 12) bits = 9;
+  const float stepF = 0.1125f * (float) (1 << (12 - bits));
+  return stepF * stepF / 12.0f + EST_MEAS_NOISE_F * EST_MEAS_NOISE_F;
+}
+
+// Filter state pinned to the current reading, bias unknown
+static void resetState(const TemperatureReading& outlet) {
+  s_sensorF = outlet.rawF;
+  s_biasF = 0.0f;
+  memset(s_P, 0, sizeof(s_P));
+  s_P[0][0] = measurementVariance(outlet.resolution);
+  s_P[1][1] = EST_INIT_BIAS_STD_F * EST_INIT_BIAS_STD_F;
+}
+
+// What was in the pipe before the model started is unknown; the filter
+// only runs once one pipe volume of modelled water has reached the sensor.
+static void restart(const TemperatureReading& outlet) {
+  s_volL = 0.0f;
+  s_historyHead = 0;
+  s_historyCount = 0;
+  pushHistory(-FF_OUTLET_PIPE_L, outlet.rawF);
+  resetState(outlet);
+  s_running = true;
+  s_primed = false;
+}
+
+void outletEstimatorInit() {
+  s_running = false;
+  s_lastSampleMs = 0;
+  s_estimateF = NAN;
+  s_estimateStdF = NAN;
+}
+
+void outletEstimatorUpdate(TemperatureReading& outlet,
+                           const TemperatureReading& hot,
+                           const TemperatureReading& cold,
+                           float ratio,
+                           const FlowReading& flow) {
+  const bool newSample = outlet.sampleMs != 0 && outlet.sampleMs != s_lastSampleMs;
+  const bool modelOk = usable(outlet) && usable(hot) && usable(cold) && flow.sampleMs != 0 &&
+                       flow.lpm >= FF_MIN_FLOW_LPM;
+
+  if (!modelOk) {
+    // No flow or no line temperatures: fall back to the filtered reading
+    s_running = false;
+    s_lastSampleMs = outlet.sampleMs;
+    s_estimateF = NAN;
+    s_estimateStdF = NAN;
+    return;
+  }
+
+  if (newSample) {
+    const float dtSec = (s_running && s_lastSampleMs != 0) ? (outlet.sampleMs - s_lastSampleMs) / 1000.0f : 0.0f;
+    s_lastSampleMs = outlet.sampleMs;
+    if (!s_running) restart(outlet);
+
+    // Input: what the valves are mixing now enters the pipe. Volume uses the
+    // unfiltered window rate: the EMA'd lpm lags the start of flow by seconds.
+    s_volL += flow.lpmRaw * dtSec / 60.0f;
+    pushHistory(s_volL, feedforwardOutletForRatioF(ratio, hot.filteredF, cold.filteredF, flow.lpm));
+    if (!s_primed) {
+      if (s_volL < FF_OUTLET_PIPE_L) {
+        resetState(outlet);
+        s_estimateF = NAN;
+        s_estimateStdF = NAN;
+        return;
+      }
+      s_primed = true;
+    }
+    const float waterModelF = delayedModelF(s_volL - FF_OUTLET_PIPE_L);
+
+    // Predict: sensor relaxes toward (delayed model + bias); bias random walk
+    const float a = 1.0f - expf(-dtSec / EST_SENSOR_TAU_S);
+    s_sensorF += a * (waterModelF + s_biasF - s_sensorF);
+    const float p00 = s_P[0][0];
+    const float p01 = s_P[0][1];
+    const float p11 = s_P[1][1];
+    const float b = 1.0f - a;
+    s_P[0][0] = b * b * p00 + 2.0f * a * b * p01 + a * a * p11 + EST_SENSOR_NOISE_F2S * dtSec;
+    s_P[0][1] = b * p01 + a * p11;
+    s_P[1][0] = s_P[0][1];
+    s_P[1][1] = p11 + EST_BIAS_NOISE_F2S * dtSec;
+
+    // Correct with the raw reading (the EMA would add lag the model accounts for)
+    const float s = s_P[0][0] + measurementVariance(outlet.resolution);
+    const float k0 = s_P[0][0] / s;
+    const float k1 = s_P[1][0] / s;
+    const float innov = outlet.rawF - s_sensorF;
+    s_sensorF += k0 * innov;
+    s_biasF += k1 * innov;
+    const float q00 = s_P[0][0];
+    const float q01 = s_P[0][1];
+    s_P[0][0] = (1.0f - k0) * q00;
+    s_P[0][1] = (1.0f - k0) * q01;
+    s_P[1][0] = s_P[0][1];
+    s_P[1][1] -= k1 * q01;
+
+    s_estimateF = waterModelF + s_biasF;
+    s_estimateStdF = sqrtf(s_P[1][1] > 0.0f ? s_P[1][1] : 0.0f);
+  }
+
+  if (s_running && s_primed && !isnan(s_estimateF)) {
+    outlet.estimateF = s_estimateF;
+    outlet.estimateStdF = s_estimateStdF;
+  }
+}
@@ -0,0 +1,50 @@
+/*
+ * ================================================================
+ *  Module: outlet_estimator
+ *  Purpose: Kalman-style estimate of the water temperature at the
+ *           outlet sensor, ahead of the DS18B20's thermal lag.
+ *           Model per step:
+ *             - water now at the sensor = feedforward forward model
+ *               (commanded ratio, hot/cold lines, flow) as it left
+ *               the tee FF_OUTLET_PIPE_L litres ago, plus a slowly
+ *               wandering bias (valve curve / line sensor error);
+ *             - sensor body follows that water with a first-order
+ *               lag EST_SENSOR_TAU_S;
+ *             - measurement = sensor body + quantization/noise (per
+ *               sample resolution).
+ *           The estimate (model + bias) and its 1-sigma uncertainty
+ *           are written into the outlet TemperatureReading. Without
+ *           flow or usable line readings there is no model: the
+ *           filter restarts and estimateStdF stays NAN until one
+ *           pipe volume of modelled water has reached the sensor.
+ *
+ *  Dependencies:
+ *    - config.h        (EST_*, FF_OUTLET_PIPE_L, FF_MIN_FLOW_LPM)
+ *    - feedforward.h   (feedforwardOutletForRatioF)
+ *    - flow_sensor.h   (FlowReading)
+ *    - temperature.h   (TemperatureReading)
+ *
+ *  Interface:
+ *    void outletEstimatorInit();
+ *    void outletEstimatorUpdate(TemperatureReading& outlet, const TemperatureReading& hot,
+ *                               const TemperatureReading& cold, float ratio, const FlowReading& flow);
+ * ================================================================
+ */
+
+#pragma once
+
+#include "config.h"
+#include "flow_sensor.h"
+#include "temperature.h"
+
+// Clear the transport history and restart the filter on the next sample
+void outletEstimatorInit();
+
+// Run one predict/correct step when the outlet reading holds a new sample
+// (sampleMs changed); always fills outlet.estimateF / estimateStdF with the
+// latest estimate. ratio is the mix ratio currently commanded to the valves.
+void outletEstimatorUpdate(TemperatureReading& outlet,
+                           const TemperatureReading& hot,
+                           const TemperatureReading& cold,
+                           float ratio,
+                           const FlowReading& flow);
@@ -1,64 +1,145 @@
 #include "pid.h"
 
-PID::PID(float kp, float ki, float kd, float minOut, float maxOut)
-    : Kp(kp),
-      Ki(ki),
-      Kd(kd),
-      integral(0.0f),
-      outMin(minOut),
-      outMax(maxOut),
-      prevError(0.0f),
-      hasPrevError(false),
-      lastOutputValue(0.0f) {}
-
-float PID::update(float error, float dtSeconds) {
+template <typename T>
+T PIDT<T>::update(T error, T dtSeconds) {
   // Reset integrator on zero-crossing to limit overshoot around setpoint
-  if (hasPrevError && (error * prevError) < 0.0f) {
-    integral = 0.0f;
+  if (hasPrevError && (error * prevError) < T(0)) {
+    integral = T(0);
   }
 
-  float derivative = 0.0f;
-  if (dtSeconds > 0.0f && hasPrevError) {
+  T derivative = T(0);
+  if (dtSeconds > T(0) && hasPrevError) {
     derivative = (error - prevError) / dtSeconds;
   }
 
   // Conditional integration (anti-windup)
-  float proposedIntegral = integral + error * Ki * dtSeconds;
+  T proposedIntegral = integral + error * Ki * dtSeconds;
   proposedIntegral = constrain(proposedIntegral, outMin, outMax);
 
-  float provisionalOutput = Kp * error + proposedIntegral + Kd * derivative;
+  T provisionalOutput = Kp * error + proposedIntegral + Kd * derivative;
 
   // If output would saturate and integration would push further into saturation, freeze integrator
-  bool saturatingHigh = (provisionalOutput > outMax) && (error > 0.0f);
-  bool saturatingLow = (provisionalOutput < outMin) && (error < 0.0f);
+  bool saturatingHigh = (provisionalOutput > outMax) && (error > T(0));
+  bool saturatingLow = (provisionalOutput < outMin) && (error < T(0));
   if (!saturatingHigh && !saturatingLow) {
     integral = proposedIntegral;
   }
 
-  float output = Kp * error + integral + Kd * derivative;
+  T output = Kp * error + integral + Kd * derivative;
 
   prevError = error;
+  prevDerivative = derivative;
   hasPrevError = true;
 
   lastOutputValue = constrain(output, outMin, outMax);
   return lastOutputValue;
 }
 
-void PID::reset() {
-  integral = 0.0f;
-  prevError = 0.0f;
+template <typename T>
+void PIDT<T>::reset() {
+  integral = T(0);
+  prevError = T(0);
+  prevDerivative = T(0);
   hasPrevError = false;
-  lastOutputValue = 0.0f;
+  lastOutputValue = T(0);
 }
 
-void PID::setGains(float kp, float ki, float kd) {
+template <typename T>
+void PIDT<T>::setGains(T kp, T ki, T kd) {
   Kp = kp;
   Ki = ki;
   Kd = kd;
 }
 
-void PID::setOutputLimits(float minOut, float maxOut) {
+template <typename T>
+void PIDT<T>::setGainsBumpless(T kp, T ki, T kd) {
+  if (hasPrevError) {
+    integral += (Kp - kp) * prevError + (Kd - kd) * prevDerivative;
+    integral = constrain(integral, outMin, outMax);
+  }
+  setGains(kp, ki, kd);
+}
+
+template <typename T>
+void PIDT<T>::setOutputLimits(T minOut, T maxOut) {
   outMin = minOut;
   outMax = maxOut;
   integral = constrain(integral, outMin, outMax);
 }
+
+template class PIDT<float>;
+
+// ---------------------------------------------------------------------------
+// Q16.16 specialization
+// ---------------------------------------------------------------------------
+
+// Q16 limit widened to the Q32.32 integrator format
+static inline int64_t toQ32(Q16 v) { return (int64_t) v.raw * Q16::ONE; }
+
+IRAM_ATTR Q16 PIDT<Q16>::update(Q16 error, Q16 dtSeconds) {
+  // Reset integrator on zero-crossing to limit overshoot around setpoint
+  if (hasPrevError && ((error.raw > 0 && prevError.raw < 0) || (error.raw < 0 && prevError.raw > 0))) {
+    integral = 0;
+  }
+
+  // de / dt: Q16 * 2^16 / Q16 = Q16. Skipped (no divide) when Kd == 0.
+  Q16 derivative = Q16::fromRaw(0);
+  if (Kd.raw != 0 && dtSeconds.raw > 0 && hasPrevError) {
+    const int64_t d = ((int64_t) (error.raw - prevError.raw) * Q16::ONE) / dtSeconds.raw;
+    derivative = Q16::fromRaw(d > INT32_MAX ? INT32_MAX : d < INT32_MIN ? INT32_MIN : (int32_t) d);
+  }
+  const int64_t dTerm = q16Mul(Kd, derivative).raw;
+
+  // Conditional integration (anti-windup); error*dt is Q16, times Ki gives Q32
+  const int64_t errDt = q16RoundShift((int64_t) error.raw * dtSeconds.raw, Q16::FRAC_BITS);
+  int64_t proposedIntegral = integral + errDt * Ki.raw;
+  proposedIntegral = constrain(proposedIntegral, toQ32(outMin), toQ32(outMax));
+
+  const int64_t pTerm = q16RoundShift((int64_t) Kp.raw * error.raw, Q16::FRAC_BITS);
+  const int64_t provisionalOutput = pTerm + q16RoundShift(proposedIntegral, Q16::FRAC_BITS) + dTerm;
+
+  // If output would saturate and integration would push further into saturation, freeze integrator
+  bool saturatingHigh = (provisionalOutput > outMax.raw) && (error.raw > 0);
+  bool saturatingLow = (provisionalOutput < outMin.raw) && (error.raw < 0);
+  if (!saturatingHigh && !saturatingLow) {
+    integral = proposedIntegral;
+  }
+
+  const int64_t output = pTerm + q16RoundShift(integral, Q16::FRAC_BITS) + dTerm;
+
+  prevError = error;
+  prevDerivative = derivative;
+  hasPrevError = true;
+
+  lastOutputValue = Q16::fromRaw((int32_t) constrain(output, (int64_t) outMin.raw, (int64_t) outMax.raw));
+  return lastOutputValue;
+}
+
+void PIDT<Q16>::reset() {
+  integral = 0;
+  prevError = Q16::fromRaw(0);
+  prevDerivative = Q16::fromRaw(0);
+  hasPrevError = false;
+  lastOutputValue = Q16::fromRaw(0);
+}
+
+void PIDT<Q16>::setGains(Q16 kp, Q16 ki, Q16 kd) {
+  Kp = kp;
+  Ki = ki;
+  Kd = kd;
+}
+
+void PIDT<Q16>::setGainsBumpless(Q16 kp, Q16 ki, Q16 kd) {
+  if (hasPrevError) {
+    // P/D correction formed in Q32 to match the integrator
+    integral += (int64_t) (Kp.raw - kp.raw) * prevError.raw + (int64_t) (Kd.raw - kd.raw) * prevDerivative.raw;
+    integral = constrain(integral, toQ32(outMin), toQ32(outMax));
+  }
+  setGains(kp, ki, kd);
+}
+
+void PIDT<Q16>::setOutputLimits(Q16 minOut, Q16 maxOut) {
+  outMin = minOut;
+  outMax = maxOut;
+  integral = constrain(integral, toQ32(outMin), toQ32(outMax));
+}
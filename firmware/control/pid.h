@@ -5,15 +5,27 @@
  *           ratio. Integrates error, computes a derivative term,
  *           and clamps output to the allowed range (windup guard).
  *
+ *           PIDT<T> is templated over the numeric type. PID is the
+ *           float controller used by the loop; PIDT<Q16> is an
+ *           integer-only Q16.16 specialization with the same
+ *           behaviour, cheap and FPU-free so it can run from an ISR
+ *           or at much higher rates. Its constexpr constructor scales
+ *           float gains/limits at compile time (PID_Q16_* below).
+ *
  *  Dependencies:
- *    - Arduino.h (constrain helper)
+ *    - Arduino.h      (constrain helper, IRAM_ATTR)
+ *    - config.h       (PID_* constants for the Q16 copies)
+ *    - fixed_point.h  (Q16)
  *
  *  Interface:
- *    PID(float kp, float ki, float kd, float minOut, float maxOut);
- *    float update(float error, float dtSeconds);
+ *    PIDT<T>(kp, ki, kd, minOut, maxOut);
+ *    T update(T error, T dtSeconds);
+ *    T lastOutput() const;
  *    void reset();
- *    void setGains(float kp, float ki, float kd);
- *    void setOutputLimits(float minOut, float maxOut);
+ *    void setGains(T kp, T ki, T kd);
+ *    void setGainsBumpless(T kp, T ki, T kd);
+ *    void setOutputLimits(T minOut, T maxOut);
+ *    using PID = PIDT<float>;
  * ================================================================
  */
 
@@ -21,34 +33,107 @@
 
 #include <Arduino.h>
 
+#include "config.h"
+#include "fixed_point.h"
+
 // PID controller used to drive the hot/cold valve mix ratio.
-class PID {
+// Implemented in pid.cpp; instantiated for float.
+template <typename T>
+class PIDT {
  public:
-  PID(float kp, float ki, float kd, float minOut, float maxOut);
+  constexpr PIDT(T kp, T ki, T kd, T minOut, T maxOut)
+      : Kp(kp), Ki(ki), Kd(kd), integral(0), outMin(minOut), outMax(maxOut), prevError(0), prevDerivative(0), hasPrevError(false), lastOutputValue(0) {}
 
   // Update controller state with new error measurement and timestep (seconds).
-  float update(float error, float dtSeconds);
+  T update(T error, T dtSeconds);
 
   // Last output returned by update()
-  float lastOutput() const { return lastOutputValue; }
+  T lastOutput() const { return lastOutputValue; }
 
-  float getKp() const { return Kp; }
-  float getKi() const { return Ki; }
+  T getKp() const { return Kp; }
+  T getKi() const { return Ki; }
 
   // Reset integrator to zero (useful when disabling control loop).
   void reset();
 
-  void setGains(float kp, float ki, float kd);
-  void setOutputLimits(float minOut, float maxOut);
+  void setGains(T kp, T ki, T kd);
+
+  // Change gains without stepping the output (gain scheduling): the integrator
+  // absorbs the change in the P and D terms at the last error. The integral
+  // already holds Ki-weighted error, so a Ki change needs no correction.
+  void setGainsBumpless(T kp, T ki, T kd);
+
+  void setOutputLimits(T minOut, T maxOut);
 
  private:
-  float Kp;
-  float Ki;
-  float Kd;
-  float integral;
-  float outMin;
-  float outMax;
-  float prevError;
+  T Kp;
+  T Ki;
+  T Kd;
+  T integral;
+  T outMin;
+  T outMax;
+  T prevError;
+  T prevDerivative;
   bool hasPrevError;
-  float lastOutputValue;
+  T lastOutputValue;
 };
+
+// Q16.16 specialization. Same algorithm as the float version; products are
+// formed in 64 bits and the integrator keeps 32 fractional bits, so slow
+// integration at small errors is not lost to rounding. update() is placed in
+// IRAM and uses no floating point. Inputs must keep error·dt and the
+// output terms well inside ±32768 (the shower loop: |error| < 200 °F, dt ≈ 0.1 s).
+template <>
+class PIDT<Q16> {
+ public:
+  constexpr PIDT(Q16 kp, Q16 ki, Q16 kd, Q16 minOut, Q16 maxOut)
+      : Kp(kp), Ki(ki), Kd(kd), integral(0), outMin(minOut), outMax(maxOut), prevError{0}, prevDerivative{0}, hasPrevError(false), lastOutputValue{0} {}
+
+  // Float gains/limits, converted once; constant-initialized when the
+  // arguments are constant expressions.
+  constexpr PIDT(float kp, float ki, float kd, float minOut, float maxOut)
+      : PIDT(Q16::fromFloat(kp), Q16::fromFloat(ki), Q16::fromFloat(kd), Q16::fromFloat(minOut), Q16::fromFloat(maxOut)) {}
+
+  Q16 update(Q16 error, Q16 dtSeconds);
+
+  Q16 lastOutput() const { return lastOutputValue; }
+
+  Q16 getKp() const { return Kp; }
+  Q16 getKi() const { return Ki; }
+
+  void reset();
+
+  void setGains(Q16 kp, Q16 ki, Q16 kd);
+  void setGainsBumpless(Q16 kp, Q16 ki, Q16 kd);
+  void setOutputLimits(Q16 minOut, Q16 maxOut);
+
+ private:
+  Q16 Kp;
+  Q16 Ki;
+  Q16 Kd;
+  int64_t integral;  // Q32.32
+  Q16 outMin;
+  Q16 outMax;
+  Q16 prevError;
+  Q16 prevDerivative;  // only tracked while Kd != 0
+  bool hasPrevError;
+  Q16 lastOutputValue;
+};
+
+extern template class PIDT<float>;
+
+using PID = PIDT<float>;
+using PIDQ16 = PIDT<Q16>;
+
+// Controller constants from config.h, scaled to Q16.16 at compile time
+constexpr Q16 PID_Q16_KP = Q16::fromFloat(PID_KP);
+constexpr Q16 PID_Q16_KI = Q16::fromFloat(PID_KI);
+constexpr Q16 PID_Q16_KD = Q16::fromFloat(PID_KD);
+constexpr Q16 PID_Q16_OUT_MIN = Q16::fromFloat(PID_OUT_MIN);
+constexpr Q16 PID_Q16_OUT_MAX = Q16::fromFloat(PID_OUT_MAX);
+constexpr Q16 PID_Q16_ERROR_DEADBAND = Q16::fromFloat(PID_ERROR_DEADBAND_F);
+
+static_assert(PID_KP == 0.0f || PID_Q16_KP.raw != 0, "PID_KP below Q16.16 resolution");
+static_assert(PID_KI == 0.0f || PID_Q16_KI.raw != 0, "PID_KI below Q16.16 resolution");
+static_assert(PID_KD == 0.0f || PID_Q16_KD.raw != 0, "PID_KD below Q16.16 resolution");
+static_assert(PID_Q16_OUT_MIN < PID_Q16_OUT_MAX, "PID output limits collapse in Q16.16");
@@ -0,0 +1,227 @@
+#include "pipeline.h"
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/portmacro.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "log_ring.h"
+
+static const PipelineStageConfig kStageConfig[PIPELINE_STAGE_COUNT] = {
+    {"sensor", PIPE_SENSOR_PERIOD_MS, PIPE_SENSOR_CORE, PIPE_SENSOR_PRIORITY},
+    {"control", PIPE_CONTROL_PERIOD_MS, PIPE_CONTROL_CORE, PIPE_CONTROL_PRIORITY},
+    {"comm", PIPE_COMM_PERIOD_MS, PIPE_COMM_CORE, PIPE_COMM_PRIORITY},
+    {"log", PIPE_LOG_PERIOD_MS, PIPE_LOG_CORE, PIPE_LOG_PRIORITY},
+};
+
+static PipelineHooks s_hooks{};
+static QueueHandle_t s_sensorQueue = nullptr;  // sensor → control
+static QueueHandle_t s_cmdQueue = nullptr;     // comm → control
+
+// Latest frame seen by the control stage (re-used when no new frame arrived)
+static SensorFrame s_lastFrame{};
+static bool s_haveFrame = false;
+
+static PipelineStageStats s_stats[PIPELINE_STAGE_COUNT];
+
+// Protects s_stats (written from both cores, read from anywhere)
+static portMUX_TYPE s_statsMux = portMUX_INITIALIZER_UNLOCKED;
+
+static constexpr size_t stageIndex(PipelineStage stage) {
+  return static_cast<size_t>(stage);
+}
+
+static void countDrop(PipelineStage stage) {
+  portENTER_CRITICAL(&s_statsMux);
+  s_stats[stageIndex(stage)].queueDrops++;
+  portEXIT_CRITICAL(&s_statsMux);
+}
+
+static void runSensor() {
+  SensorFrame frame{};
+  if (!s_hooks.sense || !s_hooks.sense(frame)) return;
+
+  frame.sampleUs = esp_timer_get_time();
+  if (xQueueSend(s_sensorQueue, &frame, 0) != pdTRUE) {
+    countDrop(PipelineStage::SENSOR);
+  }
+}
+
+static void runComm() {
+  CommCommand cmd{};
+  if (!s_hooks.comm || !s_hooks.comm(cmd)) return;
+
+  if (xQueueSend(s_cmdQueue, &cmd, 0) != pdTRUE) {
+    countDrop(PipelineStage::COMM);
+  }
+}
+
+// Returns the capture timestamp of the frame used, or 0 if no frame yet
+static int64_t runControl() {
+  // Keep only the newest sensor frame
+  SensorFrame frame;
+  while (xQueueReceive(s_sensorQueue, &frame, 0) == pdTRUE) {
+    s_lastFrame = frame;
+    s_haveFrame = true;
+  }
+  if (!s_haveFrame || !s_hooks.control) return 0;
+
+  // Commands carry absolute state (setpoint + run flag), so the newest one wins
+  CommCommand cmd{};
+  CommCommand next;
+  bool haveCmd = false;
+  while (xQueueReceive(s_cmdQueue, &next, 0) == pdTRUE) {
+    if (next.lastOk || !haveCmd) cmd = next;
+    haveCmd = true;
+  }
+
+  s_hooks.control(s_lastFrame, haveCmd ? &cmd : nullptr);
+  return s_lastFrame.sampleUs;
+}
+
+// The log stage is the log ring's only consumer in pipeline mode
+static void runLog() {
+  const LogSink sink{.ready = s_hooks.logReady, .write = s_hooks.log};
+  (void) logRingDrain(sink, LOG_RING_CAPACITY);
+}
+
+void pipelineRunStage(PipelineStage stage, int64_t releaseUs) {
+  const size_t idx = stageIndex(stage);
+  if (idx >= PIPELINE_STAGE_COUNT) return;
+
+  const int64_t startUs = esp_timer_get_time();
+  int64_t sampleUs = 0;
+
+  switch (stage) {
+    case PipelineStage::SENSOR:
+      runSensor();
+      break;
+    case PipelineStage::CONTROL:
+      sampleUs = runControl();
+      break;
+    case PipelineStage::COMM:
+      runComm();
+      break;
+    case PipelineStage::LOG:
+    default:
+      runLog();
+      break;
+  }
+
+  const int64_t endUs = esp_timer_get_time();
+  const uint32_t jitterUs = (startUs > releaseUs) ? (uint32_t) (startUs - releaseUs) : 0;
+  const uint32_t execUs = (uint32_t) (endUs - startUs);
+  const uint32_t periodUs = kStageConfig[idx].periodMs * 1000UL;
+
+  portENTER_CRITICAL(&s_statsMux);
+  PipelineStageStats& st = s_stats[idx];
+  st.runs++;
+  if (jitterUs >= periodUs) st.overruns++;
+  if (jitterUs > st.jitterMaxUs) st.jitterMaxUs = jitterUs;
+  st.jitterSumUs += jitterUs;
+  if (execUs > st.execMaxUs) st.execMaxUs = execUs;
+  st.execSumUs += execUs;
+  if (sampleUs != 0 && endUs > sampleUs) {
+    const uint32_t latencyUs = (uint32_t) (endUs - sampleUs);
+    if (latencyUs > st.latencyMaxUs) st.latencyMaxUs = latencyUs;
+    st.latencySumUs += latencyUs;
+  }
+  portEXIT_CRITICAL(&s_statsMux);
+}
+
+int64_t pipelineNextReleaseUs(PipelineStage stage, int64_t releaseUs) {
+  size_t idx = stageIndex(stage);
+  if (idx >= PIPELINE_STAGE_COUNT) idx = 0;
+  const int64_t periodUs = (int64_t) kStageConfig[idx].periodMs * 1000;
+  if (stage != PipelineStage::SENSOR || !s_hooks.senseDueMs) return releaseUs + periodUs;
+
+  // millis() counts whole milliseconds of esp_timer time
+  const int64_t nowUs = esp_timer_get_time();
+  const uint32_t nowMs = (uint32_t) (nowUs / 1000);
+  int64_t dueUs = nowUs - nowUs % 1000 + (int64_t) (int32_t) (s_hooks.senseDueMs() - nowMs) * 1000;
+  // Its own reads are not release jitter: a read already due runs next
+  if (dueUs < nowUs) dueUs = nowUs;
+  if (dueUs < releaseUs + 1000) dueUs = releaseUs + 1000;
+  return (dueUs < releaseUs + periodUs) ? dueUs : releaseUs + periodUs;
+}
+
+static void stageTask(void* arg) {
+  const PipelineStage stage = static_cast<PipelineStage>((uintptr_t) arg);
+  const uint32_t periodMs = kStageConfig[stageIndex(stage)].periodMs;
+  const TickType_t periodTicks = pdMS_TO_TICKS(periodMs) > 0 ? pdMS_TO_TICKS(periodMs) : 1;
+  const bool dueDriven = (stage == PipelineStage::SENSOR) && s_hooks.senseDueMs;
+
+  // Anchor the ideal release grid to the first tick-aligned wake-up
+  TickType_t lastWake = xTaskGetTickCount();
+  vTaskDelayUntil(&lastWake, periodTicks);
+  int64_t releaseUs = esp_timer_get_time();
+
+  for (;;) {
+    pipelineRunStage(stage, releaseUs);
+    releaseUs = pipelineNextReleaseUs(stage, releaseUs);
+    if (dueDriven) {
+      // A read already due (the next sensor of a batch) only yields the core
+      const int64_t waitUs = releaseUs - esp_timer_get_time();
+      vTaskDelay(waitUs > 0 ? pdMS_TO_TICKS((uint32_t) ((waitUs + 999) / 1000)) : 0);
+    } else {
+      vTaskDelayUntil(&lastWake, periodTicks);
+    }
+  }
+}
+
+void pipelineInit(const PipelineHooks& hooks) {
+  s_hooks = hooks;
+  s_haveFrame = false;
+
+  if (!s_sensorQueue) s_sensorQueue = xQueueCreate(PIPE_SENSOR_QUEUE_LEN, sizeof(SensorFrame));
+  if (!s_cmdQueue) s_cmdQueue = xQueueCreate(PIPE_CMD_QUEUE_LEN, sizeof(CommCommand));
+
+  pipelineResetStats();
+}
+
+bool pipelineStart() {
+  if (!s_sensorQueue || !s_cmdQueue) return false;
+
+  for (size_t idx = 0; idx < PIPELINE_STAGE_COUNT; ++idx) {
+    const PipelineStageConfig& cfg = kStageConfig[idx];
+    const BaseType_t ok = xTaskCreatePinnedToCore(stageTask,
+                                                  cfg.name,
+                                                  PIPE_TASK_STACK_BYTES,
+                                                  (void*) (uintptr_t) idx,
+                                                  cfg.priority,
+                                                  nullptr,
+                                                  cfg.core);
+    if (ok != pdPASS) return false;
+  }
+  return true;
+}
+
+bool pipelinePostLog(const LogRecord& rec) {
+  if (logRingPush(rec)) return true;
+  countDrop(PipelineStage::CONTROL);
+  return false;
+}
+
+const PipelineStageConfig& pipelineStageConfig(PipelineStage stage) {
+  size_t idx = stageIndex(stage);
+  if (idx >= PIPELINE_STAGE_COUNT) idx = 0;
+  return kStageConfig[idx];
+}
+
+PipelineStageStats pipelineGetStats(PipelineStage stage) {
+  size_t idx = stageIndex(stage);
+  if (idx >= PIPELINE_STAGE_COUNT) idx = 0;
+  portENTER_CRITICAL(&s_statsMux);
+  const PipelineStageStats st = s_stats[idx];
+  portEXIT_CRITICAL(&s_statsMux);
+  return st;
+}
+
+void pipelineResetStats() {
+  portENTER_CRITICAL(&s_statsMux);
+  memset(s_stats, 0, sizeof(s_stats));
+  portEXIT_CRITICAL(&s_statsMux);
+}
@@ -0,0 +1,146 @@
+/*
+ * ================================================================
+ *  Module: pipeline
+ *  Purpose: Optional task-based execution mode for the control
+ *           unit. Splits the superloop into sensor, control, comm
+ *           and logging stages, each a FreeRTOS task pinned to a
+ *           core and connected by bounded queues (log records go
+ *           through the lock-free log_ring). The control task
+ *           runs at a fixed period; the sensor task wakes when its
+ *           next read is due (at most one period apart). Release
+ *           jitter, execution time and sample-to-actuation latency
+ *           are measured per stage.
+ *
+ *  Dependencies:
+ *    - config.h                  (PIPE_* periods, cores, priorities)
+ *    - FreeRTOS (task + queue), esp_timer (µs timestamps)
+ *
+ *  Interface:
+ *    void pipelineInit(const PipelineHooks& hooks);
+ *    bool pipelineStart();
+ *    void pipelineRunStage(PipelineStage stage, int64_t releaseUs);
+ *    int64_t pipelineNextReleaseUs(PipelineStage stage, int64_t releaseUs);
+ *    bool pipelinePostLog(const LogRecord& rec);
+ *    const PipelineStageConfig& pipelineStageConfig(PipelineStage stage);
+ *    PipelineStageStats pipelineGetStats(PipelineStage stage);
+ *    void pipelineResetStats();
+ * ================================================================
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "communication.h"
+#include "config.h"
+#include "flow_sensor.h"
+#include "temperature.h"
+
+enum class PipelineStage : uint8_t {
+  SENSOR = 0,
+  CONTROL,
+  COMM,
+  LOG,
+  COUNT,
+};
+
+constexpr size_t PIPELINE_STAGE_COUNT = static_cast<size_t>(PipelineStage::COUNT);
+
+// Snapshot of all sensor inputs handed from the sensor stage to the control stage
+struct SensorFrame {
+  TemperatureReading hot;
+  TemperatureReading cold;
+  TemperatureReading outlet;
+  FlowReading flow;
+  bool estop;
+  int64_t sampleUs;  // esp_timer timestamp when the frame was captured
+};
+
+// One logger/telemetry record produced by the control step
+struct LogRecord {
+  uint32_t ms;
+  float setpointF;
+  float outletRawF;
+  float outletFiltF;
+  float ratio;
+  float u;
+  float kp;
+  float ki;
+  float flowLpm;
+  bool linkOk;
+  // Telemetry-only fields (not in the CSV columns)
+  float hotF;
+  float coldF;
+  uint16_t hotUs;   // last commanded servo pulse widths
+  uint16_t coldUs;
+  uint8_t fault;    // FaultCode in control.ino
+  bool runFlag;
+  bool estop;
+  bool outletValid;
+  bool hotValid;
+  bool coldValid;
+  bool flowValid;
+  int8_t linkRssiDbm;  // UI → Control link (commLinkQuality)
+  float linkLossPct;
+  float linkDupPct;
+};
+
+// Stage bodies supplied by control.ino (or a host simulation)
+struct PipelineHooks {
+  bool (*sense)(SensorFrame& out);                              // sample sensors; true if anything new
+  bool (*comm)(CommCommand& out);                               // poll the radio; true if a command arrived
+  void (*control)(const SensorFrame& frame,                     // one control step
+                  const CommCommand* cmd);                      //   cmd == nullptr when none pending
+  void (*log)(const LogRecord& rec);                            // write one record to the log sink
+  bool (*logReady)();                                           // optional: log() would not block
+  uint32_t (*senseDueMs)();                                     // optional: millis() of the next sensor read
+};
+
+// Static scheduling parameters for a stage
+struct PipelineStageConfig {
+  const char* name;
+  uint32_t periodMs;
+  uint8_t core;
+  uint8_t priority;
+};
+
+// Timing statistics for a stage (µs)
+struct PipelineStageStats {
+  uint32_t runs;
+  uint32_t overruns;       // activations that started a full period late
+  uint32_t jitterMaxUs;    // worst start delay relative to the ideal release
+  uint64_t jitterSumUs;
+  uint32_t execMaxUs;
+  uint64_t execSumUs;
+  uint32_t latencyMaxUs;   // control only: sensor capture → end of control step
+  uint64_t latencySumUs;
+  uint32_t queueDrops;     // items dropped because the downstream queue was full
+};
+
+// Create the inter-stage queues and remember the stage bodies
+void pipelineInit(const PipelineHooks& hooks);
+
+// Spawn the pinned FreeRTOS tasks (returns false if any task/queue failed)
+bool pipelineStart();
+
+// Execute one activation of a stage. Called by the stage tasks; exposed so a
+// host-side scheduler simulation can drive the same code.
+void pipelineRunStage(PipelineStage stage, int64_t releaseUs);
+
+// Ideal release after the one at releaseUs: one period later, or for the
+// sensor stage (with senseDueMs) when the next read is due or now, whichever is
+// later, but at least one tick after releaseUs and at most one period after it
+int64_t pipelineNextReleaseUs(PipelineStage stage, int64_t releaseUs);
+
+// Push a logger record from the control stage into the log ring (non-blocking; false if dropped)
+bool pipelinePostLog(const LogRecord& rec);
+
+// Scheduling parameters from config.h
+const PipelineStageConfig& pipelineStageConfig(PipelineStage stage);
+
+// Copy of the current timing statistics for a stage
+PipelineStageStats pipelineGetStats(PipelineStage stage);
+
+// Clear all timing statistics
+void pipelineResetStats();
@@ -0,0 +1,135 @@
+#include "profiler.h"
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/portmacro.h"
+
+// Log-linear buckets: values 0..3 map 1:1, every power of two above that is
+// split into 4 equal sub-buckets (≤25% relative error on percentiles).
+static constexpr uint32_t kSubBuckets = 4;
+static constexpr uint32_t kSubBits = 2;
+static constexpr size_t kBucketCount = kSubBuckets + (32 - kSubBits) * kSubBuckets;
+
+struct StageHistogram {
+  uint32_t buckets[kBucketCount];
+  uint32_t count;
+  uint32_t minCycles;
+  uint32_t maxCycles;
+  uint64_t sumCycles;
+};
+
+static const char* const kStageNames[PROF_STAGE_COUNT] = {
+    "temp", "flow", "comm", "pid", "mix", "log", "loop",
+};
+
+static StageHistogram s_hist[PROF_STAGE_COUNT];
+
+// Recording can happen from the pipeline tasks on both cores
+static portMUX_TYPE s_profMux = portMUX_INITIALIZER_UNLOCKED;
+
+static constexpr size_t stageIndex(ProfStage stage) {
+  return static_cast<size_t>(stage);
+}
+
+static size_t bucketFor(uint32_t cycles) {
+  if (cycles < kSubBuckets) return cycles;
+  const uint32_t octave = 31 - __builtin_clz(cycles);  // ≥ kSubBits
+  const uint32_t sub = (cycles >> (octave - kSubBits)) & (kSubBuckets - 1);
+  return kSubBuckets + (octave - kSubBits) * kSubBuckets + sub;
+}
+
+// Largest value that falls into a bucket
+static uint32_t bucketUpper(size_t bucket) {
+  if (bucket < kSubBuckets) return (uint32_t) bucket;
+  const uint32_t octave = (uint32_t) (bucket - kSubBuckets) / kSubBuckets + kSubBits;
+  const uint32_t sub = (uint32_t) (bucket - kSubBuckets) % kSubBuckets;
+  const uint32_t width = 1UL << (octave - kSubBits);
+  const uint64_t lower = (uint64_t) (kSubBuckets + sub) << (octave - kSubBits);
+  const uint64_t upper = lower + width - 1;
+  return upper > UINT32_MAX ? UINT32_MAX : (uint32_t) upper;
+}
+
+void profilerRecord(ProfStage stage, uint32_t cycles) {
+  const size_t idx = stageIndex(stage);
+  if (idx >= PROF_STAGE_COUNT) return;
+  const size_t bucket = bucketFor(cycles);
+
+  portENTER_CRITICAL(&s_profMux);
+  StageHistogram& h = s_hist[idx];
+  if (h.count == 0 || cycles < h.minCycles) h.minCycles = cycles;
+  if (cycles > h.maxCycles) h.maxCycles = cycles;
+  h.sumCycles += cycles;
+  h.count++;
+  h.buckets[bucket]++;
+  portEXIT_CRITICAL(&s_profMux);
+}
+
+bool profilerGetSummary(ProfStage stage, ProfilerSummary& out) {
+  const size_t idx = stageIndex(stage);
+  if (idx >= PROF_STAGE_COUNT) return false;
+
+  StageHistogram snap;
+  portENTER_CRITICAL(&s_profMux);
+  snap = s_hist[idx];
+  portEXIT_CRITICAL(&s_profMux);
+
+  if (snap.count == 0) return false;
+
+  out.count = snap.count;
+  out.minCycles = snap.minCycles;
+  out.maxCycles = snap.maxCycles;
+  out.meanCycles = (uint32_t) (snap.sumCycles / snap.count);
+
+  // First bucket whose cumulative count reaches 99% of the samples
+  const uint64_t target = ((uint64_t) snap.count * 99 + 99) / 100;
+  uint64_t seen = 0;
+  out.p99Cycles = snap.maxCycles;
+  for (size_t b = 0; b < kBucketCount; ++b) {
+    seen += snap.buckets[b];
+    if (seen >= target) {
+      out.p99Cycles = min(bucketUpper(b), snap.maxCycles);
+      break;
+    }
+  }
+  return true;
+}
+
+void profilerReset() {
+  portENTER_CRITICAL(&s_profMux);
+  memset(s_hist, 0, sizeof(s_hist));
+  portEXIT_CRITICAL(&s_profMux);
+}
+
+void profilerDump() {
+  const float cyclesPerUs = (float) getCpuFrequencyMhz();
+
+  Serial.printf("# profiler (%lu MHz) stage count min/mean/p99/max cycles | us\n",
+                (unsigned long) getCpuFrequencyMhz());
+  for (size_t idx = 0; idx < PROF_STAGE_COUNT; ++idx) {
+    ProfilerSummary s{};
+    if (!profilerGetSummary(static_cast<ProfStage>(idx), s)) {
+      Serial.printf("# %-5s 0\n", kStageNames[idx]);
+      continue;
+    }
+    Serial.printf("# %-5s %lu %lu/%lu/%lu/%lu | %.1f/%.1f/%.1f/%.1f\n",
+                  kStageNames[idx],
+                  (unsigned long) s.count,
+                  (unsigned long) s.minCycles,
+                  (unsigned long) s.meanCycles,
+                  (unsigned long) s.p99Cycles,
+                  (unsigned long) s.maxCycles,
+                  s.minCycles / cyclesPerUs,
+                  s.meanCycles / cyclesPerUs,
+                  s.p99Cycles / cyclesPerUs,
+                  s.maxCycles / cyclesPerUs);
+  }
+
+  ProfilerSummary loop{};
+  if (profilerGetSummary(ProfStage::LOOP, loop)) {
+    Serial.printf("# loop p99 %.1f us of %u us budget (%.1f%%)\n",
+                  loop.p99Cycles / cyclesPerUs,
+                  PROFILER_LOOP_BUDGET_US,
+                  100.0f * loop.p99Cycles / cyclesPerUs / PROFILER_LOOP_BUDGET_US);
+  }
+}
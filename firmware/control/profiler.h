@@ -0,0 +1,80 @@
+/*
+ * ================================================================
+ *  Module: profiler
+ *  Purpose: Lightweight per-stage CPU cycle profiler for the control
+ *           loop. Each stage feeds a fixed-size log-linear histogram
+ *           (4 buckets per power of two) plus exact min/max/sum, so
+ *           memory is constant and recording is O(1). Summaries
+ *           report min/mean/p99/max in cycles and µs.
+ *
+ *  Dependencies:
+ *    - config.h   (PROFILER_ENABLED, PROFILER_LOOP_BUDGET_US)
+ *    - Arduino    (ESP.getCycleCount, getCpuFrequencyMhz, Serial)
+ *
+ *  Interface:
+ *    uint32_t profilerCycles();
+ *    void profilerRecord(ProfStage stage, uint32_t cycles);
+ *    bool profilerGetSummary(ProfStage stage, ProfilerSummary& out);
+ *    void profilerReset();
+ *    void profilerDump();
+ *    class ProfileScope;   // RAII start/stop around a stage
+ * ================================================================
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "config.h"
+
+// Instrumented stages of the control loop
+enum class ProfStage : uint8_t {
+  TEMP = 0,  // temperatureService() incl. scratchpad reads
+  FLOW,      // flowSensorUpdate()
+  COMM,      // commPollCommand()
+  PID,       // PID::update()
+  MIX,       // applyMixFlow()
+  LOG,       // logCsvIfDue()
+  LOOP,      // one full control pass (excluding the idle delay)
+  COUNT,
+};
+
+constexpr size_t PROF_STAGE_COUNT = static_cast<size_t>(ProfStage::COUNT);
+
+struct ProfilerSummary {
+  uint32_t count;
+  uint32_t minCycles;
+  uint32_t meanCycles;
+  uint32_t p99Cycles;  // upper edge of the bucket holding the 99th percentile
+  uint32_t maxCycles;
+};
+
+// Free-running CPU cycle counter (wraps; differences are valid up to ~17 s at 240 MHz)
+inline uint32_t profilerCycles() { return ESP.getCycleCount(); }
+
+// Add one sample for a stage (safe to call from either core)
+void profilerRecord(ProfStage stage, uint32_t cycles);
+
+// Summary for one stage; false if no samples yet
+bool profilerGetSummary(ProfStage stage, ProfilerSummary& out);
+
+// Clear all histograms
+void profilerReset();
+
+// Print a table of all stages to Serial (lines prefixed with "# " so CSV readers skip them)
+void profilerDump();
+
+// Records the cycles between construction and destruction into a stage
+class ProfileScope {
+ public:
+  explicit ProfileScope(ProfStage stage) : stage_(stage), start_(PROFILER_ENABLED ? profilerCycles() : 0) {}
+  ~ProfileScope() {
+    if (PROFILER_ENABLED) profilerRecord(stage_, profilerCycles() - start_);
+  }
+  ProfileScope(const ProfileScope&) = delete;
+  ProfileScope& operator=(const ProfileScope&) = delete;
+
+ private:
+  ProfStage stage_;
+  uint32_t start_;
+};
@@ -0,0 +1,248 @@
+/*
+ * ================================================================
+ *  Module: rolling_stats
+ *  Purpose: O(1) statistics over a sliding time window of samples:
+ *           Welford mean/variance, least-squares slope (value per
+ *           second), min/max, and the mean/spread of the sample
+ *           interval (jitter). Samples enter with add() and leave
+ *           when they fall out of the window or the ring is full;
+ *           every sum is updated incrementally on both sides, and
+ *           min/max use monotonic queues. The sums are redone from the
+ *           kept samples (O(N)) when the time origin moves, every 4
+ *           windows, and when float rounding from removals may have
+ *           built up (see popFront()).
+ *
+ *  Dependencies:
+ *    - none
+ *
+ *  Interface:
+ *    RollingStats<N>(windowMs)
+ *      void add(uint32_t sampleMs, float value);
+ *      void expire(uint32_t nowMs);
+ *      void reset();
+ *      size_t count() const;
+ *      float mean() const;
+ *      float variance() const;
+ *      float stddev() const;
+ *      float slopePerS() const;
+ *      float min() const;
+ *      float max() const;
+ *      float range() const;
+ *      float intervalMeanMs() const;
+ *      float intervalStdMs() const;
+ * ================================================================
+ */
+
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// N must be a power of two: samples kept at most (the window may hold fewer)
+template <size_t N>
+class RollingStats {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "RollingStats capacity must be a power of two");
+
+ public:
+  explicit constexpr RollingStats(uint32_t windowMs) : windowMs_(windowMs) {}
+
+  // Append a sample (timestamps must not go backwards) and drop what left the window
+  void add(uint32_t sampleMs, float value) {
+    if (head_ == tail_) {
+      baseMs_ = sampleMs;
+    } else {
+      lastIntervalMs_ = (float) (sampleMs - lastMs_);
+    }
+    if (head_ - tail_ == N) popFront();
+    rebase(sampleMs);
+
+    const float t = secondsOf(sampleMs);
+    const uint32_t seq = head_++;
+    Slot& s = slots_[seq & (N - 1)];
+    s.ms = sampleMs;
+    s.value = value;
+    s.intervalMs = (seq == tail_) ? NAN : lastIntervalMs_;
+
+    // Welford add for value, time and their co-moment
+    const float n = (float) (head_ - tail_);
+    const float dx = value - meanX_;
+    const float dt = t - meanT_;
+    meanX_ += dx / n;
+    meanT_ += dt / n;
+    const float tx = dx * (value - meanX_);
+    const float tt = dt * (t - meanT_);
+    m2x_ += tx;
+    m2t_ += tt;
+    ctx_ += dt * (value - meanX_);
+    m2xLoad_ += fabsf(tx);
+    m2tLoad_ += fabsf(tt);
+    if (head_ - tail_ > loadCount_) loadCount_ = head_ - tail_;
+    if (!isnan(s.intervalMs)) addInterval(s.intervalMs);
+
+    while (maxHead_ != maxTail_ && slots_[maxQ_[(maxHead_ - 1) & (N - 1)] & (N - 1)].value <= value) maxHead_--;
+    maxQ_[maxHead_++ & (N - 1)] = seq;
+    while (minHead_ != minTail_ && slots_[minQ_[(minHead_ - 1) & (N - 1)] & (N - 1)].value >= value) minHead_--;
+    minQ_[minHead_++ & (N - 1)] = seq;
+
+    lastMs_ = sampleMs;
+    expire(sampleMs);
+  }
+
+  // Drop samples older than the window at nowMs
+  void expire(uint32_t nowMs) {
+    while (head_ != tail_ && (uint32_t) (nowMs - slots_[tail_ & (N - 1)].ms) > windowMs_) popFront();
+  }
+
+  void reset() {
+    head_ = tail_ = 0;
+    maxHead_ = maxTail_ = minHead_ = minTail_ = 0;
+    clearSums();
+  }
+
+  size_t count() const { return head_ - tail_; }
+  float mean() const { return count() ? meanX_ : NAN; }
+  // Sample variance (n - 1); 0 with fewer than two samples
+  float variance() const { return count() > 1 ? fmaxf(m2x_, 0.0f) / (float) (count() - 1) : 0.0f; }
+  float stddev() const { return sqrtf(variance()); }
+  // Least-squares slope over the window; 0 until two samples differ in time
+  float slopePerS() const { return m2t_ > 1e-6f ? ctx_ / m2t_ : 0.0f; }
+  float min() const { return minHead_ != minTail_ ? slots_[minQ_[minTail_ & (N - 1)] & (N - 1)].value : NAN; }
+  float max() const { return maxHead_ != maxTail_ ? slots_[maxQ_[maxTail_ & (N - 1)] & (N - 1)].value : NAN; }
+  float range() const { return count() ? max() - min() : 0.0f; }
+  // Interval between consecutive samples in the window (mean, 1-sigma jitter)
+  float intervalMeanMs() const { return intervals_ ? meanI_ : NAN; }
+  float intervalStdMs() const { return intervals_ > 1 ? sqrtf(fmaxf(m2i_, 0.0f) / (float) (intervals_ - 1)) : 0.0f; }
+
+ private:
+  struct Slot {
+    uint32_t ms;
+    float value;
+    float intervalMs;  // gap to the previous sample; NAN for the first in the window
+  };
+
+  void popFront() {
+    const uint32_t seq = tail_++;
+    const Slot& s = slots_[seq & (N - 1)];
+    if (head_ == tail_) {
+      clearSums();
+    } else {
+      // Welford removal (n is the count after removal)
+      const float n = (float) (head_ - tail_);
+      const float dx = s.value - meanX_;
+      const float t = secondsOf(s.ms);
+      const float dt = t - meanT_;
+      meanX_ -= dx / n;
+      meanT_ -= dt / n;
+      const float tx = dx * (s.value - meanX_);
+      const float tt = dt * (t - meanT_);
+      m2x_ -= tx;
+      m2t_ -= tt;
+      ctx_ -= dt * (s.value - meanX_);
+      m2xLoad_ += fabsf(tx);
+      m2tLoad_ += fabsf(tt);
+      if (!isnan(s.intervalMs)) removeInterval(s.intervalMs);
+      // The new front's interval reached back outside the window
+      Slot& front = slots_[tail_ & (N - 1)];
+      if (!isnan(front.intervalMs)) {
+        removeInterval(front.intervalMs);
+        front.intervalMs = NAN;
+      }
+      // Float rounding builds up in the sums: each removal feeds the mean's
+      // error into m2, a sum keeps about FLT_EPSILON of everything that went
+      // through it, and the mean's error grows as the window shrinks. Start
+      // over after N removals, when an outlier leaving has cancelled most of
+      // a sum, or when the window has halved.
+      if (++removals_ >= N || m2x_ * 4096.0f < m2xLoad_ || m2t_ * 4096.0f < m2tLoad_ ||
+          2 * (head_ - tail_) <= loadCount_) {
+        recompute();
+      }
+    }
+    if (maxHead_ != maxTail_ && maxQ_[maxTail_ & (N - 1)] == seq) maxTail_++;
+    if (minHead_ != minTail_ && minQ_[minTail_ & (N - 1)] == seq) minTail_++;
+  }
+
+  float secondsOf(uint32_t ms) const { return (float) (ms - baseMs_) / 1000.0f; }
+
+  // Every 4 windows: move the slope time origin up to the oldest sample and
+  // redo the sums. Keeps t small and stops rounding in the add/remove
+  // updates from building up (O(N) per 4 windows).
+  void rebase(uint32_t nowMs) {
+    if (nowMs - baseMs_ < 4 * windowMs_ || head_ == tail_) return;
+    baseMs_ = slots_[tail_ & (N - 1)].ms;
+    recompute();
+  }
+
+  // Redo every sum from the kept samples
+  void recompute() {
+    clearSums();
+    for (uint32_t seq = tail_; seq != head_; ++seq) {
+      const Slot& s = slots_[seq & (N - 1)];
+      const float t = secondsOf(s.ms);
+      const float n = (float) (seq - tail_ + 1);
+      const float dx = s.value - meanX_;
+      const float dt = t - meanT_;
+      meanX_ += dx / n;
+      meanT_ += dt / n;
+      m2x_ += dx * (s.value - meanX_);
+      m2t_ += dt * (t - meanT_);
+      ctx_ += dt * (s.value - meanX_);
+      if (!isnan(s.intervalMs)) addInterval(s.intervalMs);
+    }
+    m2xLoad_ = m2x_;
+    m2tLoad_ = m2t_;
+    loadCount_ = head_ - tail_;
+  }
+
+  void addInterval(float v) {
+    intervals_++;
+    const float d = v - meanI_;
+    meanI_ += d / (float) intervals_;
+    m2i_ += d * (v - meanI_);
+  }
+
+  void removeInterval(float v) {
+    if (--intervals_ == 0) {
+      meanI_ = m2i_ = 0.0f;
+      return;
+    }
+    const float d = v - meanI_;
+    meanI_ -= d / (float) intervals_;
+    m2i_ -= d * (v - meanI_);
+  }
+
+  void clearSums() {
+    meanX_ = meanT_ = m2x_ = m2t_ = ctx_ = 0.0f;
+    meanI_ = m2i_ = 0.0f;
+    intervals_ = 0;
+    m2xLoad_ = m2tLoad_ = 0.0f;
+    loadCount_ = 0;
+    removals_ = 0;
+  }
+
+  uint32_t windowMs_;
+  Slot slots_[N] = {};
+  uint32_t head_ = 0;  // sequence numbers run freely; slot = seq & (N - 1)
+  uint32_t tail_ = 0;
+  uint32_t maxQ_[N] = {};  // sequence numbers with decreasing values
+  uint32_t minQ_[N] = {};  // sequence numbers with increasing values
+  uint32_t maxHead_ = 0;
+  uint32_t maxTail_ = 0;
+  uint32_t minHead_ = 0;
+  uint32_t minTail_ = 0;
+  uint32_t baseMs_ = 0;
+  uint32_t lastMs_ = 0;
+  float lastIntervalMs_ = 0.0f;
+  float meanX_ = 0.0f;
+  float meanT_ = 0.0f;
+  float m2x_ = 0.0f;
+  float m2t_ = 0.0f;
+  float ctx_ = 0.0f;
+  float meanI_ = 0.0f;
+  float m2i_ = 0.0f;
+  uint32_t intervals_ = 0;
+  float m2xLoad_ = 0.0f;   // sum of |update| into m2x_ / m2t_ since the last recompute()
+  float m2tLoad_ = 0.0f;
+  uint32_t loadCount_ = 0;  // most samples held since then
+  uint32_t removals_ = 0;   // popFront() calls since then
+};
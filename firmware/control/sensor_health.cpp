@@ -0,0 +1,83 @@
+#include "sensor_health.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "rolling_stats.h"
+
+struct ChannelState {
+  RollingStats<HEALTH_WINDOW_SAMPLES> stats{HEALTH_WINDOW_MS};
+  uint32_t lastSampleMs;
+  bool wasOk;
+};
+
+static ChannelState s_channels[HEALTH_CHANNEL_COUNT];
+static SensorHealthReport s_report;
+
+static const char* const kNames[HEALTH_CHANNEL_COUNT] = {"hot", "cold", "outlet", "flow"};
+
+// New sample (if any), then window expiry and the derived fields
+static void updateChannel(size_t idx, uint32_t nowMs, bool ok, uint32_t sampleMs, float value) {
+  ChannelState& ch = s_channels[idx];
+  SensorHealth& h = s_report.channel[idx];
+
+  if (ok && sampleMs != 0 && sampleMs != ch.lastSampleMs && !isnan(value)) {
+    ch.stats.add(sampleMs, value);
+    ch.lastSampleMs = sampleMs;
+    h.samples++;
+  }
+  ch.stats.expire(nowMs);
+  if (ch.wasOk && !ok) h.dropouts++;
+  ch.wasOk = ok;
+
+  h.ok = ok;
+  h.windowSamples = (uint16_t) ch.stats.count();
+  h.ageMs = (ch.lastSampleMs == 0) ? UINT32_MAX : nowMs - ch.lastSampleMs;
+  h.mean = ch.stats.mean();
+  h.stddev = ch.stats.stddev();
+  h.slopePerS = ch.stats.slopePerS();
+  h.minValue = ch.stats.min();
+  h.maxValue = ch.stats.max();
+  h.intervalMs = ch.stats.intervalMeanMs();
+  h.intervalJitterMs = ch.stats.intervalStdMs();
+}
+
+void sensorHealthInit() {
+  for (ChannelState& ch : s_channels) {
+    ch.stats.reset();
+    ch.lastSampleMs = 0;
+    ch.wasOk = false;
+  }
+  memset(&s_report, 0, sizeof(s_report));
+  for (SensorHealth& h : s_report.channel) {
+    h.ageMs = UINT32_MAX;
+    h.mean = h.minValue = h.maxValue = h.intervalMs = NAN;
+  }
+}
+
+void sensorHealthUpdate(uint32_t nowMs,
+                        const TemperatureReading& hot,
+                        const TemperatureReading& cold,
+                        const TemperatureReading& outlet,
+                        const FlowReading& flow) {
+  const TemperatureReading* temps[TEMP_SENSOR_COUNT] = {&hot, &cold, &outlet};
+  const TempBusStats& bus = temperatureBusStats();
+  for (size_t idx = 0; idx < TEMP_SENSOR_COUNT; ++idx) {
+    const TemperatureReading& r = *temps[idx];
+    updateChannel(idx, nowMs, r.present && r.valid, r.sampleMs, r.rawF);
+    s_report.channel[idx].crcErrors = bus.sensorCrcErrors[idx];
+    s_report.channel[idx].noResponse = bus.sensorNoResponse[idx];
+    s_report.channel[idx].failedReads = bus.sensorFailedReads[idx];
+  }
+  updateChannel(static_cast<size_t>(HealthChannel::FLOW), nowMs, flow.sampleMs != 0, flow.sampleMs, flow.lpmRaw);
+  s_report.updatedMs = nowMs;
+}
+
+const SensorHealthReport& sensorHealthGet() {
+  return s_report;
+}
+
+const char* sensorHealthName(HealthChannel channel) {
+  const size_t idx = static_cast<size_t>(channel);
+  return idx < HEALTH_CHANNEL_COUNT ? kNames[idx] : "?";
+}
@@ -0,0 +1,92 @@
+/*
+ * ================================================================
+ *  Module: sensor_health
+ *  Purpose: Rolling health indicators for every sensor the control
+ *           loop reads (three DS18B20s and the flow sensor), kept
+ *           incrementally alongside TemperatureReading/FlowReading:
+ *           windowed mean/standard deviation (Welford), trend slope,
+ *           min/max, age of the last sample, sample-interval jitter,
+ *           plus CRC / no-response and dropout counters. Each fresh
+ *           sample costs O(1); the whole table is read in one call,
+ *           so faults, logs and trending use precomputed values.
+ *
+ *  Dependencies:
+ *    - config.h         (HEALTH_* window)
+ *    - flow_sensor.h    (FlowReading)
+ *    - rolling_stats.h  (RollingStats)
+ *    - temperature.h    (TemperatureReading, TempBusStats)
+ *
+ *  Interface:
+ *    void sensorHealthInit();
+ *    void sensorHealthUpdate(uint32_t nowMs, const TemperatureReading& hot, const TemperatureReading& cold,
+ *                            const TemperatureReading& outlet, const FlowReading& flow);
+ *    const SensorHealthReport& sensorHealthGet();
+ *    const SensorHealth& sensorHealthGet(HealthChannel channel);
+ *    const char* sensorHealthName(HealthChannel channel);
+ * ================================================================
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "config.h"
+#include "flow_sensor.h"
+#include "temperature.h"
+
+// Hot/cold/outlet follow TempSensor order
+enum class HealthChannel : uint8_t {
+  HOT = 0,
+  COLD,
+  OUTLET,
+  FLOW,
+  COUNT,
+};
+
+constexpr size_t HEALTH_CHANNEL_COUNT = static_cast<size_t>(HealthChannel::COUNT);
+static_assert(static_cast<size_t>(HealthChannel::OUTLET) + 1 == TEMP_SENSOR_COUNT, "temperature channels first");
+
+// Values are °F for temperatures (raw readings) and L/min for flow
+struct SensorHealth {
+  bool ok;                  // present and valid now (flow: has a reading)
+  uint16_t windowSamples;   // samples in the statistics window
+  uint32_t samples;         // fresh samples since init
+  uint32_t ageMs;           // since the last fresh sample; UINT32_MAX if none yet
+  float mean;               // window mean (NAN while empty)
+  float stddev;             // window standard deviation
+  float slopePerS;          // least-squares trend over the window, per second
+  float minValue;           // window min / max (NAN while empty)
+  float maxValue;
+  float intervalMs;         // mean time between samples in the window
+  float intervalJitterMs;   // 1-sigma of that interval
+  uint32_t crcErrors;       // DS18B20 scratchpad CRC failures (flow: 0)
+  uint32_t noResponse;      // DS18B20 missing presence / blank scratchpad (flow: 0)
+  uint32_t failedReads;     // DS18B20 reads that gave no temperature, one per read however many tries (flow: 0)
+  uint32_t dropouts;        // ok → not ok transitions (temperature: went invalid)
+};
+
+struct SensorHealthReport {
+  uint32_t updatedMs;
+  SensorHealth channel[HEALTH_CHANNEL_COUNT];
+};
+
+// Clear all windows and counters
+void sensorHealthInit();
+
+// Fold in any fresh samples and refresh ages/counters; call once per pass
+void sensorHealthUpdate(uint32_t nowMs,
+                        const TemperatureReading& hot,
+                        const TemperatureReading& cold,
+                        const TemperatureReading& outlet,
+                        const FlowReading& flow);
+
+// Every channel as of the last sensorHealthUpdate()
+const SensorHealthReport& sensorHealthGet();
+
+inline const SensorHealth& sensorHealthGet(HealthChannel channel) {
+  return sensorHealthGet().channel[static_cast<size_t>(channel)];
+}
+
+// Short identifier, e.g. "outlet"
+const char* sensorHealthName(HealthChannel channel);
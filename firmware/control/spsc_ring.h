@@ -0,0 +1,85 @@
+/*
+ * ================================================================
+ *  Module: spsc_ring
+ *  Purpose: Fixed-capacity single-producer/single-consumer ring of
+ *           POD records. push() and pop() never block or take a
+ *           lock: each side owns one index and publishes it with
+ *           release/acquire ordering, so producer and consumer may
+ *           run on different cores. A full ring drops the new item
+ *           and counts it.
+ *
+ *  Dependencies:
+ *    - <atomic> (lock-free 32-bit atomics on ESP32)
+ *
+ *  Interface:
+ *    SpscRing<T, N>
+ *      bool push(const T& item);     // producer only
+ *      bool pop(T& out);             // consumer only
+ *      size_t size() const;
+ *      uint32_t dropped() const;
+ *      uint32_t highWater() const;
+ *      void resetCounters();
+ * ================================================================
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+// N must be a power of two; one slot per record (indices run freely and wrap)
+template <typename T, size_t N>
+class SpscRing {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing capacity must be a power of two");
+  static_assert(N <= 0x80000000UL, "SpscRing capacity too large");
+
+ public:
+  static constexpr size_t capacity() { return N; }
+
+  bool push(const T& item) {
+    const uint32_t head = head_.load(std::memory_order_relaxed);
+    const uint32_t tail = tail_.load(std::memory_order_acquire);
+    const uint32_t used = head - tail;
+    if (used >= N) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    slots_[head & (N - 1)] = item;
+    head_.store(head + 1, std::memory_order_release);
+    if (used + 1 > highWater_.load(std::memory_order_relaxed)) {
+      highWater_.store(used + 1, std::memory_order_relaxed);
+    }
+    return true;
+  }
+
+  bool pop(T& out) {
+    const uint32_t tail = tail_.load(std::memory_order_relaxed);
+    const uint32_t head = head_.load(std::memory_order_acquire);
+    if (head == tail) return false;
+    out = slots_[tail & (N - 1)];
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Snapshot; may be stale by the time the caller looks at it
+  size_t size() const {
+    return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+  }
+
+  uint32_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+  uint32_t highWater() const { return highWater_.load(std::memory_order_relaxed); }
+
+  void resetCounters() {
+    dropped_.store(0, std::memory_order_relaxed);
+    highWater_.store(0, std::memory_order_relaxed);
+  }
+
+ private:
+  T slots_[N];
+  std::atomic<uint32_t> head_{0};  // written by the producer
+  std::atomic<uint32_t> tail_{0};  // written by the consumer
+  std::atomic<uint32_t> dropped_{0};
+  std::atomic<uint32_t> highWater_{0};
+};
@@ -0,0 +1,188 @@
+#include "telemetry.h"
+
+#include <Arduino.h>
+#include <math.h>
+#include <string.h>
+
+static uint16_t s_seq = 0;
+static TelemetryStats s_stats{};
+
+static int16_t toI16(float v, float scale) {
+  const float s = roundf(v * scale);
+  if (isnan(s)) return 0;
+  return (int16_t) constrain(s, -32768.0f, 32767.0f);
+}
+
+static uint16_t toU16(float v, float scale) {
+  const float s = roundf(v * scale);
+  if (isnan(s)) return 0;
+  return (uint16_t) constrain(s, 0.0f, 65535.0f);
+}
+
+static uint8_t toPct(float v) {
+  const float s = roundf(v);
+  if (isnan(s)) return 0;
+  return (uint8_t) constrain(s, 0.0f, 100.0f);
+}
+
+void telemetryPack(const LogRecord& rec, uint16_t seq, TelemetryFrame& out) {
+  out.version = TELEMETRY_VERSION;
+  out.type = TELEMETRY_TYPE_CONTROL;
+  out.seq = seq;
+  out.ms = rec.ms;
+  out.setpointF = toI16(rec.setpointF, TELEM_TEMP_SCALE);
+  out.outletRawF = toI16(rec.outletRawF, TELEM_TEMP_SCALE);
+  out.outletFiltF = toI16(rec.outletFiltF, TELEM_TEMP_SCALE);
+  out.hotF = toI16(rec.hotF, TELEM_TEMP_SCALE);
+  out.coldF = toI16(rec.coldF, TELEM_TEMP_SCALE);
+  out.ratio = toI16(rec.ratio, TELEM_RATIO_SCALE);
+  out.u = toI16(rec.u, TELEM_RATIO_SCALE);
+  out.kp = rec.kp;
+  out.ki = rec.ki;
+  out.flowLpm = toU16(rec.flowLpm, TELEM_FLOW_SCALE);
+  out.hotUs = rec.hotUs;
+  out.coldUs = rec.coldUs;
+  out.fault = rec.fault;
+  out.linkRssiDbm = rec.linkRssiDbm;
+  out.linkLossPct = toPct(rec.linkLossPct);
+  out.linkDupPct = toPct(rec.linkDupPct);
+
+  uint8_t flags = 0;
+  if (rec.linkOk) flags |= TELEM_FLAG_LINK_OK;
+  if (rec.runFlag) flags |= TELEM_FLAG_RUN;
+  if (rec.estop) flags |= TELEM_FLAG_ESTOP;
+  if (rec.outletValid) flags |= TELEM_FLAG_OUTLET_VALID;
+  if (rec.hotValid) flags |= TELEM_FLAG_HOT_VALID;
+  if (rec.coldValid) flags |= TELEM_FLAG_COLD_VALID;
+  if (rec.flowValid) flags |= TELEM_FLAG_FLOW_VALID;
+  out.flags = flags;
+}
+
+void telemetryUnpack(const TelemetryFrame& frame, LogRecord& out) {
+  out.ms = frame.ms;
+  out.setpointF = frame.setpointF / TELEM_TEMP_SCALE;
+  out.outletRawF = frame.outletRawF / TELEM_TEMP_SCALE;
+  out.outletFiltF = frame.outletFiltF / TELEM_TEMP_SCALE;
+  out.hotF = frame.hotF / TELEM_TEMP_SCALE;
+  out.coldF = frame.coldF / TELEM_TEMP_SCALE;
+  out.ratio = frame.ratio / TELEM_RATIO_SCALE;
+  out.u = frame.u / TELEM_RATIO_SCALE;
+  out.kp = frame.kp;
+  out.ki = frame.ki;
+  out.flowLpm = frame.flowLpm / TELEM_FLOW_SCALE;
+  out.hotUs = frame.hotUs;
+  out.coldUs = frame.coldUs;
+  out.fault = frame.fault;
+  out.linkRssiDbm = frame.linkRssiDbm;
+  out.linkLossPct = frame.linkLossPct;
+  out.linkDupPct = frame.linkDupPct;
+  out.linkOk = frame.flags & TELEM_FLAG_LINK_OK;
+  out.runFlag = frame.flags & TELEM_FLAG_RUN;
+  out.estop = frame.flags & TELEM_FLAG_ESTOP;
+  out.outletValid = frame.flags & TELEM_FLAG_OUTLET_VALID;
+  out.hotValid = frame.flags & TELEM_FLAG_HOT_VALID;
+  out.coldValid = frame.flags & TELEM_FLAG_COLD_VALID;
+  out.flowValid = frame.flags & TELEM_FLAG_FLOW_VALID;
+}
+
+uint16_t telemetryCrc16(const uint8_t* data, size_t len) {
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < len; ++i) {
+    crc ^= (uint16_t) data[i] << 8;
+    for (uint8_t bit = 0; bit < 8; ++bit) {
+      crc = (crc & 0x8000) ? (uint16_t) ((crc << 1) ^ 0x1021) : (uint16_t) (crc << 1);
+    }
+  }
+  return crc;
+}
+
+size_t cobsEncode(const uint8_t* in, size_t len, uint8_t* out) {
+  size_t codeIdx = 0;
+  size_t outIdx = 1;
+  uint8_t code = 1;
+
+  for (size_t i = 0; i < len; ++i) {
+    if (in[i] != 0) {
+      out[outIdx++] = in[i];
+      code++;
+    }
+    if (in[i] == 0 || code == 0xFF) {
+      out[codeIdx] = code;
+      codeIdx = outIdx++;
+      code = 1;
+    }
+  }
+  out[codeIdx] = code;
+  return outIdx;
+}
+
+size_t cobsDecode(const uint8_t* in, size_t len, uint8_t* out, size_t cap) {
+  size_t inIdx = 0;
+  size_t outIdx = 0;
+
+  while (inIdx < len) {
+    const uint8_t code = in[inIdx++];
+    if (code == 0) return 0;
+    for (uint8_t i = 1; i < code; ++i) {
+      if (inIdx >= len || outIdx >= cap || in[inIdx] == 0) return 0;
+      out[outIdx++] = in[inIdx++];
+    }
+    // A short block implies a zero, except at the very end
+    if (code != 0xFF && inIdx < len) {
+      if (outIdx >= cap) return 0;
+      out[outIdx++] = 0;
+    }
+  }
+  return outIdx;
+}
+
+size_t telemetryEncode(const TelemetryFrame& frame, uint8_t* out, size_t cap) {
+  if (cap < TELEMETRY_MAX_ENCODED) return 0;
+
+  uint8_t raw[TELEMETRY_RAW_BYTES];
+  memcpy(raw, &frame, sizeof(frame));
+  const uint16_t crc = telemetryCrc16(raw, sizeof(frame));
+  raw[sizeof(frame)] = (uint8_t) (crc & 0xFF);
+  raw[sizeof(frame) + 1] = (uint8_t) (crc >> 8);
+
+  // Leading delimiter lets the reader drop any text printed since the last frame
+  out[0] = 0;
+  const size_t n = cobsEncode(raw, sizeof(raw), out + 1);
+  out[n + 1] = 0;
+  return n + 2;
+}
+
+TelemetryDecodeResult telemetryDecode(const uint8_t* in, size_t len, TelemetryFrame& out) {
+  uint8_t raw[TELEMETRY_RAW_BYTES + 1];  // +1 to detect oversized chunks
+  const size_t n = cobsDecode(in, len, raw, sizeof(raw));
+  if (n == 0) return TelemetryDecodeResult::BAD_COBS;
+  if (n != TELEMETRY_RAW_BYTES) return TelemetryDecodeResult::BAD_LENGTH;
+
+  const uint16_t crc = (uint16_t) (raw[sizeof(TelemetryFrame)] | (raw[sizeof(TelemetryFrame) + 1] << 8));
+  if (telemetryCrc16(raw, sizeof(TelemetryFrame)) != crc) return TelemetryDecodeResult::BAD_CRC;
+
+  memcpy(&out, raw, sizeof(out));
+  if (out.version != TELEMETRY_VERSION) return TelemetryDecodeResult::BAD_VERSION;
+  return TelemetryDecodeResult::OK;
+}
+
+bool telemetryWrite(const LogRecord& rec) {
+  TelemetryFrame frame;
+  telemetryPack(rec, s_seq++, frame);
+
+  uint8_t buf[TELEMETRY_MAX_ENCODED];
+  const size_t n = telemetryEncode(frame, buf, sizeof(buf));
+
+  // Whole frames only: a partial write would corrupt the frame anyway
+  if (n == 0 || Serial.availableForWrite() < (int) n) {
+    s_stats.framesDropped++;
+    return false;
+  }
+  Serial.write(buf, n);
+  s_stats.framesSent++;
+  return true;
+}
+
+TelemetryStats telemetryGetStats() {
+  return s_stats;
+}
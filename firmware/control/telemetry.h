@@ -0,0 +1,124 @@
+/*
+ * ================================================================
+ *  Module: telemetry
+ *  Purpose: Compact binary replacement for the CSV logger. Each
+ *           LogRecord is packed into a fixed, versioned frame with
+ *           scaled integer fields, protected by CRC-16/CCITT and
+ *           COBS-framed (0x00 delimiters) so a reader can resync
+ *           after any dropped or corrupted byte. Writes never block:
+ *           a frame that does not fit in the UART TX buffer is
+ *           dropped and counted.
+ *
+ *  Wire format (per frame):
+ *    0x00 | COBS( TelemetryFrame | crc16 little-endian ) | 0x00
+ *
+ *  Dependencies:
+ *    - config.h     (TELEMETRY_* rate/enable)
+ *    - pipeline.h   (LogRecord)
+ *    - Arduino      (Serial, implementation only)
+ *
+ *  Interface:
+ *    bool telemetryWrite(const LogRecord& rec);
+ *    TelemetryStats telemetryGetStats();
+ *    void telemetryPack(const LogRecord& rec, uint16_t seq, TelemetryFrame& out);
+ *    void telemetryUnpack(const TelemetryFrame& frame, LogRecord& out);
+ *    size_t telemetryEncode(const TelemetryFrame& frame, uint8_t* out, size_t cap);
+ *    TelemetryDecodeResult telemetryDecode(const uint8_t* in, size_t len, TelemetryFrame& out);
+ *    uint16_t telemetryCrc16(const uint8_t* data, size_t len);
+ *    size_t cobsEncode(const uint8_t* in, size_t len, uint8_t* out);
+ *    size_t cobsDecode(const uint8_t* in, size_t len, uint8_t* out, size_t cap);
+ * ================================================================
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pipeline.h"
+
+// v2 appended the link-quality fields
+constexpr uint8_t TELEMETRY_VERSION = 2;
+constexpr uint8_t TELEMETRY_TYPE_CONTROL = 1;  // one control-loop snapshot
+
+// --- Frame flag bits ---
+constexpr uint8_t TELEM_FLAG_LINK_OK = 1 << 0;
+constexpr uint8_t TELEM_FLAG_RUN = 1 << 1;
+constexpr uint8_t TELEM_FLAG_ESTOP = 1 << 2;
+constexpr uint8_t TELEM_FLAG_OUTLET_VALID = 1 << 3;
+constexpr uint8_t TELEM_FLAG_HOT_VALID = 1 << 4;
+constexpr uint8_t TELEM_FLAG_COLD_VALID = 1 << 5;
+constexpr uint8_t TELEM_FLAG_FLOW_VALID = 1 << 6;
+// bit 7 reserved
+
+// --- Fixed-point scales ---
+constexpr float TELEM_TEMP_SCALE = 100.0f;    // °F × 100 (0.01 °F, ±327 °F)
+constexpr float TELEM_RATIO_SCALE = 10000.0f; // ratio/u × 10000
+constexpr float TELEM_FLOW_SCALE = 1000.0f;   // L/min × 1000 (mL/min)
+
+// --- Frame (version 2) ---
+typedef struct __attribute__((packed)) {
+  uint8_t version;       // TELEMETRY_VERSION
+  uint8_t type;          // TELEMETRY_TYPE_*
+  uint16_t seq;          // increments per frame written (gaps = drops)
+  uint32_t ms;           // sample timestamp (ms)
+  int16_t setpointF;     // × TELEM_TEMP_SCALE
+  int16_t outletRawF;    // × TELEM_TEMP_SCALE
+  int16_t outletFiltF;   // × TELEM_TEMP_SCALE
+  int16_t hotF;          // × TELEM_TEMP_SCALE
+  int16_t coldF;         // × TELEM_TEMP_SCALE
+  int16_t ratio;         // × TELEM_RATIO_SCALE
+  int16_t u;             // × TELEM_RATIO_SCALE
+  float kp;
+  float ki;
+  uint16_t flowLpm;      // × TELEM_FLOW_SCALE
+  uint16_t hotUs;        // servo pulse widths (µs)
+  uint16_t coldUs;
+  uint8_t fault;         // FaultCode
+  uint8_t flags;         // TELEM_FLAG_*
+  int8_t linkRssiDbm;    // UI frames, moving average (0 = none yet)
+  uint8_t linkLossPct;   // UI packets lost, rolling (%)
+  uint8_t linkDupPct;    // UI packets received twice, rolling (%)
+} TelemetryFrame;
+
+constexpr size_t TELEMETRY_CRC_BYTES = 2;
+constexpr size_t TELEMETRY_RAW_BYTES = sizeof(TelemetryFrame) + TELEMETRY_CRC_BYTES;
+// COBS adds one byte per 254 plus the leading/trailing delimiters
+constexpr size_t TELEMETRY_MAX_ENCODED = TELEMETRY_RAW_BYTES + TELEMETRY_RAW_BYTES / 254 + 1 + 2;
+
+enum class TelemetryDecodeResult : uint8_t {
+  OK = 0,
+  BAD_COBS,
+  BAD_LENGTH,
+  BAD_CRC,
+  BAD_VERSION,
+};
+
+struct TelemetryStats {
+  uint32_t framesSent;
+  uint32_t framesDropped;  // UART TX buffer too full to take a whole frame
+};
+
+// Pack, frame and queue one record on Serial without blocking.
+// Returns false (and counts a drop) if the TX buffer lacks room.
+bool telemetryWrite(const LogRecord& rec);
+
+TelemetryStats telemetryGetStats();
+
+// LogRecord ↔ wire frame (scaling + saturation)
+void telemetryPack(const LogRecord& rec, uint16_t seq, TelemetryFrame& out);
+void telemetryUnpack(const TelemetryFrame& frame, LogRecord& out);
+
+// Frame → delimited COBS bytes; returns bytes written (0 if cap too small)
+size_t telemetryEncode(const TelemetryFrame& frame, uint8_t* out, size_t cap);
+
+// One COBS chunk (delimiters stripped) → frame
+TelemetryDecodeResult telemetryDecode(const uint8_t* in, size_t len, TelemetryFrame& out);
+
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF)
+uint16_t telemetryCrc16(const uint8_t* data, size_t len);
+
+// Consistent Overhead Byte Stuffing. Encode output needs len + len/254 + 1 bytes.
+// Decode returns the decoded length, or 0 on malformed input / overflow.
+size_t cobsEncode(const uint8_t* in, size_t len, uint8_t* out);
+size_t cobsDecode(const uint8_t* in, size_t len, uint8_t* out, size_t cap);
@@ -1,18 +1,35 @@
 #include "temperature.h"
 
-#include <DallasTemperature.h>
 #include <OneWire.h>
 #include <math.h>
 #include <string.h>
 
 static OneWire g_oneWire(TEMP_PIN_ONEWIRE);
-static DallasTemperature g_sensors(&g_oneWire);
 
 static TemperatureReading g_readings[TEMP_SENSOR_COUNT];
-
-static uint32_t g_nextLoopMs = 0;
-static uint32_t g_lastRequestMs = 0;
-static bool g_conversionPending = false;
+static TempBusStats g_busStats;
+
+// DS18B20 function commands issued directly on the bus
+static constexpr uint8_t DS18B20_CONVERT_T = 0x44;
+static constexpr uint8_t DS18B20_WRITE_SCRATCHPAD = 0x4E;
+static constexpr uint8_t DS18B20_READ_SCRATCHPAD = 0xBE;
+static constexpr size_t DS18B20_SCRATCHPAD_LEN = 9;  // temp LSB/MSB, TH, TL, config, 3 reserved, CRC8
+static constexpr uint8_t DS18B20_TH_DEFAULT = 0x4B;  // alarm registers (unused), power-on values
+static constexpr uint8_t DS18B20_TL_DEFAULT = 0x46;
+
+// Per-sensor conversion schedule and resolution state
+struct SensorSchedule {
+  uint8_t resolution;      // bits currently configured in the sensor
+  uint8_t wantResolution;  // applied before the next conversion
+  bool converting;
+  uint32_t convStartMs;
+  uint32_t nextStartMs;
+  uint8_t quietSamples;    // consecutive readings inside the settle band
+  float anchorC;           // first reading of the current quiet run
+  uint32_t holdUntilMs;    // forced coarse until then (temperatureMarkTransient)
+};
+
+static SensorSchedule g_sched[TEMP_SENSOR_COUNT];
 static bool g_initialized = false;
 
 static constexpr size_t sensorIndex(TempSensor sensor) {
@@ -31,26 +48,155 @@ static const DeviceAddress& sensorAddr(TempSensor sensor) {
   }
 }
 
-static void scheduleNextLoop(uint32_t now) {
-  do {
-    g_nextLoopMs += TEMP_LOOP_DT_MS;
-  } while ((int32_t) (now - g_nextLoopMs) >= 0);
+static unsigned samplePeriodMs(TempSensor sensor) {
+  return (sensor == TempSensor::OUTLET) ? TEMP_OUTLET_PERIOD_MS : TEMP_LINE_PERIOD_MS;
+}
+
+static uint8_t settledResolution(TempSensor sensor) {
+  return (sensor == TempSensor::OUTLET) ? TEMP_OUTLET_SETTLED_RES : TEMP_LINE_SETTLED_RES;
 }
 
+static uint32_t conversionMs(uint8_t bits) { return tempConversionMs(bits); }
+
+static float cToF(float c) { return c * 1.8f + 32.0f; }
+
 static void clearFreshFlags() {
   for (auto& r : g_readings) {
     r.fresh = false;
   }
 }
 
-bool temperatureInit() {
-  g_sensors.begin();
-  g_sensors.setWaitForConversion(false);
-  g_sensors.setCheckForConversion(true);
+// Set the resolution in the scratchpad only. DallasTemperature::setResolution()
+// also copies it to EEPROM (~10 ms busy, limited write cycles), which is not
+// acceptable for switching at run time.
+static bool writeResolution(const DeviceAddress& addr, uint8_t bits) {
+  if (!g_oneWire.reset()) return false;
+  g_oneWire.select(addr);
+  g_oneWire.write(DS18B20_WRITE_SCRATCHPAD);
+  g_oneWire.write(DS18B20_TH_DEFAULT);
+  g_oneWire.write(DS18B20_TL_DEFAULT);
+  g_oneWire.write((uint8_t) (((bits - 9) << 5) | 0x1F));
+  return true;
+}
+
+// Addressed Convert T: only this sensor starts a conversion
+static bool startConversion(const DeviceAddress& addr) {
+  if (!g_oneWire.reset()) return false;
+  g_oneWire.select(addr);
+  g_oneWire.write(DS18B20_CONVERT_T);
+  return true;
+}
+
+// Pick the resolution for the next conversion from how much the reading moves
+static void updateResolution(TempSensor sensor, float tempC, uint32_t now) {
+  SensorSchedule& sc = g_sched[sensorIndex(sensor)];
+  const bool held = (int32_t) (now - sc.holdUntilMs) < 0;
+  if (held || sc.quietSamples == 0 || fabsf(tempC - sc.anchorC) > TEMP_SETTLE_BAND_C) {
+    sc.anchorC = tempC;
+    sc.quietSamples = 1;
+    sc.wantResolution = TEMP_RESOLUTION;
+    return;
+  }
+  if (sc.quietSamples < TEMP_SETTLE_SAMPLES) {
+    sc.quietSamples++;
+  } else {
+    sc.wantResolution = settledResolution(sensor);
+  }
+}
+
+enum class ScratchpadResult : uint8_t { OK, NO_RESPONSE, CRC_ERROR };
+
+// Reset, Match ROM, Read Scratchpad, 9 bytes, CRC8. No closing reset (the
+// next transaction starts with one); DallasTemperature adds one per read.
+static ScratchpadResult readScratchpad(const DeviceAddress& addr, uint8_t* sp) {
+  if (!g_oneWire.reset()) return ScratchpadResult::NO_RESPONSE;
+  g_oneWire.select(addr);
+  g_oneWire.write(DS18B20_READ_SCRATCHPAD);
+  g_oneWire.read_bytes(sp, DS18B20_SCRATCHPAD_LEN);
+
+  // An absent device leaves the bus high; all zeros is a shorted line
+  bool allOnes = true;
+  bool allZeros = true;
+  for (size_t i = 0; i < DS18B20_SCRATCHPAD_LEN; ++i) {
+    allOnes = allOnes && sp[i] == 0xFF;
+    allZeros = allZeros && sp[i] == 0x00;
+  }
+  if (allOnes || allZeros) return ScratchpadResult::NO_RESPONSE;
+  if (OneWire::crc8(sp, DS18B20_SCRATCHPAD_LEN - 1) != sp[DS18B20_SCRATCHPAD_LEN - 1]) {
+    return ScratchpadResult::CRC_ERROR;
+  }
+  return ScratchpadResult::OK;
+}
 
+// Read one sensor, retrying once on a CRC error. Returns NAN on failure.
+static float readTemperatureC(TempSensor sensor) {
+  uint8_t sp[DS18B20_SCRATCHPAD_LEN];
+  ScratchpadResult res = ScratchpadResult::NO_RESPONSE;
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    g_busStats.reads++;
+    res = readScratchpad(sensorAddr(sensor), sp);
+    if (res != ScratchpadResult::CRC_ERROR) break;
+    g_busStats.crcErrors++;
+    g_busStats.sensorCrcErrors[sensorIndex(sensor)]++;
+  }
+  if (res != ScratchpadResult::OK) {
+    g_busStats.sensorFailedReads[sensorIndex(sensor)]++;
+    if (res == ScratchpadResult::NO_RESPONSE) {
+      g_busStats.noResponse++;
+      g_busStats.sensorNoResponse[sensorIndex(sensor)]++;
+    }
+    return NAN;
+  }
+
+  // Config bits 6:5 give the resolution; the low bits below it are undefined
+  const uint8_t bits = (uint8_t) (9 + ((sp[4] >> 5) & 0x03));
+  int16_t raw = (int16_t) ((sp[1] << 8) | sp[0]);
+  raw &= (int16_t) ~((1 << (12 - bits)) - 1);
+  return raw / 16.0f;
+}
+
+// Store a temperature read from a finished conversion
+static bool captureReading(TempSensor sensor, float tempC, uint32_t now) {
+  TemperatureReading& reading = g_readings[sensorIndex(sensor)];
+
+  bool ok = (!isnan(tempC)) && (tempC > TEMP_MIN_VALID_C) && (tempC < TEMP_MAX_VALID_C);
+
+  if (!ok) {
+    reading.valid = false;
+    g_sched[sensorIndex(sensor)].quietSamples = 0;
+    return false;
+  }
+
+  const uint32_t prevMs = reading.sampleMs;
+  reading.sampleMs = now;
+  reading.rawC = tempC;
+  reading.rawF = cToF(tempC);
+
+  if (!reading.valid || isnan(reading.filteredC)) {
+    reading.filteredC = tempC;
+  } else {
+    // Time-based EMA: sensors sample at different and changing rates
+    const float dtSec = (now - prevMs) / 1000.0f;
+    reading.filteredC += (dtSec / (TEMP_EMA_TAU_S + dtSec)) * (tempC - reading.filteredC);
+  }
+  reading.filteredF = cToF(reading.filteredC);
+  reading.resolution = g_sched[sensorIndex(sensor)].resolution;
+  reading.estimateF = reading.filteredF;
+  reading.estimateStdF = NAN;
+
+  reading.valid = true;
+  reading.fresh = true;
+  updateResolution(sensor, tempC, now);
+  return true;
+}
+
+bool temperatureInit() {
   bool anyPresent = false;
   memset(g_readings, 0, sizeof(g_readings));
+  memset(g_sched, 0, sizeof(g_sched));
+  memset(&g_busStats, 0, sizeof(g_busStats));
 
+  const uint32_t now = millis();
   for (size_t idx = 0; idx < TEMP_SENSOR_COUNT; ++idx) {
     TempSensor sensor = static_cast<TempSensor>(idx);
     TemperatureReading& reading = g_readings[idx];
@@ -59,23 +205,26 @@ bool temperatureInit() {
     reading.rawF = NAN;
     reading.filteredC = NAN;
     reading.filteredF = NAN;
+    reading.estimateF = NAN;
+    reading.estimateStdF = NAN;
     reading.fresh = false;
     reading.valid = false;
     reading.sampleMs = 0;
 
-    reading.present = g_sensors.isConnected(sensorAddr(sensor));
+    reading.present = !isnan(readTemperatureC(sensor));
     if (reading.present) {
       anyPresent = true;
-      g_sensors.setResolution(sensorAddr(sensor), TEMP_RESOLUTION);
+      writeResolution(sensorAddr(sensor), TEMP_RESOLUTION);
     }
+
+    SensorSchedule& sc = g_sched[idx];
+    sc.resolution = TEMP_RESOLUTION;
+    sc.wantResolution = TEMP_RESOLUTION;
+    sc.nextStartMs = now;
   }
 
-  uint32_t now = millis();
-  g_nextLoopMs = now;
-  g_lastRequestMs = now;
-  g_sensors.requestTemperatures();
-  g_conversionPending = true;
   g_initialized = true;
+  temperatureService();  // start the first conversions
 
   return anyPresent;
 }
@@ -83,66 +232,69 @@ bool temperatureInit() {
 bool temperatureService() {
   if (!g_initialized) return false;
 
-  uint32_t now = millis();
-
-  if (!g_conversionPending) {
-    if ((int32_t) (now - g_nextLoopMs) < 0) return false;
-
-    g_sensors.requestTemperatures();
-    g_lastRequestMs = now;
-    g_conversionPending = true;
-    return false;
-  }
-
-  bool ready = g_sensors.isConversionComplete() || ((now - g_lastRequestMs) >= TEMP_CONVERSION_TIME_MS);
-  if (!ready) return false;
-  if ((int32_t) (now - g_nextLoopMs) < 0) return false;
-
+  const uint32_t now = millis();
   bool anyFresh = false;
   clearFreshFlags();
 
+  // Read finished conversions back to back, up to TEMP_MAX_READS_PER_SERVICE,
+  // outlet first; the rest stay "converting" and are read on the next call.
+  // Conversion time is known per resolution, so no bus polling: with several
+  // sensors converting, a read slot would only report the slowest.
+  static constexpr TempSensor kReadOrder[TEMP_SENSOR_COUNT] = {TempSensor::OUTLET, TempSensor::HOT, TempSensor::COLD};
+  float tempC[TEMP_SENSOR_COUNT];
+  bool done[TEMP_SENSOR_COUNT] = {};
+  uint8_t reads = 0;
+  const uint32_t readStartUs = micros();
+  for (TempSensor sensor : kReadOrder) {
+    if (reads >= TEMP_MAX_READS_PER_SERVICE) break;
+    const size_t idx = sensorIndex(sensor);
+    const SensorSchedule& sc = g_sched[idx];
+    if (!g_readings[idx].present || !sc.converting) continue;
+    if ((now - sc.convStartMs) < conversionMs(sc.resolution)) continue;
+    tempC[idx] = readTemperatureC(sensor);
+    done[idx] = true;
+    reads++;
+  }
+  if (reads > 0) {
+    g_busStats.lastServiceReadUs = micros() - readStartUs;
+    g_busStats.lastServiceReads = reads;
+    if (g_busStats.lastServiceReadUs > g_busStats.maxServiceReadUs) {
+      g_busStats.maxServiceReadUs = g_busStats.lastServiceReadUs;
+    }
+  }
+
   for (size_t idx = 0; idx < TEMP_SENSOR_COUNT; ++idx) {
     TempSensor sensor = static_cast<TempSensor>(idx);
     TemperatureReading& reading = g_readings[idx];
+    SensorSchedule& sc = g_sched[idx];
 
     if (!reading.present) {
       reading.valid = false;
       continue;
     }
 
-    float tempC = g_sensors.getTempC(sensorAddr(sensor));
+    if (done[idx]) {
+      sc.converting = false;
+      if (captureReading(sensor, tempC[idx], now)) anyFresh = true;
 
-    bool ok = (!isnan(tempC)) && (tempC != DEVICE_DISCONNECTED_C) &&
-              (tempC > TEMP_MIN_VALID_C) && (tempC < TEMP_MAX_VALID_C);
-
-    if (!ok) {
-      reading.valid = false;
-      continue;
+      sc.nextStartMs = sc.convStartMs + samplePeriodMs(sensor);
+      if ((int32_t) (now - sc.nextStartMs) > 0) sc.nextStartMs = now;
     }
 
-    reading.sampleMs = now;
-    reading.rawC = tempC;
-    reading.rawF = DallasTemperature::toFahrenheit(tempC);
+    if (sc.converting || (int32_t) (now - sc.nextStartMs) < 0) continue;
 
-    if (!reading.valid || isnan(reading.filteredC)) {
-      reading.filteredC = tempC;
+    if (sc.wantResolution != sc.resolution && writeResolution(sensorAddr(sensor), sc.wantResolution)) {
+      sc.resolution = sc.wantResolution;
+    }
+    if (startConversion(sensorAddr(sensor))) {
+      sc.converting = true;
+      sc.convStartMs = millis();  // after any bus traffic above
     } else {
-      reading.filteredC += TEMP_EMA_ALPHA * (tempC - reading.filteredC);
+      reading.valid = false;
+      sc.nextStartMs = now + conversionMs(sc.resolution);  // retry later
     }
-    reading.filteredF = DallasTemperature::toFahrenheit(reading.filteredC);
-
-    reading.valid = true;
-    reading.fresh = true;
-    anyFresh = true;
   }
 
-  g_conversionPending = false;
-  scheduleNextLoop(now);
-
-  g_sensors.requestTemperatures();
-  g_lastRequestMs = now;
-  g_conversionPending = true;
-
   return anyFresh;
 }
 
@@ -158,6 +310,24 @@ const TemperatureReading& temperatureGetReading(TempSensor sensor) {
   return g_readings[idx];
 }
 
+const TempBusStats& temperatureBusStats() {
+  return g_busStats;
+}
+
+uint8_t temperatureResolution(TempSensor sensor) {
+  size_t idx = sensorIndex(sensor);
+  if (idx >= TEMP_SENSOR_COUNT) idx = 0;
+  return g_sched[idx].resolution;
+}
+
+void temperatureMarkTransient(TempSensor sensor) {
+  size_t idx = sensorIndex(sensor);
+  if (idx >= TEMP_SENSOR_COUNT) return;
+  g_sched[idx].quietSamples = 0;
+  g_sched[idx].wantResolution = TEMP_RESOLUTION;
+  g_sched[idx].holdUntilMs = millis() + TEMP_TRANSIENT_HOLD_MS;
+}
+
 bool temperatureAnyFault() {
   for (size_t idx = 0; idx < TEMP_SENSOR_COUNT; ++idx) {
     const TemperatureReading& reading = g_readings[idx];
@@ -167,3 +337,20 @@ bool temperatureAnyFault() {
   }
   return false;
 }
+
+uint32_t temperatureNextSampleMs() {
+  const uint32_t now = millis();
+  if (!g_initialized) return now + TEMP_LOOP_DT_MS;
+
+  // Earliest conversion to read or to start across the sensors
+  bool any = false;
+  uint32_t next = now + TEMP_LOOP_DT_MS;
+  for (size_t idx = 0; idx < TEMP_SENSOR_COUNT; ++idx) {
+    if (!g_readings[idx].present) continue;
+    const SensorSchedule& sc = g_sched[idx];
+    const uint32_t due = sc.converting ? sc.convStartMs + conversionMs(sc.resolution) : sc.nextStartMs;
+    if (!any || (int32_t) (due - next) < 0) next = due;
+    any = true;
+  }
+  return next;
+}
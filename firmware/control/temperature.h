@@ -3,20 +3,31 @@
  *  Module: temperature
  *  Purpose: Non-blocking manager for the three DS18B20 sensors
  *           (hot, cold, outlet) connected to the Control Unit.
- *           Handles address binding, 100 ms conversion cadence,
- *           validation, and EMA filtering used by the control loop.
+ *           Handles address binding, per-sensor conversion schedules
+ *           (outlet back-to-back, hot/cold lines slower), adaptive
+ *           resolution (coarse while a reading moves, fine once it
+ *           settles), validation, and EMA filtering used by the
+ *           control loop. Scratchpads are read straight through
+ *           OneWire with CRC8, TEMP_MAX_READS_PER_SERVICE per call, so
+ *           one pass over the finished conversions spans several
+ *           temperatureService() calls.
  *
  *  Dependencies:
  *    - config.h            (sensor pin, ROM addresses, timing constants)
- *    - OneWire + DallasTemperature (implementation only)
+ *    - OneWire        (implementation only; scratchpad reads and
+ *                      commands are issued directly, with CRC8)
  *
  *  Interface:
  *    bool temperatureInit();
  *    bool temperatureService();
  *    bool temperatureSensorPresent(TempSensor sensor);
  *    const TemperatureReading& temperatureGetReading(TempSensor sensor);
+ *    uint8_t temperatureResolution(TempSensor sensor);
+ *    const TempBusStats& temperatureBusStats();
+ *    void temperatureMarkTransient(TempSensor sensor);
  *    float temperatureOutletFilteredF();
  *    bool temperatureAnyFault();
+ *    uint32_t temperatureNextSampleMs();
  * ================================================================
  */
 
@@ -46,13 +57,33 @@ struct TemperatureReading {
   float rawF;           // raw reading converted to °F
   float filteredC;      // EMA filtered value in °C
   float filteredF;      // EMA filtered value in °F (used by PI loop)
+  uint8_t resolution;   // DS18B20 resolution of this sample (bits)
+  float estimateF;      // outlet: model-based water temperature at the sensor
+                        // (outlet_estimator.h); others: same as filteredF
+  float estimateStdF;   // 1-sigma uncertainty of estimateF; NAN = no model estimate
+};
+
+// 1-Wire read statistics since temperatureInit()
+struct TempBusStats {
+  uint32_t reads;          // scratchpad reads issued (including retries)
+  uint32_t crcErrors;      // reads that failed CRC8 (each retried once)
+  uint32_t noResponse;     // no presence pulse, or an all-ones/all-zeros scratchpad
+  uint32_t lastServiceReadUs;  // bus time of the reads in the last service call that read (µs)
+  uint32_t maxServiceReadUs;   // longest of those so far (µs), including CRC retries
+  uint8_t lastServiceReads;    // sensors read in that call (<= TEMP_MAX_READS_PER_SERVICE)
+  uint32_t sensorCrcErrors[TEMP_SENSOR_COUNT];   // crcErrors per sensor (TempSensor order)
+  uint32_t sensorNoResponse[TEMP_SENSOR_COUNT];  // noResponse per sensor
+  uint32_t sensorFailedReads[TEMP_SENSOR_COUNT]; // reads that gave no temperature (after the retry), per sensor
 };
 
 // Initialize the bus, bind sensors to ROM addresses, prime the EMA filter
 bool temperatureInit();
 
 // Service routine that should be called each loop iteration.
-// Schedules conversions at TEMP_LOOP_DT_MS cadence and updates readings.
+// Reads finished conversions (CRC-checked, at most TEMP_MAX_READS_PER_SERVICE
+// per call, outlet first; the rest on later calls) and starts each
+// sensor's next one on its own period (TEMP_OUTLET_PERIOD_MS /
+// TEMP_LINE_PERIOD_MS) and resolution.
 // Returns true when at least one sensor produced a fresh sample.
 bool temperatureService();
 
@@ -72,5 +103,21 @@ inline float temperatureOutletFilteredC() {
   return temperatureGetReading(TempSensor::OUTLET).filteredC;
 }
 
+// CRC/response counters and per-service read timing
+const TempBusStats& temperatureBusStats();
+
+// Resolution (bits) the sensor's current/last conversion uses
+uint8_t temperatureResolution(TempSensor sensor);
+
+// Drop a sensor back to TEMP_RESOLUTION (fast conversions) for at least
+// TEMP_TRANSIENT_HOLD_MS before its reading moves, e.g. on a setpoint change
+// for the outlet sensor
+void temperatureMarkTransient(TempSensor sensor);
+
 // True if any required sensor is missing or currently invalid
 bool temperatureAnyFault();
+
+// millis() time at which the next temperatureService() call will capture a
+// conversion (or start one), earliest across the sensors. DS18B20s signal completion only when polled, so
+// callers sleep until this deadline instead of polling the bus.
+uint32_t temperatureNextSampleMs();
@@ -1,24 +1,192 @@
 #include "valve_mix.h"
 
 #include <ESP32Servo.h>
+#include <driver/ledc.h>
 #include <math.h>
 
 #include "config.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/portmacro.h"
 
 static Servo sHot, sCold;
 static bool sAttached = false;
+static bool sLedc = false;  // direct LEDC driver (else ESP32Servo)
+static portMUX_TYPE s_ledcMux = portMUX_INITIALIZER_UNLOCKED;  // keeps the two update requests together
 
 // Soft limits (guard band applied around mechanical min/max)
-static int hotSoftMin, hotSoftMax;
-static int coldSoftMin, coldSoftMax;
+static float hotSoftMin, hotSoftMax;
+static float coldSoftMin, coldSoftMax;
 
 // Last commanded pulse widths (for logging/tests)
-static int g_lastHot = (SERVO_HOT_MIN_US + SERVO_HOT_MAX_US) / 2;
-static int g_lastCold = (SERVO_COLD_MIN_US + SERVO_COLD_MAX_US) / 2;
+static float g_lastHot = (SERVO_HOT_MIN_US + SERVO_HOT_MAX_US) / 2;
+static float g_lastCold = (SERVO_COLD_MIN_US + SERVO_COLD_MAX_US) / 2;
+
+// Last value written per valve: LEDC duty counts, or whole µs for ESP32Servo
+static uint32_t s_hotCode = UINT32_MAX;
+static uint32_t s_coldCode = UINT32_MAX;
+static ValveMixStats s_stats;
+
+// Hold detector: pulse widths at the last move beyond SERVO_HOLD_BAND_US
+static float s_anchorHot = 0.0f;
+static float s_anchorCold = 0.0f;
+static uint32_t s_steadySinceMs = 0;
+static uint32_t s_stateSinceMs = 0;  // last time charged to stats.stateMs
+
+// Inverse backlash (valveMixSetPlay): each valve's opening is offset by half
+// the play in its own direction of motion, tracked with BACKLASH_REVERSAL_EPS
+// of hysteresis. Closing drives both valves onto their closing side.
+struct PlayState {
+  int dir;        // -1 closing, +1 opening
+  float extreme;  // furthest opening reached in dir
+};
+static float s_play = 0.0f;
+static PlayState s_hotPlay{-1, 0.0f};
+static PlayState s_coldPlay{-1, 0.0f};
+
+// LEDC duty counts per µs of pulse width
+static constexpr float kCountsPerUs = (float) (1UL << SERVO_LEDC_RES_BITS) * SERVO_PWM_HZ / 1e6f;
+static_assert(SERVO_LEDC_CH_HOT != SERVO_LEDC_CH_COLD, "servo LEDC channels must differ");
 
 // Linear interpolation between two pulse widths
-static inline int lerp_us(int a, int b, float t) {
-  return (int) lroundf(a + (b - a) * t);
+static inline float lerp_us(float a, float b, float t) {
+  return a + (b - a) * t;
+}
+
+// Each table must run strictly one way (closed → open) so the inverse is unique
+static constexpr bool lutMonotonic(const uint16_t (&lut)[VALVE_LUT_POINTS]) {
+  const bool falling = lut[VALVE_LUT_POINTS - 1] < lut[0];
+  for (size_t i = 1; i < VALVE_LUT_POINTS; ++i) {
+    if (falling ? lut[i] >= lut[i - 1] : lut[i] <= lut[i - 1]) return false;
+  }
+  return true;
+}
+static_assert(VALVE_LUT_POINTS >= 2, "valve LUT needs at least two points");
+static_assert(lutMonotonic(VALVE_HOT_LUT_US), "VALVE_HOT_LUT_US must be strictly monotonic");
+static_assert(lutMonotonic(VALVE_COLD_LUT_US), "VALVE_COLD_LUT_US must be strictly monotonic");
+
+// Pulse width for flow fraction x ∈ [0,1]: points are evenly spaced in x,
+// so the segment is a multiply and truncate (no search)
+static inline float lut_us(const uint16_t (&lut)[VALVE_LUT_POINTS], float x) {
+  const float pos = x * (float) (VALVE_LUT_POINTS - 1);
+  size_t i = (size_t) pos;
+  if (i >= VALVE_LUT_POINTS - 1) i = VALVE_LUT_POINTS - 2;
+  return lerp_us(lut[i], lut[i + 1], pos - (float) i);
+}
+
+// Opening to command for the wanted opening, with the play taken up
+static float withPlay(PlayState& p, float open) {
+  if ((open - p.extreme) * (float) p.dir >= 0.0f) {
+    p.extreme = open;
+  } else if ((p.extreme - open) * (float) p.dir >= BACKLASH_REVERSAL_EPS) {
+    p.dir = -p.dir;
+    p.extreme = open;
+  }
+  return open + (float) p.dir * 0.5f * s_play;
+}
+
+// One LEDC timer for both channels, so their periods start together
+static bool startLedc() {
+  ledc_timer_config_t timerCfg{};
+  timerCfg.speed_mode = LEDC_LOW_SPEED_MODE;
+  timerCfg.duty_resolution = (ledc_timer_bit_t) SERVO_LEDC_RES_BITS;
+  timerCfg.timer_num = (ledc_timer_t) SERVO_LEDC_TIMER;
+  timerCfg.freq_hz = SERVO_PWM_HZ;
+  timerCfg.clk_cfg = LEDC_AUTO_CLK;
+  if (ledc_timer_config(&timerCfg) != ESP_OK) return false;
+
+  const uint8_t pins[2] = {SERVO_PIN_HOT, SERVO_PIN_COLD};
+  const uint8_t channels[2] = {SERVO_LEDC_CH_HOT, SERVO_LEDC_CH_COLD};
+  for (size_t i = 0; i < 2; ++i) {
+    ledc_channel_config_t chanCfg{};
+    chanCfg.gpio_num = pins[i];
+    chanCfg.speed_mode = LEDC_LOW_SPEED_MODE;
+    chanCfg.channel = (ledc_channel_t) channels[i];
+    chanCfg.intr_type = LEDC_INTR_DISABLE;
+    chanCfg.timer_sel = (ledc_timer_t) SERVO_LEDC_TIMER;
+    chanCfg.duty = 0;
+    chanCfg.hpoint = 0;
+    if (ledc_channel_config(&chanCfg) != ESP_OK) return false;
+  }
+  return true;
+}
+
+// Charge the time since the last call to the current drive state
+static void accountState(uint32_t nowMs) {
+  s_stats.stateMs[static_cast<size_t>(s_stats.state)] += nowMs - s_stateSinceMs;
+  s_stateSinceMs = nowMs;
+}
+
+// Stop both PWM outputs; the gear trains and stem friction hold the valves
+static void release(uint32_t nowMs) {
+  accountState(nowMs);
+  if (sLedc) {
+    ledc_stop(LEDC_LOW_SPEED_MODE, (ledc_channel_t) SERVO_LEDC_CH_HOT, 0);
+    ledc_stop(LEDC_LOW_SPEED_MODE, (ledc_channel_t) SERVO_LEDC_CH_COLD, 0);
+  } else {
+    sHot.detach();
+    sCold.detach();
+  }
+  s_stats.state = ValveDriveState::HELD;
+  s_stats.holds++;
+}
+
+// Drive again; the caller's write goes out in the same call
+static void engage(uint32_t nowMs) {
+  accountState(nowMs);
+  if (!sLedc) {
+    sHot.attach(SERVO_PIN_HOT);
+    sCold.attach(SERVO_PIN_COLD);
+  }
+  s_hotCode = s_coldCode = UINT32_MAX;  // outputs were stopped: rewrite both
+  s_stats.state = ValveDriveState::DRIVEN;
+  s_stats.reengages++;
+}
+
+// Commit both pulse widths. Values equal to the last write are skipped. LEDC
+// duties are staged first; the two update requests (each takes effect at the
+// next period start of the shared timer) then go out back-to-back in one
+// critical section, so no task, interrupt or the other core can split them.
+// Both channels switch in the same PWM frame unless the period boundary falls
+// in the few cycles between the two register writes; then the cold channel
+// follows one frame (1/SERVO_PWM_HZ) later. While held, moves inside
+// SERVO_HOLD_BAND_US are dropped; anything larger, or force, drives again.
+static void writePulses(float hotUs, float coldUs, bool force) {
+  const uint32_t nowMs = millis();
+  s_stats.updates++;
+  const bool moved = fabsf(hotUs - s_anchorHot) >= SERVO_HOLD_BAND_US ||
+                     fabsf(coldUs - s_anchorCold) >= SERVO_HOLD_BAND_US;
+  if (s_stats.state == ValveDriveState::HELD) {
+    if (!moved && !force) return;
+    engage(nowMs);
+  }
+  if (moved || force) {
+    s_anchorHot = hotUs;
+    s_anchorCold = coldUs;
+    s_steadySinceMs = nowMs;
+  }
+  g_lastHot = hotUs;
+  g_lastCold = coldUs;
+
+  const uint32_t hotCode = (uint32_t) lroundf(sLedc ? hotUs * kCountsPerUs : hotUs);
+  const uint32_t coldCode = (uint32_t) lroundf(sLedc ? coldUs * kCountsPerUs : coldUs);
+  const bool hotChanged = hotCode != s_hotCode;
+  const bool coldChanged = coldCode != s_coldCode;
+  if (!hotChanged && !coldChanged) return;
+  s_stats.writes++;
+
+  if (sLedc) {
+    if (hotChanged) ledc_set_duty(LEDC_LOW_SPEED_MODE, (ledc_channel_t) SERVO_LEDC_CH_HOT, hotCode);
+    if (coldChanged) ledc_set_duty(LEDC_LOW_SPEED_MODE, (ledc_channel_t) SERVO_LEDC_CH_COLD, coldCode);
+    portENTER_CRITICAL(&s_ledcMux);
+    if (hotChanged) ledc_update_duty(LEDC_LOW_SPEED_MODE, (ledc_channel_t) SERVO_LEDC_CH_HOT);
+    if (coldChanged) ledc_update_duty(LEDC_LOW_SPEED_MODE, (ledc_channel_t) SERVO_LEDC_CH_COLD);
+    portEXIT_CRITICAL(&s_ledcMux);
+  } else {
+    if (hotChanged) sHot.writeMicroseconds((int) hotCode);
+    if (coldChanged) sCold.writeMicroseconds((int) coldCode);
+  }
+  s_hotCode = hotCode;
+  s_coldCode = coldCode;
 }
 
 void valveMixInit() {
@@ -32,10 +200,18 @@ void valveMixInit() {
   coldSoftMin = cMin + SERVO_GUARD_US;
   coldSoftMax = cMax - SERVO_GUARD_US;
 
-  sHot.setPeriodHertz(50);
-  sCold.setPeriodHertz(50);
-  sHot.attach(SERVO_PIN_HOT);
-  sCold.attach(SERVO_PIN_COLD);
+  sLedc = SERVO_LEDC_DIRECT && startLedc();
+  if (!sLedc) {
+    sHot.setPeriodHertz(SERVO_PWM_HZ);
+    sCold.setPeriodHertz(SERVO_PWM_HZ);
+    sHot.attach(SERVO_PIN_HOT);
+    sCold.attach(SERVO_PIN_COLD);
+  }
+  s_hotCode = s_coldCode = UINT32_MAX;
+  s_stats = ValveMixStats{};
+  s_stats.ledc = sLedc;
+  s_stats.state = ValveDriveState::DRIVEN;
+  s_stateSinceMs = millis();
   sAttached = true;
 
   valveMixCloseAll();
@@ -44,31 +220,50 @@ void valveMixInit() {
 void valveMixCloseAll() {
   if (!sAttached) return;
 
-  sHot.writeMicroseconds(SERVO_HOT_MAX_US);
-  sCold.writeMicroseconds(SERVO_COLD_MAX_US);
+  writePulses(SERVO_HOT_MAX_US, SERVO_COLD_MAX_US, true);
+  s_hotPlay = s_coldPlay = PlayState{-1, 0.0f};
+}
+
+void valveMixSetPlay(float play) { s_play = play > 0.0f ? play : 0.0f; }
 
-  g_lastHot = SERVO_HOT_MAX_US;
-  g_lastCold = SERVO_COLD_MAX_US;
+void valveMixService() {
+  if (!sAttached) return;
+
+  const uint32_t nowMs = millis();
+  accountState(nowMs);
+  if (SERVO_HOLD_ENABLED && s_stats.state == ValveDriveState::DRIVEN && nowMs - s_steadySinceMs >= SERVO_HOLD_AFTER_MS) {
+    release(nowMs);
+  }
 }
 
-void applyMixRatio(float ratio) {
+void applyMixRatio(float ratio) { applyMixFlow(ratio, 1.0f); }
+
+void applyMixFlow(float ratio, float total) {
   if (!sAttached) return;
 
   const float r = constrain(ratio, 0.0f, 1.0f);
+  const float t = constrain(total, 0.0f, 1.0f);
+  const float hotOpen = constrain(withPlay(s_hotPlay, t * r), 0.0f, 1.0f);
+  const float coldOpen = constrain(withPlay(s_coldPlay, t * (1.0f - r)), 0.0f, 1.0f);
 
-  // HOT: r=0 → MAX (closed), r=1 → MIN (open)
-  int hotTarget = lerp_us(SERVO_HOT_MAX_US, SERVO_HOT_MIN_US, r);
-  // COLD: r=0 → MIN (open),   r=1 → MAX (closed)
-  int coldTarget = lerp_us(SERVO_COLD_MIN_US, SERVO_COLD_MAX_US, r);
+  float hotTarget, coldTarget;
+  if (VALVE_LUT_ENABLED) {
+    // Measured curves: hot passes t·r, cold t·(1 - r) of its full flow
+    hotTarget = lut_us(VALVE_HOT_LUT_US, hotOpen);
+    coldTarget = lut_us(VALVE_COLD_LUT_US, coldOpen);
+  } else {
+    // Opening fraction along the travel: MAX (closed) → MIN (open)
+    hotTarget = lerp_us(SERVO_HOT_MAX_US, SERVO_HOT_MIN_US, hotOpen);
+    coldTarget = lerp_us(SERVO_COLD_MAX_US, SERVO_COLD_MIN_US, coldOpen);
+  }
 
   hotTarget = constrain(hotTarget, hotSoftMin, hotSoftMax);
   coldTarget = constrain(coldTarget, coldSoftMin, coldSoftMax);
 
-  sHot.writeMicroseconds(hotTarget);
-  sCold.writeMicroseconds(coldTarget);
-  g_lastHot = hotTarget;
-  g_lastCold = coldTarget;
+  writePulses(hotTarget, coldTarget, false);
 }
 
-int lastHotUs() { return g_lastHot; }
-int lastColdUs() { return g_lastCold; }
+int lastHotUs() { return (int) lroundf(g_lastHot); }
+int lastColdUs() { return (int) lroundf(g_lastCold); }
+
+const ValveMixStats& valveMixStats() { return s_stats; }
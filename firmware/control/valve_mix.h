@@ -2,33 +2,90 @@
  * ================================================================
  *  Module: valve_mix
  *  Purpose: Provides servo control functions for hot and cold valves.
- *           Maps blend ratio [0.0–1.0] to calibrated servo positions.
+ *           Maps blend ratio [0.0–1.0] to calibrated servo positions,
+ *           through the measured per-valve flow curves (VALVE_*_LUT_US)
+ *           or a straight µs lerp between the calibrated limits.
+ *           applyMixFlow() also scales both openings by a total
+ *           (flow control): the ratio keeps setting the hot share of
+ *           the mix and the total sets how much flows. Stem play
+ *           (valveMixSetPlay) is taken up per valve, in each valve's
+ *           own direction of motion.
+ *           Pulses go out through the LEDC driver at SERVO_LEDC_RES_BITS
+ *           duty resolution (ESP32Servo fallback); unchanged values
+ *           are not rewritten. Once the pulses have been steady for
+ *           SERVO_HOLD_AFTER_MS the outputs are stopped and the
+ *           valves hold by friction; the next real move or
+ *           valveMixCloseAll() drives them again in the same call.
  *
  *  Dependencies:
  *    - config.h  (servo calibration constants and pin definitions)
- *    - ESP32Servo library
+ *    - driver/ledc.h (ESP-IDF LEDC driver)
+ *    - FreeRTOS  (critical section around the two LEDC updates)
+ *    - ESP32Servo library (fallback)
  *
  *  Interface:
  *    void valveMixInit();
  *    void applyMixRatio(float ratio);
+ *    void applyMixFlow(float ratio, float total);
+ *    void valveMixSetPlay(float play);
  *    void valveMixCloseAll();
+ *    void valveMixService();
  *    int  lastColdUs();
  *    int  lastHotUs();
+ *    const ValveMixStats& valveMixStats();
  * ================================================================
  */
 
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
+
+enum class ValveDriveState : uint8_t {
+  DRIVEN = 0,  // PWM on both servos
+  HELD,        // outputs stopped, valves left where they were
+  COUNT,
+};
+
+struct ValveMixStats {
+  bool ledc;         // direct LEDC driver in use (false: ESP32Servo)
+  uint32_t updates;  // applyMixFlow() / valveMixCloseAll() calls
+  uint32_t writes;   // calls that changed at least one valve's pulse
+  ValveDriveState state;
+  uint32_t stateMs[static_cast<size_t>(ValveDriveState::COUNT)];  // time in each state
+  uint32_t holds;      // DRIVEN → HELD
+  uint32_t reengages;  // HELD → DRIVEN
+};
+
 // Initialize and attach servos using pins & calibration from config.h
 void valveMixInit();
 
-// Close both valves (safe state)
+// Close both valves (safe state); always drives the servos, even if held
 void valveMixCloseAll();
 
+// Hold detector and state timers; call once per pass
+void valveMixService();
+
 // ratio ∈ [0,1]: 0 → all COLD (Cold open, Hot closed)
 //                1 → all HOT  (Hot open,  Cold closed)
+// With VALVE_LUT_ENABLED the hot valve passes `ratio` and the cold valve
+// `1 - ratio` of its full flow, so the ratio is linear in the hot share.
 void applyMixRatio(float ratio);
 
-// Optional helpers (useful for logging/tests)
+// As applyMixRatio(), with both openings scaled by total ∈ [0,1]: hot opens
+// to total·ratio and cold to total·(1 - ratio) of full flow. With the LUT the
+// hot share stays `ratio` while the flow follows `total`, so temperature and
+// flow can be set independently. applyMixRatio(r) == applyMixFlow(r, 1).
+void applyMixFlow(float ratio, float total);
+
+// Servo + stem play (fraction of full opening, from backlash_comp). Each
+// opening is offset by half of it in that valve's direction of motion, so the
+// stem lands where applyMixFlow() asked after a reversal. 0 = off.
+void valveMixSetPlay(float play);
+
+// Optional helpers (useful for logging/tests); nearest whole µs
 int lastColdUs();
 int lastHotUs();
+
+// Update/write counters and drive-state times since valveMixInit()
+const ValveMixStats& valveMixStats();
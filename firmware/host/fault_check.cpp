@@ -0,0 +1,485 @@
+// ====================================================
+// Host: Fault Check
+// Purpose: Drive faultEvaluate() (firmware/control/faults.cpp) with
+//          synthetic readings and check every rule's set and clear
+//          delays, the hysteresis bands, the run gating, and the mask,
+//          primary and raised/cleared bits when faults overlap.
+// Method:  a bench plays the control loop: a 10 ms pass, three DS18B20s
+//          sampling at their slowest periods, the health table fields
+//          the sensor rules read, E-stop, RUN and the UI link. Each case
+//          starts from faultInit(), changes one input at a known time
+//          and asserts when (to the pass) the fault latches and clears.
+// Usage:   build/fault_check [--verbose]
+//          Exit status 1 if any check fails.
+// ====================================================
+
+#include <Arduino.h>
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "faults.h"
+
+static constexpr uint32_t kPassMs = 10;
+
+static int s_failures = 0;
+static int s_checks = 0;
+static bool s_verbose = false;
+static const char* s_case = "";
+
+static void check(bool ok, const char* fmt, ...) {
+  s_checks++;
+  if (ok && !s_verbose) return;
+  char buf[160];
+  va_list ap;
+  va_start(ap, fmt);
+  vsnprintf(buf, sizeof(buf), fmt, ap);
+  va_end(ap);
+  printf("  %s %s: %s\n", ok ? "ok  " : "FAIL", s_case, buf);
+  if (!ok) s_failures++;
+}
+
+// One DS18B20 as the fault rules see it: reading plus its health fields
+struct SensorSim {
+  uint32_t periodMs;
+  bool present = true;
+  bool valid = true;
+  bool updating = true;  // false: reading stays valid but no new samples
+  float f = 0.0f;
+  uint32_t lastSampleMs = 0;
+  uint32_t nextSampleMs = 0;
+  uint32_t crcErrors = 0;
+  uint32_t noResponse = 0;
+  uint32_t failedReads = 0;
+  uint32_t dropouts = 0;
+  bool wasOk = false;
+};
+
+class Bench {
+ public:
+  Bench() {
+    sensor_[static_cast<size_t>(TempSensor::HOT)] = SensorSim{TEMP_LINE_MAX_PERIOD_MS};
+    sensor_[static_cast<size_t>(TempSensor::COLD)] = SensorSim{TEMP_LINE_MAX_PERIOD_MS};
+    sensor_[static_cast<size_t>(TempSensor::OUTLET)] = SensorSim{TEMP_OUTLET_MAX_PERIOD_MS};
+    sensor(TempSensor::HOT).f = 120.0f;
+    sensor(TempSensor::COLD).f = 60.0f;
+    sensor(TempSensor::OUTLET).f = 100.0f;
+    faultInit();
+  }
+
+  SensorSim& sensor(TempSensor s) { return sensor_[static_cast<size_t>(s)]; }
+  uint32_t now() const { return nowMs_; }
+  const FaultStatus& status() const { return status_; }
+
+  bool estop = false;
+  bool run = true;
+  bool linkUp = true;  // UI packets keep arriving
+
+  // One control pass at the next tick
+  const FaultStatus& pass() {
+    nowMs_ += kPassMs;
+    if (linkUp) lastRxMs_ = nowMs_;
+
+    FaultInputs in{};
+    in.nowMs = nowMs_;
+    in.estop = estop;
+    in.runRequested = run;
+    in.lastRxMs = lastRxMs_;
+    TemperatureReading* readings[TEMP_SENSOR_COUNT] = {&in.hot, &in.cold, &in.outlet};
+    for (size_t idx = 0; idx < TEMP_SENSOR_COUNT; ++idx) {
+      SensorSim& s = sensor_[idx];
+      const bool ok = s.present && s.valid;
+      if (ok && s.updating && (int32_t) (nowMs_ - s.nextSampleMs) >= 0) {
+        s.lastSampleMs = nowMs_;
+        s.nextSampleMs = nowMs_ + s.periodMs;
+      }
+      if (s.wasOk && !ok) s.dropouts++;
+      s.wasOk = ok;
+
+      TemperatureReading& r = *readings[idx];
+      r.present = s.present;
+      r.valid = s.valid;
+      r.sampleMs = s.lastSampleMs;
+      r.rawF = r.filteredF = r.estimateF = s.f;
+      r.estimateStdF = NAN;
+
+      SensorHealth& h = health_.channel[idx];
+      h.ok = ok;
+      h.ageMs = (s.lastSampleMs == 0) ? UINT32_MAX : nowMs_ - s.lastSampleMs;
+      h.crcErrors = s.crcErrors;
+      h.noResponse = s.noResponse;
+      h.failedReads = s.failedReads;
+      h.dropouts = s.dropouts;
+    }
+    health_.updatedMs = nowMs_;
+    in.health = &health_;
+
+    status_ = faultEvaluate(in);
+    return status_;
+  }
+
+  // Run passes for ms; record when code was first raised / cleared
+  void runFor(uint32_t ms, FaultCode code = FaultCode::None) {
+    const uint32_t end = nowMs_ + ms;
+    while ((int32_t) (end - nowMs_) > 0) {
+      pass();
+      if (code == FaultCode::None) continue;
+      if ((status_.raised & faultBit(code)) && raisedMs == 0) raisedMs = nowMs_;
+      if ((status_.cleared & faultBit(code)) && clearedMs == 0) clearedMs = nowMs_;
+      if (status_.raised & faultBit(code)) raises++;
+      if (status_.cleared & faultBit(code)) clears++;
+    }
+  }
+
+  bool active(FaultCode code) const { return status_.mask & faultBit(code); }
+
+  void resetEvents() {
+    raisedMs = clearedMs = 0;
+    raises = clears = 0;
+  }
+
+  uint32_t raisedMs = 0;
+  uint32_t clearedMs = 0;
+  uint32_t raises = 0;
+  uint32_t clears = 0;
+
+ private:
+  SensorSim sensor_[TEMP_SENSOR_COUNT];
+  SensorHealthReport health_{};
+  uint32_t nowMs_ = 1000;
+  uint32_t lastRxMs_ = 0;
+  FaultStatus status_{};
+};
+
+// Latched at t0 + delayMs, to the pass
+static void checkDelay(const char* what, uint32_t eventMs, uint32_t t0, uint32_t delayMs) {
+  const uint32_t latest = t0 + delayMs + kPassMs;
+  check(eventMs != 0 && eventMs >= t0 + delayMs && eventMs <= latest,
+        "%s at +%ld ms (expected +%lu..+%lu)",
+        what,
+        eventMs ? (long) (int32_t) (eventMs - t0) : -1L,
+        (unsigned long) delayMs,
+        (unsigned long) (latest - t0));
+}
+
+static void caseNominal() {
+  s_case = "nominal";
+  Bench b;
+  uint32_t everMask = 0;
+  for (int i = 0; i < 1000; ++i) everMask |= b.pass().mask;
+  check(everMask == 0, "no fault over 10 s of good readings (mask 0x%lx)", (unsigned long) everMask);
+}
+
+static void caseSensorUnplug(TempSensor s, FaultCode code, uint32_t setMs, const char* name) {
+  s_case = name;
+  Bench b;
+  b.runFor(3000);
+  b.resetEvents();
+  b.sensor(s).valid = false;
+  const uint32_t t0 = b.now() + kPassMs;
+  b.runFor(setMs + 500, code);
+  checkDelay("set", b.raisedMs, t0, setMs);
+  check(b.active(code), "active while the sensor stays invalid");
+
+  b.sensor(s).valid = true;
+  const uint32_t t1 = b.now() + kPassMs;
+  b.runFor(FAULT_SENSOR_CLEAR_MS + 500, code);
+  checkDelay("clear", b.clearedMs, t1, FAULT_SENSOR_CLEAR_MS);
+
+  // A glitch shorter than the set delay never latches
+  b.resetEvents();
+  b.sensor(s).valid = false;
+  b.runFor(setMs - 2 * kPassMs, code);
+  b.sensor(s).valid = true;
+  b.runFor(3000, code);
+  check(b.raises == 0, "invalid for %lu ms (< set delay) does not latch", (unsigned long) (setMs - 2 * kPassMs));
+}
+
+static void caseSensorStale() {
+  s_case = "outlet-stale";
+  Bench b;
+  b.runFor(3000);
+  b.sensor(TempSensor::OUTLET).updating = false;
+  b.runFor(kPassMs);
+  const uint32_t last = b.sensor(TempSensor::OUTLET).lastSampleMs;
+  b.resetEvents();
+  b.runFor(FAULT_OUTLET_SENSOR_STALE_MS + FAULT_OUTLET_SENSOR_SET_MS + 500, FaultCode::OutletSensorFault);
+  // Violated on the first pass with age > stale, latched a set delay later
+  checkDelay("set (valid but not updating)",
+             b.raisedMs,
+             last + FAULT_OUTLET_SENSOR_STALE_MS + kPassMs,
+             FAULT_OUTLET_SENSOR_SET_MS);
+
+  char msg[96];
+  faultFormatMessage(FaultCode::OutletSensorFault, true, msg, sizeof(msg));
+  check(strstr(msg, "Outlet sensor fault") != nullptr && strstr(msg, "last sample") != nullptr, "message \"%s\"", msg);
+}
+
+static void caseSensorErrors() {
+  s_case = "hot-errors";
+  Bench b;
+  SensorSim& hot = b.sensor(TempSensor::HOT);
+  b.runFor(3000);
+
+  // Recovered CRC errors (the retry read fine) do not count
+  hot.crcErrors += 2 * FAULT_SENSOR_ERROR_LIMIT;
+  b.runFor(3000, FaultCode::HotSensorFault);
+  check(b.raises == 0, "CRC errors fixed by the retry do not latch");
+
+  // One short of the limit: no fault
+  for (unsigned i = 0; i + 1 < FAULT_SENSOR_ERROR_LIMIT; ++i) {
+    hot.failedReads++;
+    b.runFor(500, FaultCode::HotSensorFault);
+  }
+  b.runFor(3000, FaultCode::HotSensorFault);
+  check(b.raises == 0, "%u failed reads in the window do not latch", FAULT_SENSOR_ERROR_LIMIT - 1);
+
+  // Let those age out, then reach the limit
+  b.runFor(FAULT_SENSOR_ERROR_WINDOW_MS);
+  b.resetEvents();
+  for (unsigned i = 0; i < FAULT_SENSOR_ERROR_LIMIT; ++i) {
+    hot.failedReads++;
+    if (i + 1 < FAULT_SENSOR_ERROR_LIMIT) b.runFor(500, FaultCode::HotSensorFault);
+  }
+  const uint32_t t0 = b.now() + kPassMs;
+  const uint32_t first = t0 - (FAULT_SENSOR_ERROR_LIMIT - 1) * 500;
+  b.runFor(FAULT_SENSOR_ERROR_WINDOW_MS + FAULT_SENSOR_CLEAR_MS + 1000, FaultCode::HotSensorFault);
+  checkDelay("set on the limit-th failed read", b.raisedMs, t0, FAULT_LINE_SENSOR_SET_MS);
+  // Clears once the first error leaves the window, plus the clear delay
+  checkDelay("clear after the failed reads age out",
+             b.clearedMs,
+             first + FAULT_SENSOR_ERROR_WINDOW_MS + kPassMs,
+             FAULT_SENSOR_CLEAR_MS);
+}
+
+// What temperature.cpp reports for one read that fails CRC on both tries:
+// two CRC errors, one failed read, no valid reading for a period, then the
+// next read is fine
+static void caseSensorGlitch() {
+  s_case = "hot-glitch";
+  Bench b;
+  SensorSim& hot = b.sensor(TempSensor::HOT);
+  b.runFor(3000);
+
+  hot.crcErrors += 2;
+  hot.failedReads++;
+  hot.valid = false;
+  b.runFor(TEMP_LINE_MAX_PERIOD_MS, FaultCode::HotSensorFault);
+  hot.valid = true;
+  b.runFor(FAULT_SENSOR_ERROR_WINDOW_MS + 1000, FaultCode::HotSensorFault);
+  check(b.raises == 0 && !b.active(FaultCode::HotSensorFault), "one read failing CRC twice does not latch");
+  check(hot.dropouts == 1, "counted as one dropout (%lu)", (unsigned long) hot.dropouts);
+}
+
+static void caseBoundsHysteresis() {
+  s_case = "outlet-bounds";
+  Bench b;
+  SensorSim& out = b.sensor(TempSensor::OUTLET);
+  b.runFor(1000);
+
+  out.f = OUTLET_MAX_PLAUSIBLE_F + 1.0f;
+  const uint32_t t0 = b.now() + kPassMs;
+  b.runFor(200, FaultCode::OutletOutOfBounds);
+  checkDelay("set", b.raisedMs, t0, FAULT_BOUNDS_SET_MS);
+
+  char msg[96];
+  faultFormatMessage(FaultCode::OutletOutOfBounds, true, msg, sizeof(msg));
+  char expect[32];
+  snprintf(expect, sizeof(expect), "Outlet %.1fF", OUTLET_MAX_PLAUSIBLE_F + 1.0f);
+  check(strstr(msg, expect) != nullptr, "message \"%s\" shows the reading", msg);
+
+  // Back inside, but within the hysteresis band: stays active
+  out.f = OUTLET_MAX_PLAUSIBLE_F - 0.5f * FAULT_TEMP_HYST_F;
+  b.runFor(5000, FaultCode::OutletOutOfBounds);
+  check(b.active(FaultCode::OutletOutOfBounds) && b.clears == 0, "holds inside the hysteresis band");
+
+  out.f = OUTLET_MAX_PLAUSIBLE_F - 1.5f * FAULT_TEMP_HYST_F;
+  const uint32_t t1 = b.now() + kPassMs;
+  b.runFor(FAULT_BOUNDS_CLEAR_MS + 500, FaultCode::OutletOutOfBounds);
+  checkDelay("clear past the band", b.clearedMs, t1, FAULT_BOUNDS_CLEAR_MS);
+
+  // A reading dithering across the limit raises once and never chatters
+  b.resetEvents();
+  for (int i = 0; i < 500; ++i) {
+    out.f = OUTLET_MAX_PLAUSIBLE_F + ((i & 1) ? 0.2f : -0.2f);
+    b.runFor(kPassMs, FaultCode::OutletOutOfBounds);
+  }
+  check(b.raises == 1 && b.clears == 0,
+        "dithering ±0.2F at the limit: %lu raise(s), %lu clear(s)",
+        (unsigned long) b.raises,
+        (unsigned long) b.clears);
+
+  // The low limit too
+  s_case = "cold-bounds";
+  Bench c;
+  c.runFor(1000);
+  c.sensor(TempSensor::COLD).f = COLD_MIN_PLAUSIBLE_F - 0.5f;
+  c.runFor(100, FaultCode::ColdOutOfBounds);
+  check(c.raises == 1, "below the low limit sets");
+  c.sensor(TempSensor::COLD).f = COLD_MIN_PLAUSIBLE_F + 0.5f * FAULT_TEMP_HYST_F;
+  c.runFor(3000, FaultCode::ColdOutOfBounds);
+  check(c.clears == 0, "holds inside the hysteresis band above the low limit");
+}
+
+static void caseRapidChange() {
+  s_case = "hot-rapid";
+  Bench b;
+  SensorSim& hot = b.sensor(TempSensor::HOT);
+  b.runFor(3000);
+
+  const uint32_t before = hot.lastSampleMs;  // last pre-jump sample
+  hot.f += TEMP_RAPID_DELTA_F + 1.0f;
+  hot.nextSampleMs = b.now() + kPassMs;  // next sample on the next pass
+  const uint32_t t0 = b.now() + kPassMs;
+  b.runFor(500, FaultCode::HotRapidChange);
+  checkDelay("set on a jump > TEMP_RAPID_DELTA_F", b.raisedMs, t0, 0);
+
+  // Calm once the pre-jump sample leaves the rapid window, then the clear delay
+  b.runFor(TEMP_RAPID_WINDOW_MS + FAULT_RAPID_CLEAR_MS + 1000, FaultCode::HotRapidChange);
+  checkDelay("clear", b.clearedMs, before + TEMP_RAPID_WINDOW_MS + kPassMs, FAULT_RAPID_CLEAR_MS);
+
+  // A jump inside the limit does not set
+  b.resetEvents();
+  hot.f -= TEMP_RAPID_DELTA_F - 1.0f;
+  b.runFor(3000, FaultCode::HotRapidChange);
+  check(b.raises == 0, "jump of %.0fF does not set", TEMP_RAPID_DELTA_F - 1.0f);
+
+  // Run-gated: no evaluation while RUN is off ...
+  b.run = false;
+  b.runFor(1000);
+  hot.f += TEMP_RAPID_DELTA_F + 1.0f;
+  b.runFor(2000, FaultCode::HotRapidChange);
+  check(b.raises == 0, "jump while stopped does not set");
+
+  // ... and an active rapid fault holds its state while stopped
+  b.run = true;
+  b.runFor(2000);
+  hot.f -= TEMP_RAPID_DELTA_F + 1.0f;
+  b.runFor(500, FaultCode::HotRapidChange);
+  check(b.active(FaultCode::HotRapidChange), "set again after RUN");
+  b.run = false;
+  b.runFor(FAULT_RAPID_CLEAR_MS + TEMP_RAPID_WINDOW_MS + 2000, FaultCode::HotRapidChange);
+  check(b.active(FaultCode::HotRapidChange), "held (not cleared) while RUN is off");
+}
+
+static void caseEStopAndLink() {
+  s_case = "estop";
+  Bench b;
+  b.runFor(500);
+  b.estop = true;
+  const uint32_t t0 = b.now() + kPassMs;
+  b.runFor(200, FaultCode::EStop);
+  checkDelay("set", b.raisedMs, t0, 0);
+  check(FAULT_DROPS_RUN_MASK & faultBit(FaultCode::EStop), "in FAULT_DROPS_RUN_MASK");
+  b.estop = false;
+  const uint32_t t1 = b.now() + kPassMs;
+  b.runFor(500, FaultCode::EStop);
+  checkDelay("clear", b.clearedMs, t1, FAULT_ESTOP_CLEAR_MS);
+
+  s_case = "link-loss";
+  Bench l;
+  l.runFor(500);
+  l.linkUp = false;
+  const uint32_t lastRx = l.now();
+  l.runFor(COMM_LINK_TIMEOUT_MS + 500, FaultCode::LinkLoss);
+  checkDelay("set after COMM_LINK_TIMEOUT_MS", l.raisedMs, lastRx + COMM_LINK_TIMEOUT_MS + kPassMs, 0);
+  l.linkUp = true;
+  l.runFor(100, FaultCode::LinkLoss);
+  check(l.clears == 1 && !l.active(FaultCode::LinkLoss), "clears on the next packet");
+
+  // Link loss drops RUN (FAULT_DROPS_RUN_MASK); it still clears on the next
+  // packet while RUN stays off, and holds while the link stays down
+  Bench r;
+  r.runFor(500);
+  r.linkUp = false;
+  r.runFor(COMM_LINK_TIMEOUT_MS + 500, FaultCode::LinkLoss);
+  check(r.raises == 1, "set while running");
+  r.run = false;
+  r.runFor(2000, FaultCode::LinkLoss);
+  check(r.active(FaultCode::LinkLoss), "held with RUN off while the link is down");
+  r.linkUp = true;
+  const uint32_t t2 = r.now() + kPassMs;
+  r.runFor(100, FaultCode::LinkLoss);
+  checkDelay("clear with RUN off on the next packet", r.clearedMs, t2, 0);
+  check(!r.active(FaultCode::LinkLoss) && r.status().mask == 0, "mask empty after the link returns");
+
+  Bench s;
+  s.run = false;
+  s.linkUp = false;
+  s.runFor(COMM_LINK_TIMEOUT_MS * 2, FaultCode::LinkLoss);
+  check(s.raises == 0, "no link-loss fault while RUN is off");
+}
+
+static void caseSimultaneous() {
+  s_case = "simultaneous";
+  Bench b;
+  b.runFor(3000);
+
+  // Two faults latching on the same pass both show in 'raised'
+  b.estop = true;
+  b.sensor(TempSensor::OUTLET).f = OUTLET_MAX_PLAUSIBLE_F + 5.0f;
+  const FaultStatus& st = b.pass();
+  const uint32_t both = faultBit(FaultCode::EStop) | faultBit(FaultCode::OutletOutOfBounds);
+  check(st.raised == both && st.mask == both, "raised 0x%lx, mask 0x%lx (expected 0x%lx)",
+        (unsigned long) st.raised, (unsigned long) st.mask, (unsigned long) both);
+  check(st.primary == FaultCode::EStop, "primary %s (expected estop)", faultName(st.primary));
+
+  // A third one later: only its own bit in 'raised'
+  b.sensor(TempSensor::HOT).valid = false;
+  b.resetEvents();
+  b.runFor(FAULT_LINE_SENSOR_SET_MS + 200, FaultCode::HotSensorFault);
+  const uint32_t all = both | faultBit(FaultCode::HotSensorFault);
+  check(b.status().mask == all, "mask 0x%lx (expected 0x%lx)", (unsigned long) b.status().mask, (unsigned long) all);
+  check(b.raises == 1, "hot-sensor raised once");
+  check(b.status().raised == 0, "no raised bits on a steady pass");
+  check(b.status().primary == FaultCode::EStop, "primary still estop");
+
+  // Primary falls to the next rule in table order once E-stop clears
+  b.estop = false;
+  b.runFor(FAULT_ESTOP_CLEAR_MS + 100);
+  check(b.status().mask == (all & ~faultBit(FaultCode::EStop)), "E-stop cleared, others kept");
+  check(b.status().primary == FaultCode::HotSensorFault, "primary %s (expected hot-sensor)",
+        faultName(b.status().primary));
+  check(faultPrimary(b.status().mask) == b.status().primary, "faultPrimary(mask) agrees");
+  check(faultMask() == b.status().mask, "faultMask() agrees");
+
+  // Bounds are judged only on usable readings: an unplugged outlet reports
+  // the sensor fault, and its stale out-of-range value no longer counts
+  b.sensor(TempSensor::OUTLET).valid = false;
+  b.resetEvents();
+  b.runFor(FAULT_BOUNDS_CLEAR_MS + 200, FaultCode::OutletOutOfBounds);
+  check(b.clears == 1, "outlet-bounds clears once the outlet reading is unusable");
+  b.runFor(FAULT_OUTLET_SENSOR_SET_MS);
+  check(b.active(FaultCode::OutletSensorFault), "outlet-sensor set instead");
+  check(faultPrimary(faultBit(FaultCode::OutletSensorFault) | faultBit(FaultCode::OutletOutOfBounds)) ==
+            FaultCode::OutletSensorFault,
+        "outlet-sensor outranks outlet-bounds");
+}
+
+int main(int argc, char** argv) {
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "--verbose")) {
+      s_verbose = true;
+    } else {
+      fprintf(stderr, "usage: %s [--verbose]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  caseNominal();
+  caseSensorUnplug(TempSensor::OUTLET, FaultCode::OutletSensorFault, FAULT_OUTLET_SENSOR_SET_MS, "outlet-sensor");
+  caseSensorUnplug(TempSensor::HOT, FaultCode::HotSensorFault, FAULT_LINE_SENSOR_SET_MS, "hot-sensor");
+  caseSensorUnplug(TempSensor::COLD, FaultCode::ColdSensorFault, FAULT_LINE_SENSOR_SET_MS, "cold-sensor");
+  caseSensorStale();
+  caseSensorErrors();
+  caseSensorGlitch();
+  caseBoundsHysteresis();
+  caseRapidChange();
+  caseEStopAndLink();
+  caseSimultaneous();
+
+  printf("fault_check: %d checks, %d failed\n", s_checks, s_failures);
+  return s_failures ? 1 : 0;
+}
@@ -0,0 +1,112 @@
+/*
+ * ================================================================
+ *  Module: Arduino (host stand-in)
+ *  Purpose: Minimal subset of the ESP32 Arduino core so firmware
+ *           modules compile natively on Linux. Timing functions run
+ *           on the virtual clock in host_clock.h; Serial writes to
+ *           a stdio stream (stdout by default).
+ * ================================================================
+ */
+
+#pragma once
+
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "host_clock.h"
+
+using std::isinf;
+using std::isnan;
+using std::max;
+using std::min;
+
+#define IRAM_ATTR
+#define F(s) (s)
+
+#define LOW 0x0
+#define HIGH 0x1
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// --- Timing (virtual clock) ---
+inline unsigned long millis() { return (unsigned long) (hostNowUs() / 1000); }
+inline unsigned long micros() { return (unsigned long) hostNowUs(); }
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+// --- GPIO (levels are injected by the simulation) ---
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t level);
+inline int digitalPinToInterrupt(uint8_t pin) { return pin; }
+void attachInterrupt(int irq, void (*isr)(), int mode);
+void detachInterrupt(int irq);
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+// --- CPU ---
+// Host "cycles" are wall-clock nanoseconds, i.e. a nominal 1000 MHz core, so
+// profiler numbers measure the native build rather than the virtual clock.
+class EspClass {
+ public:
+  uint32_t getCycleCount();
+};
+
+extern EspClass ESP;
+inline uint32_t getCpuFrequencyMhz() { return 1000; }
+
+// --- Serial ---
+class HostSerial {
+ public:
+  void begin(unsigned long baud) { (void) baud; }
+  void setOutput(FILE* out) { out_ = out; }
+
+  size_t write(uint8_t b) { return out_ ? fwrite(&b, 1, 1, out_) : 1; }
+  size_t write(const uint8_t* buf, size_t len) { return out_ ? fwrite(buf, 1, len, out_) : len; }
+  int availableForWrite() { return 256; }
+  int available() { return 0; }
+  int read() { return -1; }
+  void flush() {
+    if (out_) fflush(out_);
+  }
+
+  size_t print(const char* s) { return out_ ? (size_t) fprintf(out_, "%s", s) : strlen(s); }
+  size_t print(int v) { return printf("%d", v); }
+  size_t print(unsigned v) { return printf("%u", v); }
+  size_t print(long v) { return printf("%ld", v); }
+  size_t print(unsigned long v) { return printf("%lu", v); }
+  size_t print(double v, int digits = 2) { return printf("%.*f", digits, v); }
+  template <typename T>
+  size_t println(T v) {
+    const size_t n = print(v);
+    return n + print("\n");
+  }
+  size_t println() { return print("\n"); }
+
+  size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+    va_list args;
+    va_start(args, fmt);
+    int n = out_ ? vfprintf(out_, fmt, args) : vsnprintf(nullptr, 0, fmt, args);
+    va_end(args);
+    return n < 0 ? 0 : (size_t) n;
+  }
+
+ private:
+  FILE* out_ = stdout;
+};
+
+extern HostSerial Serial;
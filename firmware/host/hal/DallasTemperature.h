@@ -0,0 +1,36 @@
+// Host stand-in for DallasTemperature. Temperatures are injected per ROM
+// address by the simulation (host_io.h); requestTemperatures() latches them
+// and isConversionComplete() honours the DS18B20 conversion time for the
+// configured resolution. Readings are quantized to that resolution.
+#pragma once
+
+#include <stdint.h>
+
+#include "OneWire.h"
+
+typedef uint8_t DeviceAddress[8];
+
+constexpr float DEVICE_DISCONNECTED_C = -127.0f;
+
+class DallasTemperature {
+ public:
+  explicit DallasTemperature(OneWire* bus) : bus_(bus) {}
+
+  void begin() {}
+  void setWaitForConversion(bool wait) { waitForConversion_ = wait; }
+  void setCheckForConversion(bool check) { checkForConversion_ = check; }
+  bool isConnected(const uint8_t* addr);
+  bool setResolution(const uint8_t* addr, uint8_t bits);
+  void requestTemperatures();
+  bool requestTemperaturesByAddress(const uint8_t* addr);
+  bool isConversionComplete();
+  float getTempC(const uint8_t* addr);
+
+  static float toFahrenheit(float c) { return c * 1.8f + 32.0f; }
+  static uint16_t millisToWaitForConversion(uint8_t bits);
+
+ private:
+  OneWire* bus_;
+  bool waitForConversion_ = true;
+  bool checkForConversion_ = true;
+};
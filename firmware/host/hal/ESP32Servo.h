@@ -0,0 +1,23 @@
+// Host stand-in for the ESP32Servo library. Commanded pulse widths are
+// recorded per pin and read back by the simulation via host_io.h.
+#pragma once
+
+#include <Arduino.h>
+#include <stdint.h>
+
+class Servo {
+ public:
+  void setPeriodHertz(int hz) { periodHz_ = hz; }
+  int attach(int pin, int minUs = 500, int maxUs = 2500);
+  void detach();
+  bool attached() const { return pin_ >= 0; }
+  void writeMicroseconds(int us);
+  int readMicroseconds() const { return us_; }
+
+ private:
+  int pin_ = -1;
+  int periodHz_ = 50;
+  int minUs_ = 500;
+  int maxUs_ = 2500;
+  int us_ = 0;
+};
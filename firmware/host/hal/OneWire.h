@@ -0,0 +1,29 @@
+// Host stand-in for the OneWire library. The bus is shared with the
+// DallasTemperature stand-in: reset/select/write/read reach the same
+// simulated DS18B20s (host_devices.cpp), which decode the ROM and function
+// commands the firmware sends directly (Convert T, Write/Read Scratchpad).
+// Every slot is charged to a bus-time counter (hostOneWireBusUs()) at
+// standard-speed timings and advances the virtual clock.
+#pragma once
+
+#include <stdint.h>
+
+class OneWire {
+ public:
+  explicit OneWire(uint8_t pin) : pin_(pin) {}
+  uint8_t pin() const { return pin_; }
+
+  uint8_t reset();
+  void select(const uint8_t rom[8]);
+  void skip();
+  void write(uint8_t v, uint8_t power = 0);
+  uint8_t read();
+  void read_bytes(uint8_t* buf, uint16_t count);
+  uint8_t read_bit();
+  void depower() {}
+
+  static uint8_t crc8(const uint8_t* addr, uint8_t len);
+
+ private:
+  uint8_t pin_;
+};
@@ -0,0 +1,9 @@
+// Host stand-in for ESP-IDF esp_err.h (the codes the firmware checks)
+#pragma once
+
+typedef int esp_err_t;
+
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_INVALID_STATE 0x103
@@ -0,0 +1,8 @@
+// Host stand-in for ESP-IDF esp_timer (virtual µs clock)
+#pragma once
+
+#include <stdint.h>
+
+#include "host_clock.h"
+
+inline int64_t esp_timer_get_time() { return hostNowUs(); }
@@ -0,0 +1,11 @@
+// Host stand-in for FreeRTOS.h
+#pragma once
+
+#include "portmacro.h"
+
+#define pdTRUE ((BaseType_t) 1)
+#define pdFALSE ((BaseType_t) 0)
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+#define pdMS_TO_TICKS(ms) ((TickType_t) (ms))
+#define configTICK_RATE_HZ 1000
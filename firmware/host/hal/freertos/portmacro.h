@@ -0,0 +1,24 @@
+// Host stand-in for FreeRTOS port macros (single-threaded simulation)
+#pragma once
+
+#include <stdint.h>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+struct portMUX_TYPE {
+  int owner;
+};
+
+#define portMUX_INITIALIZER_UNLOCKED \
+  { 0 }
+#define portENTER_CRITICAL(mux) ((void) (mux))
+#define portEXIT_CRITICAL(mux) ((void) (mux))
+#define portENTER_CRITICAL_ISR(mux) ((void) (mux))
+#define portEXIT_CRITICAL_ISR(mux) ((void) (mux))
+
+#define portYIELD_FROM_ISR() ((void) 0)
+
+#define portTICK_PERIOD_MS 1
+#define portMAX_DELAY ((TickType_t) 0xffffffffUL)
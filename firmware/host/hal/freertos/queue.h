@@ -0,0 +1,13 @@
+// Host stand-in for FreeRTOS queues (bounded FIFO of fixed-size items)
+#pragma once
+
+#include "FreeRTOS.h"
+
+struct HostQueue;
+typedef HostQueue* QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+BaseType_t xQueueSend(QueueHandle_t q, const void* item, TickType_t wait);
+BaseType_t xQueueReceive(QueueHandle_t q, void* out, TickType_t wait);
+BaseType_t xQueuePeek(QueueHandle_t q, void* out, TickType_t wait);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q);
@@ -0,0 +1,28 @@
+// Host stand-in for FreeRTOS tasks. Tasks are recorded but never run;
+// a host simulation calls the stage bodies directly instead. The calling
+// thread (setup()/loop()) has one notification counter; waiting on it
+// advances the virtual clock until a notification arrives or it times out.
+#pragma once
+
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+
+typedef void (*TaskFunction_t)(void*);
+typedef void* TaskHandle_t;
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn,
+                                   const char* name,
+                                   uint32_t stackBytes,
+                                   void* arg,
+                                   UBaseType_t priority,
+                                   TaskHandle_t* outHandle,
+                                   BaseType_t core);
+TickType_t xTaskGetTickCount();
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t* lastWake, TickType_t period);
+
+TaskHandle_t xTaskGetCurrentTaskHandle();
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higherPriorityTaskWoken);
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait);
@@ -0,0 +1,30 @@
+/*
+ * ================================================================
+ *  Module: host_clock
+ *  Purpose: Virtual time base shared by the host stand-ins for the
+ *           Arduino core, esp_timer and FreeRTOS. Nothing advances
+ *           it implicitly except delay()/delayMicroseconds(), which
+ *           forward to an optional hook so a simulation can step
+ *           its plant model while firmware code "sleeps".
+ *
+ *  Interface:
+ *    int64_t hostNowUs();
+ *    void hostSetNowUs(int64_t us);
+ *    void hostAdvanceUs(int64_t us);
+ *    void hostSetDelayHook(HostDelayHook hook);
+ * ================================================================
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+// Called instead of advancing the clock directly when firmware calls delay()
+typedef void (*HostDelayHook)(uint32_t us);
+
+int64_t hostNowUs();
+void hostSetNowUs(int64_t us);
+void hostAdvanceUs(int64_t us);
+
+// nullptr restores the default behavior (advance the clock by the delay)
+void hostSetDelayHook(HostDelayHook hook);
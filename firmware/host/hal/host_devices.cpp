@@ -0,0 +1,448 @@
+// Host implementations for the Servo, LEDC, DallasTemperature and EspNowLink stand-ins
+
+#include <DallasTemperature.h>
+#include <ESP32Servo.h>
+#include <EspNowLink.h>
+#include <driver/ledc.h>
+#include <math.h>
+#include <string.h>
+
+#include "host_clock.h"
+#include "host_io.h"
+
+// ====================================================
+// Servo
+// ====================================================
+
+static constexpr int kPinCount = 40;
+static float s_servoUs[kPinCount];
+
+int Servo::attach(int pin, int minUs, int maxUs) {
+  if (pin < 0 || pin >= kPinCount) return 0;
+  pin_ = pin;
+  minUs_ = minUs;
+  maxUs_ = maxUs;
+  return 1;
+}
+
+void Servo::detach() {
+  if (pin_ >= 0) s_servoUs[pin_] = 0;
+  pin_ = -1;
+}
+
+void Servo::writeMicroseconds(int us) {
+  if (pin_ < 0) return;
+  us_ = us < minUs_ ? minUs_ : (us > maxUs_ ? maxUs_ : us);
+  s_servoUs[pin_] = (float) us_;
+}
+
+float hostServoPulseUs(uint8_t pin) { return pin < kPinCount ? s_servoUs[pin] : 0.0f; }
+
+// ====================================================
+// LEDC
+// ====================================================
+
+static constexpr uint32_t kLedcSourceHz = 80000000;  // APB clock
+
+struct HostLedcTimer {
+  uint32_t freqHz;
+  uint8_t bits;
+};
+
+struct HostLedcChannel {
+  int gpio;  // -1 = not configured
+  ledc_timer_t timer;
+  uint32_t duty;  // staged by ledc_set_duty()
+  uint32_t latched;
+};
+
+static HostLedcTimer s_ledcTimers[LEDC_TIMER_MAX];
+static HostLedcChannel s_ledcChannels[LEDC_CHANNEL_MAX] = {
+    {-1, LEDC_TIMER_0, 0, 0}, {-1, LEDC_TIMER_0, 0, 0}, {-1, LEDC_TIMER_0, 0, 0}, {-1, LEDC_TIMER_0, 0, 0},
+    {-1, LEDC_TIMER_0, 0, 0}, {-1, LEDC_TIMER_0, 0, 0}, {-1, LEDC_TIMER_0, 0, 0}, {-1, LEDC_TIMER_0, 0, 0},
+};
+
+static void ledcPublish(const HostLedcChannel& ch) {
+  const HostLedcTimer& t = s_ledcTimers[ch.timer];
+  if (ch.gpio < 0 || ch.gpio >= kPinCount || t.freqHz == 0) return;
+  s_servoUs[ch.gpio] = (float) ((double) ch.latched * 1e6 / ((double) t.freqHz * (double) (1UL << t.bits)));
+}
+
+esp_err_t ledc_timer_config(const ledc_timer_config_t* timer_conf) {
+  if (!timer_conf || timer_conf->timer_num >= LEDC_TIMER_MAX || timer_conf->duty_resolution < 1 ||
+      timer_conf->duty_resolution > 20 || timer_conf->freq_hz == 0) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  // The counter must fit in one period of the source clock, as on the chip
+  if ((uint64_t) timer_conf->freq_hz << timer_conf->duty_resolution > kLedcSourceHz) return ESP_FAIL;
+  s_ledcTimers[timer_conf->timer_num] = {timer_conf->freq_hz, (uint8_t) timer_conf->duty_resolution};
+  return ESP_OK;
+}
+
+esp_err_t ledc_channel_config(const ledc_channel_config_t* ledc_conf) {
+  if (!ledc_conf || ledc_conf->channel >= LEDC_CHANNEL_MAX || ledc_conf->timer_sel >= LEDC_TIMER_MAX) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  HostLedcChannel& ch = s_ledcChannels[ledc_conf->channel];
+  ch.gpio = ledc_conf->gpio_num;
+  ch.timer = ledc_conf->timer_sel;
+  ch.duty = ch.latched = ledc_conf->duty;
+  ledcPublish(ch);
+  return ESP_OK;
+}
+
+esp_err_t ledc_set_duty(ledc_mode_t speed_mode, ledc_channel_t channel, uint32_t duty) {
+  if (channel >= LEDC_CHANNEL_MAX || s_ledcChannels[channel].gpio < 0) return ESP_ERR_INVALID_STATE;
+  s_ledcChannels[channel].duty = duty;
+  return ESP_OK;
+}
+
+esp_err_t ledc_update_duty(ledc_mode_t speed_mode, ledc_channel_t channel) {
+  if (channel >= LEDC_CHANNEL_MAX || s_ledcChannels[channel].gpio < 0) return ESP_ERR_INVALID_STATE;
+  HostLedcChannel& ch = s_ledcChannels[channel];
+  ch.latched = ch.duty;
+  ledcPublish(ch);
+  return ESP_OK;
+}
+
+uint32_t ledc_get_duty(ledc_mode_t speed_mode, ledc_channel_t channel) {
+  return channel < LEDC_CHANNEL_MAX ? s_ledcChannels[channel].latched : 0;
+}
+
+esp_err_t ledc_stop(ledc_mode_t speed_mode, ledc_channel_t channel, uint32_t idle_level) {
+  if (channel >= LEDC_CHANNEL_MAX || s_ledcChannels[channel].gpio < 0) return ESP_ERR_INVALID_STATE;
+  HostLedcChannel& ch = s_ledcChannels[channel];
+  ch.duty = ch.latched = 0;
+  if (ch.gpio < kPinCount) s_servoUs[ch.gpio] = 0.0f;
+  return ESP_OK;
+}
+
+// ====================================================
+// DS18B20 bus
+// ====================================================
+
+struct HostDs18b20 {
+  uint8_t addr[8];
+  bool connected;
+  uint8_t resolution;
+  float liveC;        // what the sensor would measure now
+  float latchedC;     // result of the last conversion
+  int64_t readyUs;    // conversion in progress until then
+  uint8_t corruptReads;  // next scratchpad reads returned with a flipped bit
+};
+
+static constexpr size_t kMaxDevices = 8;
+static HostDs18b20 s_devices[kMaxDevices];
+static size_t s_deviceCount = 0;
+
+// Standard-speed 1-Wire timings (µs): reset + presence, one bit slot. The
+// OneWire library bit-bangs with delayMicroseconds(), so bus time also
+// passes on the virtual clock.
+static constexpr uint32_t kResetUs = 960;
+static constexpr uint32_t kSlotUs = 65;
+static uint64_t s_busUs = 0;
+
+static void busTime(uint32_t us) {
+  s_busUs += us;
+  delayMicroseconds(us);
+}
+static void busReset() { busTime(kResetUs); }
+static void busBytes(uint32_t n) { busTime(n * 8 * kSlotUs); }
+
+uint64_t hostOneWireBusUs() { return s_busUs; }
+
+static HostDs18b20* findDevice(const uint8_t* addr, bool create) {
+  for (size_t i = 0; i < s_deviceCount; ++i) {
+    if (memcmp(s_devices[i].addr, addr, 8) == 0) return &s_devices[i];
+  }
+  if (!create || s_deviceCount >= kMaxDevices) return nullptr;
+  HostDs18b20& d = s_devices[s_deviceCount++];
+  memcpy(d.addr, addr, 8);
+  d.connected = true;
+  d.resolution = 12;
+  d.liveC = 20.0f;
+  d.latchedC = 85.0f;  // DS18B20 power-on value
+  d.readyUs = 0;
+  d.corruptReads = 0;
+  return &d;
+}
+
+void hostDallasSetConnected(const uint8_t addr[8], bool connected) {
+  findDevice(addr, true)->connected = connected;
+}
+
+void hostDallasSetTempC(const uint8_t addr[8], float tempC) {
+  findDevice(addr, true)->liveC = tempC;
+}
+
+void hostDallasCorruptReads(const uint8_t addr[8], uint8_t count) {
+  findDevice(addr, true)->corruptReads += count;
+}
+
+uint16_t DallasTemperature::millisToWaitForConversion(uint8_t bits) {
+  switch (bits) {
+    case 9:
+      return 94;
+    case 10:
+      return 188;
+    case 11:
+      return 375;
+    default:
+      return 750;
+  }
+}
+
+bool DallasTemperature::isConnected(const uint8_t* addr) {
+  const HostDs18b20* d = findDevice(addr, false);
+  return d && d->connected;
+}
+
+bool DallasTemperature::setResolution(const uint8_t* addr, uint8_t bits) {
+  HostDs18b20* d = findDevice(addr, false);
+  if (!d || !d->connected) return false;
+  d->resolution = bits;
+  return true;
+}
+
+// Start a conversion: the result is sampled now and readable once it completes
+static void startConversion(HostDs18b20& d) {
+  const float step = 0.0625f * (float) (1 << (12 - d.resolution));
+  d.latchedC = roundf(d.liveC / step) * step;
+  d.readyUs = hostNowUs() + (int64_t) DallasTemperature::millisToWaitForConversion(d.resolution) * 1000;
+}
+
+static int64_t latestReadyUs() {
+  int64_t latest = 0;
+  for (size_t i = 0; i < s_deviceCount; ++i) {
+    if (s_devices[i].connected && s_devices[i].readyUs > latest) latest = s_devices[i].readyUs;
+  }
+  return latest;
+}
+
+void DallasTemperature::requestTemperatures() {
+  busReset();
+  busBytes(2);  // Skip ROM + Convert T
+  for (size_t i = 0; i < s_deviceCount; ++i) {
+    if (s_devices[i].connected) startConversion(s_devices[i]);
+  }
+  if (waitForConversion_) hostSetNowUs(latestReadyUs());
+}
+
+bool DallasTemperature::requestTemperaturesByAddress(const uint8_t* addr) {
+  busReset();
+  busBytes(10);  // Match ROM + address + Convert T
+  HostDs18b20* d = findDevice(addr, false);
+  if (!d || !d->connected) return false;
+  startConversion(*d);
+  if (waitForConversion_) hostSetNowUs(d->readyUs);
+  return true;
+}
+
+// Read slot: any converting device holds the line low
+bool DallasTemperature::isConversionComplete() {
+  busTime(kSlotUs);
+  return hostNowUs() >= latestReadyUs();
+}
+
+// readScratchPad(): reset, Match ROM + address + Read Scratchpad, 9 bytes
+// back, then a closing reset
+float DallasTemperature::getTempC(const uint8_t* addr) {
+  busReset();
+  busBytes(10 + 9);
+  busReset();
+  const HostDs18b20* d = findDevice(addr, false);
+  if (!d || !d->connected) return DEVICE_DISCONNECTED_C;
+  return d->latchedC;
+}
+
+// ----------------------------------------------------
+// Raw OneWire access (ROM + function command decoder)
+// ----------------------------------------------------
+
+// DS18B20 commands understood by the simulated devices
+static constexpr uint8_t kMatchRom = 0x55;
+static constexpr uint8_t kSkipRom = 0xCC;
+static constexpr uint8_t kConvertT = 0x44;
+static constexpr uint8_t kWriteScratchpad = 0x4E;
+static constexpr uint8_t kReadScratchpad = 0xBE;
+
+enum class WireState : uint8_t { IDLE, ROM_ADDR, FUNCTION, WRITE_SCRATCH, READ_SCRATCH, IGNORE };
+
+static WireState s_wireState = WireState::IDLE;
+static uint8_t s_wireRom[8];
+static uint8_t s_wireIdx = 0;
+static HostDs18b20* s_wireSelected = nullptr;  // nullptr after Skip ROM = all devices
+static uint8_t s_wireScratch[3];
+static uint8_t s_wireReadBuf[9];
+
+// Scratchpad image: temperature, TH, TL, config, reserved, CRC8
+static void fillScratchpad(HostDs18b20& d, uint8_t* sp) {
+  const int16_t raw = (int16_t) lroundf(d.latchedC * 16.0f);
+  sp[0] = (uint8_t) (raw & 0xFF);
+  sp[1] = (uint8_t) ((raw >> 8) & 0xFF);
+  sp[2] = 0x4B;
+  sp[3] = 0x46;
+  sp[4] = (uint8_t) (((d.resolution - 9) << 5) | 0x1F);
+  sp[5] = 0xFF;
+  sp[6] = 0x0C;
+  sp[7] = 0x10;
+  sp[8] = OneWire::crc8(sp, 8);
+  if (d.corruptReads > 0) {
+    d.corruptReads--;
+    sp[0] ^= 0x04;  // one flipped bit in flight
+  }
+}
+
+// Apply a function command to the selected device (or all of them)
+static void wireFunction(uint8_t cmd) {
+  if (cmd == kConvertT) {
+    for (size_t i = 0; i < s_deviceCount; ++i) {
+      HostDs18b20& d = s_devices[i];
+      if (d.connected && (!s_wireSelected || s_wireSelected == &d)) startConversion(d);
+    }
+    s_wireState = WireState::IGNORE;
+  } else if (cmd == kWriteScratchpad) {
+    s_wireIdx = 0;
+    s_wireState = WireState::WRITE_SCRATCH;
+  } else if (cmd == kReadScratchpad && s_wireSelected) {
+    fillScratchpad(*s_wireSelected, s_wireReadBuf);
+    s_wireIdx = 0;
+    s_wireState = WireState::READ_SCRATCH;
+  } else {
+    s_wireState = WireState::IGNORE;
+  }
+}
+
+// TH, TL, config: only the resolution bits matter here
+static void wireScratchWritten() {
+  const uint8_t bits = (uint8_t) (9 + ((s_wireScratch[2] >> 5) & 0x03));
+  for (size_t i = 0; i < s_deviceCount; ++i) {
+    HostDs18b20& d = s_devices[i];
+    if (d.connected && (!s_wireSelected || s_wireSelected == &d)) d.resolution = bits;
+  }
+}
+
+uint8_t OneWire::reset() {
+  busReset();
+  s_wireState = WireState::IDLE;
+  s_wireSelected = nullptr;
+  for (size_t i = 0; i < s_deviceCount; ++i) {
+    if (s_devices[i].connected) return 1;
+  }
+  return 0;
+}
+
+void OneWire::select(const uint8_t rom[8]) {
+  write(kMatchRom);
+  for (int i = 0; i < 8; ++i) write(rom[i]);
+}
+
+void OneWire::skip() { write(kSkipRom); }
+
+void OneWire::write(uint8_t v, uint8_t power) {
+  busBytes(1);
+  switch (s_wireState) {
+    case WireState::IDLE:
+      if (v == kMatchRom) {
+        s_wireIdx = 0;
+        s_wireState = WireState::ROM_ADDR;
+      } else if (v == kSkipRom) {
+        s_wireSelected = nullptr;
+        s_wireState = WireState::FUNCTION;
+      } else {
+        s_wireState = WireState::IGNORE;
+      }
+      break;
+    case WireState::ROM_ADDR:
+      s_wireRom[s_wireIdx++] = v;
+      if (s_wireIdx == 8) {
+        s_wireSelected = findDevice(s_wireRom, false);
+        const bool present = s_wireSelected && s_wireSelected->connected;
+        s_wireState = present ? WireState::FUNCTION : WireState::IGNORE;
+      }
+      break;
+    case WireState::FUNCTION:
+      wireFunction(v);
+      break;
+    case WireState::WRITE_SCRATCH:
+      s_wireScratch[s_wireIdx++] = v;
+      if (s_wireIdx == sizeof(s_wireScratch)) {
+        wireScratchWritten();
+        s_wireState = WireState::IGNORE;
+      }
+      break;
+    case WireState::READ_SCRATCH:
+    case WireState::IGNORE:
+      break;
+  }
+}
+
+// Nothing driving the line reads as ones
+uint8_t OneWire::read() {
+  busBytes(1);
+  if (s_wireState != WireState::READ_SCRATCH || s_wireIdx >= sizeof(s_wireReadBuf)) return 0xFF;
+  return s_wireReadBuf[s_wireIdx++];
+}
+
+void OneWire::read_bytes(uint8_t* buf, uint16_t count) {
+  for (uint16_t i = 0; i < count; ++i) buf[i] = read();
+}
+
+// Dallas/Maxim CRC-8 (x^8 + x^5 + x^4 + 1), bitwise as in the library
+uint8_t OneWire::crc8(const uint8_t* addr, uint8_t len) {
+  uint8_t crc = 0;
+  while (len--) {
+    uint8_t inbyte = *addr++;
+    for (uint8_t i = 8; i; i--) {
+      const uint8_t mix = (crc ^ inbyte) & 0x01;
+      crc >>= 1;
+      if (mix) crc ^= 0x8C;
+      inbyte >>= 1;
+    }
+  }
+  return crc;
+}
+
+// Read slot after Convert T: 0 while any device is still converting
+uint8_t OneWire::read_bit() {
+  busTime(kSlotUs);
+  return hostNowUs() >= latestReadyUs() ? 1 : 0;
+}
+
+// ====================================================
+// ESP-NOW link
+// ====================================================
+
+static EspNowLinkConfig s_linkConfig{};
+static bool s_linkStarted = false;
+static HostEspNowSink s_sink = nullptr;
+static int8_t s_rssiDbm = -60;   // reported for the next delivered frames
+static int8_t s_lastRssi = 0;
+
+EspNowLinkErr espnow_link_begin(const EspNowLinkConfig& config) {
+  if (!config.peerMac || config.channel < 1 || config.channel > 13) return ENL_BAD_ARGS;
+  s_linkConfig = config;
+  s_linkStarted = true;
+  return ENL_OK;
+}
+
+EspNowLinkErr espnow_link_send(const void* data, size_t len) {
+  if (!data || !len) return ENL_BAD_ARGS;
+  if (!s_linkStarted) return ENL_SEND_FAIL;
+  if (s_sink) s_sink((const uint8_t*) data, len);
+  if (s_linkConfig.txHandler) s_linkConfig.txHandler(s_linkConfig.peerMac, true, s_linkConfig.ctx);
+  return ENL_OK;
+}
+
+const uint8_t* espnow_link_peer_mac() { return s_linkConfig.peerMac; }
+uint8_t espnow_link_channel() { return s_linkConfig.channel; }
+int8_t espnow_link_last_rssi() { return s_lastRssi; }
+
+void hostEspNowDeliver(const uint8_t* data, size_t len) {
+  if (!s_linkStarted || !s_linkConfig.rxHandler) return;
+  s_lastRssi = s_rssiDbm;
+  s_linkConfig.rxHandler(s_linkConfig.peerMac, data, len, s_linkConfig.ctx);
+}
+
+void hostEspNowSetSink(HostEspNowSink sink) { s_sink = sink; }
+void hostEspNowSetRssi(int8_t dBm) { s_rssiDbm = dBm; }
@@ -0,0 +1,332 @@
+// Host implementations for the Arduino / esp_timer / FreeRTOS stand-ins in hal/
+
+#include <Arduino.h>
+#include <string.h>
+#include <time.h>
+
+#include <vector>
+
+#include "driver/pulse_cnt.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "host_clock.h"
+#include "host_io.h"
+
+// ====================================================
+// Virtual clock
+// ====================================================
+
+static int64_t s_nowUs = 0;
+static HostDelayHook s_delayHook = nullptr;
+
+int64_t hostNowUs() { return s_nowUs; }
+void hostSetNowUs(int64_t us) { s_nowUs = us; }
+void hostAdvanceUs(int64_t us) { s_nowUs += us; }
+void hostSetDelayHook(HostDelayHook hook) { s_delayHook = hook; }
+
+void delay(uint32_t ms) { delayMicroseconds(ms * 1000UL); }
+
+void delayMicroseconds(uint32_t us) {
+  if (s_delayHook) {
+    s_delayHook(us);
+  } else {
+    s_nowUs += us;
+  }
+}
+
+// ====================================================
+// GPIO
+// ====================================================
+
+static constexpr size_t kPinCount = 40;
+static int s_pinLevel[kPinCount];
+static bool s_pinInit = false;
+
+static void initPins() {
+  if (s_pinInit) return;
+  for (auto& level : s_pinLevel) level = HIGH;  // pull-ups idle high
+  s_pinInit = true;
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  (void) pin;
+  (void) mode;
+  initPins();
+}
+
+int digitalRead(uint8_t pin) {
+  initPins();
+  return pin < kPinCount ? s_pinLevel[pin] : LOW;
+}
+
+void digitalWrite(uint8_t pin, uint8_t level) {
+  initPins();
+  if (pin < kPinCount) s_pinLevel[pin] = level;
+}
+
+static void (*s_pinIsr[kPinCount])() = {};
+
+void attachInterrupt(int irq, void (*isr)(), int mode) {
+  (void) mode;
+  if (irq >= 0 && (size_t) irq < kPinCount) s_pinIsr[irq] = isr;
+}
+
+void detachInterrupt(int irq) {
+  if (irq >= 0 && (size_t) irq < kPinCount) s_pinIsr[irq] = nullptr;
+}
+
+void hostSetPinLevel(uint8_t pin, int level) { digitalWrite(pin, (uint8_t) level); }
+
+static uint32_t s_pinIsrCalls[kPinCount] = {};
+
+static void pcntEdge(uint8_t pin);
+
+void hostFirePinInterrupt(uint8_t pin) {
+  if (pin >= kPinCount) return;
+  pcntEdge(pin);
+  if (s_pinIsr[pin]) {
+    s_pinIsrCalls[pin]++;
+    s_pinIsr[pin]();
+  }
+}
+
+uint32_t hostPinIsrCalls(uint8_t pin) { return pin < kPinCount ? s_pinIsrCalls[pin] : 0; }
+
+// ====================================================
+// Pulse counter (PCNT)
+// ====================================================
+
+struct pcnt_unit_t {
+  int lowLimit;
+  int highLimit;
+  int count;
+  bool enabled;
+  bool running;
+  uint32_t glitchNs;
+};
+
+struct pcnt_chan_t {
+  pcnt_unit_t* unit;
+  int edgeGpio;
+  pcnt_channel_edge_action_t posAction;
+};
+
+static std::vector<pcnt_unit_t*> s_pcntUnits;
+static std::vector<pcnt_chan_t*> s_pcntChannels;
+
+// Rising edge on a GPIO: step every running unit with a channel on it
+static void pcntEdge(uint8_t pin) {
+  for (pcnt_chan_t* ch : s_pcntChannels) {
+    pcnt_unit_t* u = ch->unit;
+    if (ch->edgeGpio != pin || !u->running) continue;
+    if (ch->posAction == PCNT_CHANNEL_EDGE_ACTION_INCREASE) u->count++;
+    if (ch->posAction == PCNT_CHANNEL_EDGE_ACTION_DECREASE) u->count--;
+    if (u->count >= u->highLimit || u->count <= u->lowLimit) u->count = 0;  // hardware clears at a limit
+  }
+}
+
+esp_err_t pcnt_new_unit(const pcnt_unit_config_t* config, pcnt_unit_handle_t* ret_unit) {
+  if (!config || !ret_unit || config->low_limit >= 0 || config->high_limit <= 0 || config->high_limit > 32767 ||
+      config->low_limit < -32768) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  pcnt_unit_t* u = new pcnt_unit_t{config->low_limit, config->high_limit, 0, false, false, 0};
+  s_pcntUnits.push_back(u);
+  *ret_unit = u;
+  return ESP_OK;
+}
+
+esp_err_t pcnt_del_unit(pcnt_unit_handle_t unit) {
+  for (size_t i = 0; i < s_pcntChannels.size();) {
+    if (s_pcntChannels[i]->unit == unit) {
+      delete s_pcntChannels[i];
+      s_pcntChannels.erase(s_pcntChannels.begin() + i);
+    } else {
+      ++i;
+    }
+  }
+  for (size_t i = 0; i < s_pcntUnits.size(); ++i) {
+    if (s_pcntUnits[i] == unit) {
+      s_pcntUnits.erase(s_pcntUnits.begin() + i);
+      delete unit;
+      return ESP_OK;
+    }
+  }
+  return ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t pcnt_unit_set_glitch_filter(pcnt_unit_handle_t unit, const pcnt_glitch_filter_config_t* config) {
+  if (!unit) return ESP_ERR_INVALID_ARG;
+  unit->glitchNs = config ? config->max_glitch_ns : 0;
+  return ESP_OK;
+}
+
+esp_err_t pcnt_new_channel(pcnt_unit_handle_t unit, const pcnt_chan_config_t* config, pcnt_channel_handle_t* ret_chan) {
+  if (!unit || !config || !ret_chan) return ESP_ERR_INVALID_ARG;
+  pcnt_chan_t* ch = new pcnt_chan_t{unit, config->edge_gpio_num, PCNT_CHANNEL_EDGE_ACTION_HOLD};
+  s_pcntChannels.push_back(ch);
+  *ret_chan = ch;
+  return ESP_OK;
+}
+
+esp_err_t pcnt_del_channel(pcnt_channel_handle_t chan) {
+  for (size_t i = 0; i < s_pcntChannels.size(); ++i) {
+    if (s_pcntChannels[i] == chan) {
+      s_pcntChannels.erase(s_pcntChannels.begin() + i);
+      delete chan;
+      return ESP_OK;
+    }
+  }
+  return ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t pcnt_channel_set_edge_action(pcnt_channel_handle_t chan,
+                                       pcnt_channel_edge_action_t pos_act,
+                                       pcnt_channel_edge_action_t neg_act) {
+  (void) neg_act;  // only rising edges are simulated
+  if (!chan) return ESP_ERR_INVALID_ARG;
+  chan->posAction = pos_act;
+  return ESP_OK;
+}
+
+esp_err_t pcnt_unit_enable(pcnt_unit_handle_t unit) {
+  if (!unit || unit->enabled) return ESP_ERR_INVALID_STATE;
+  unit->enabled = true;
+  return ESP_OK;
+}
+
+esp_err_t pcnt_unit_start(pcnt_unit_handle_t unit) {
+  if (!unit || !unit->enabled) return ESP_ERR_INVALID_STATE;
+  unit->running = true;
+  return ESP_OK;
+}
+
+esp_err_t pcnt_unit_clear_count(pcnt_unit_handle_t unit) {
+  if (!unit) return ESP_ERR_INVALID_ARG;
+  unit->count = 0;
+  return ESP_OK;
+}
+
+esp_err_t pcnt_unit_get_count(pcnt_unit_handle_t unit, int* value) {
+  if (!unit || !value) return ESP_ERR_INVALID_ARG;
+  *value = unit->count;
+  return ESP_OK;
+}
+
+HostSerial Serial;
+
+// ====================================================
+// CPU
+// ====================================================
+
+EspClass ESP;
+
+uint32_t EspClass::getCycleCount() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t) ((uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec);
+}
+
+// ====================================================
+// FreeRTOS
+// ====================================================
+
+// Items become visible to receivers at the virtual time they were sent, so a
+// simulation that runs a task body ahead of its accounted CPU time cannot
+// leak results into the past.
+struct HostQueue {
+  size_t itemSize;
+  size_t capacity;
+  size_t head;
+  size_t count;
+  std::vector<uint8_t> storage;
+  std::vector<int64_t> sentUs;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+  HostQueue* q = new HostQueue{itemSize, length, 0, 0, {}, {}};
+  q->storage.resize((size_t) length * itemSize);
+  q->sentUs.resize(length);
+  return q;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void* item, TickType_t wait) {
+  (void) wait;
+  if (!q || q->count >= q->capacity) return pdFALSE;
+  const size_t slot = (q->head + q->count) % q->capacity;
+  memcpy(&q->storage[slot * q->itemSize], item, q->itemSize);
+  q->sentUs[slot] = s_nowUs;
+  q->count++;
+  return pdTRUE;
+}
+
+BaseType_t xQueuePeek(QueueHandle_t q, void* out, TickType_t wait) {
+  (void) wait;
+  if (!q || q->count == 0 || q->sentUs[q->head] > s_nowUs) return pdFALSE;
+  memcpy(out, &q->storage[q->head * q->itemSize], q->itemSize);
+  return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void* out, TickType_t wait) {
+  if (xQueuePeek(q, out, wait) != pdTRUE) return pdFALSE;
+  q->head = (q->head + 1) % q->capacity;
+  q->count--;
+  return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) { return q ? (UBaseType_t) q->count : 0; }
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn,
+                                   const char* name,
+                                   uint32_t stackBytes,
+                                   void* arg,
+                                   UBaseType_t priority,
+                                   TaskHandle_t* outHandle,
+                                   BaseType_t core) {
+  (void) fn;
+  (void) name;
+  (void) stackBytes;
+  (void) arg;
+  (void) priority;
+  (void) core;
+  if (outHandle) *outHandle = nullptr;
+  return pdPASS;
+}
+
+TickType_t xTaskGetTickCount() { return (TickType_t) (s_nowUs / 1000); }
+
+void vTaskDelay(TickType_t ticks) { delay(ticks * portTICK_PERIOD_MS); }
+
+void vTaskDelayUntil(TickType_t* lastWake, TickType_t period) {
+  *lastWake += period;
+  const int64_t wakeUs = (int64_t) *lastWake * portTICK_PERIOD_MS * 1000;
+  if (wakeUs > s_nowUs) delayMicroseconds((uint32_t) (wakeUs - s_nowUs));
+}
+
+static uint32_t s_notifyCount = 0;
+static int s_mainTask = 0;  // address used as the handle of the firmware "task"
+
+TaskHandle_t xTaskGetCurrentTaskHandle() { return &s_mainTask; }
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+  if (task == &s_mainTask) s_notifyCount++;
+  return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higherPriorityTaskWoken) {
+  (void) xTaskNotifyGive(task);
+  if (higherPriorityTaskWoken) *higherPriorityTaskWoken = pdFALSE;
+}
+
+// Sleeps in 1 ms steps so events injected by the delay hook can end the wait
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait) {
+  const int64_t deadlineUs = s_nowUs + (int64_t) ticksToWait * portTICK_PERIOD_MS * 1000;
+  while (s_notifyCount == 0 && s_nowUs < deadlineUs) {
+    const int64_t stepUs = min<int64_t>(1000, deadlineUs - s_nowUs);
+    delayMicroseconds((uint32_t) stepUs);
+  }
+  const uint32_t count = s_notifyCount;
+  if (count > 0) s_notifyCount = clearOnExit ? 0 : count - 1;
+  return count;
+}
@@ -0,0 +1,46 @@
+/*
+ * ================================================================
+ *  Module: host_io
+ *  Purpose: Simulation-side access to the host hardware stand-ins:
+ *           read servo commands, inject DS18B20 temperatures, drive
+ *           GPIO levels / edges (ISRs and PCNT units), and exchange
+ *           ESP-NOW frames with the firmware's EspNowLink callbacks.
+ * ================================================================
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// --- Servos ---
+// Pulse width currently output on a pin, by ESP32Servo or a latched LEDC
+// duty (0 if never written / detached / stopped)
+float hostServoPulseUs(uint8_t pin);
+
+// --- GPIO ---
+void hostSetPinLevel(uint8_t pin, int level);
+// One rising edge on a pin: steps PCNT units counting it and invokes the
+// attached ISR, if any
+void hostFirePinInterrupt(uint8_t pin);
+// Number of times the pin's ISR has run
+uint32_t hostPinIsrCalls(uint8_t pin);
+
+// --- DS18B20 ---
+// Register a sensor on the bus; disconnected sensors fail isConnected()/getTempC()
+void hostDallasSetConnected(const uint8_t addr[8], bool connected);
+// Temperature the sensor would measure if a conversion started now
+void hostDallasSetTempC(const uint8_t addr[8], float tempC);
+// Return the sensor's next `count` scratchpad reads with a flipped bit (CRC error); adds to any pending
+void hostDallasCorruptReads(const uint8_t addr[8], uint8_t count);
+// 1-Wire bus time used so far (reset pulses and bit slots, µs)
+uint64_t hostOneWireBusUs();
+
+// --- ESP-NOW ---
+typedef void (*HostEspNowSink)(const uint8_t* data, size_t len);
+// Deliver a frame from the peer to the firmware's rxHandler
+void hostEspNowDeliver(const uint8_t* data, size_t len);
+// Receive frames the firmware sends with espnow_link_send()
+void hostEspNowSetSink(HostEspNowSink sink);
+// RSSI (dBm) espnow_link_last_rssi() reports for frames delivered from now on
+void hostEspNowSetRssi(int8_t dBm);
@@ -0,0 +1,209 @@
+// ====================================================
+// Host: PID Benchmark
+// Purpose: Compare the float PID (PIDT<float>) with the Q16.16
+//          specialization (PIDT<Q16>) from firmware/control/pid.h:
+//          cost per update() and numeric agreement on the same inputs.
+// Method:  1) open loop: identical error sequence (steps, ramp, sine,
+//             noise) into both controllers; output difference.
+//          2) closed loop: each controller drives its own copy of a
+//             first-order mixing plant with transport delay; IAE and
+//             time until the outlet trajectories separate.
+//          3) timing: batches of update() calls, cycles per call
+//             (ESP.getCycleCount(); on host these are ns).
+//          Run for the config.h gains and for a PID set with Kd != 0.
+// Usage:   build/pid_bench [--updates N]
+// ====================================================
+
+#include <Arduino.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pid.h"
+
+struct Gains {
+  const char* name;
+  float kp;
+  float ki;
+  float kd;
+};
+
+static constexpr float kDt = 0.1f;          // control period (10 Hz DS18B20 cadence)
+static constexpr size_t kOpenLoopSteps = 20000;
+static constexpr size_t kBatch = 1000;
+
+static float s_errors[kOpenLoopSteps];
+static Q16 s_errorsQ[kOpenLoopSteps];
+
+// Deterministic test signal: setpoint steps, a ramp, a slow sine and sensor noise
+static void buildErrorSequence() {
+  uint32_t lcg = 12345;
+  for (size_t i = 0; i < kOpenLoopSteps; ++i) {
+    const float t = i * kDt;
+    float e = 0.0f;
+    if ((i / 1500) % 2 == 0) e += 5.0f * expf(-(float) (i % 1500) * kDt / 8.0f);
+    if ((i / 4000) % 2 == 1) e += 0.02f * (float) (i % 4000) * kDt - 4.0f;
+    e += 1.5f * sinf(t * 0.3f);
+    lcg = lcg * 1664525u + 1013904223u;
+    e += ((float) (lcg >> 8) / 16777216.0f - 0.5f) * 0.25f;  // ±0.125 °F (DS18B20 LSB-ish)
+    s_errors[i] = e;
+    s_errorsQ[i] = Q16::fromFloat(e);
+  }
+}
+
+static void openLoop(const Gains& g) {
+  PID pf(g.kp, g.ki, g.kd, PID_OUT_MIN, PID_OUT_MAX);
+  PIDQ16 pq(g.kp, g.ki, g.kd, PID_OUT_MIN, PID_OUT_MAX);
+  const Q16 dtQ = Q16::fromFloat(kDt);
+
+  double maxDiff = 0.0;
+  double sumSq = 0.0;
+  for (size_t i = 0; i < kOpenLoopSteps; ++i) {
+    const float uf = pf.update(s_errors[i], kDt);
+    const float uq = pq.update(s_errorsQ[i], dtQ).toFloat();
+    const double d = fabs((double) uf - uq);
+    if (d > maxDiff) maxDiff = d;
+    sumSq += d * d;
+  }
+  printf("  open loop   %zu steps: |u_float - u_q16| max %.2e  rms %.2e  (Q16 lsb %.2e)\n",
+         kOpenLoopSteps,
+         maxDiff,
+         sqrt(sumSq / kOpenLoopSteps),
+         1.0 / Q16::ONE);
+}
+
+// First-order mixing plant with a plug-flow delay, in °F
+struct MixPlant {
+  static constexpr float kHotF = 110.0f;
+  static constexpr float kColdF = 70.0f;
+  static constexpr float kTauS = 3.0f;
+  static constexpr size_t kDelaySteps = 5;  // 0.5 s transport
+
+  float outletF = kColdF;
+  float pipe[kDelaySteps] = {};
+  size_t head = 0;
+
+  MixPlant() {
+    for (float& p : pipe) p = kColdF;
+  }
+
+  float step(float ratio) {
+    const float mixed = kColdF + ratio * (kHotF - kColdF);
+    const float delayed = pipe[head];
+    pipe[head] = mixed;
+    head = (head + 1) % kDelaySteps;
+    outletF += (delayed - outletF) * (kDt / kTauS);
+    return outletF;
+  }
+};
+
+static void closedLoop(const Gains& g) {
+  PID pf(g.kp, g.ki, g.kd, PID_OUT_MIN, PID_OUT_MAX);
+  PIDQ16 pq(g.kp, g.ki, g.kd, PID_OUT_MIN, PID_OUT_MAX);
+  const Q16 dtQ = Q16::fromFloat(kDt);
+  MixPlant plantF;
+  MixPlant plantQ;
+
+  // The loop limit-cycles (integrator reset on zero crossing), so once the
+  // two runs drift apart by a fraction of a cycle they no longer line up
+  // sample by sample; compare when that happens and the aggregate error.
+  const size_t steps = (size_t) (300.0f / kDt);
+  float rf = 0.5f;
+  float rq = 0.5f;
+  double iaeF = 0.0;
+  double iaeQ = 0.0;
+  float divergedS = -1.0f;
+  for (size_t i = 0; i < steps; ++i) {
+    const float setF = (i * kDt < 150.0f) ? 100.0f : 105.0f;
+    const float outF = plantF.step(rf);
+    const float outQ = plantQ.step(rq);
+
+    // Deadband as in control.ino; the Q16 path uses the compile-time constant
+    float errF = setF - outF;
+    if (fabsf(errF) < PID_ERROR_DEADBAND_F) errF = 0.0f;
+    Q16 errQ = Q16::fromFloat(setF - outQ);
+    if (errQ < PID_Q16_ERROR_DEADBAND && errQ > -PID_Q16_ERROR_DEADBAND) errQ = Q16::fromRaw(0);
+
+    rf = pf.update(errF, kDt);
+    rq = pq.update(errQ, dtQ).toFloat();
+    iaeF += fabs(setF - outF) * kDt;
+    iaeQ += fabs(setF - outQ) * kDt;
+    if (divergedS < 0.0f && fabsf(outF - outQ) > 0.1f) divergedS = i * kDt;
+  }
+  char diverged[24];
+  if (divergedS < 0.0f) {
+    snprintf(diverged, sizeof(diverged), "never");
+  } else {
+    snprintf(diverged, sizeof(diverged), "%.1f s", divergedS);
+  }
+  printf("  closed loop 300 s, 100->105 F step: IAE float %.1f  q16 %.1f F*s (%.2f%%)  outlets >0.1 F apart after: %s\n",
+         iaeF,
+         iaeQ,
+         100.0 * (iaeQ - iaeF) / iaeF,
+         diverged);
+}
+
+template <typename Pid, typename V>
+static void timeUpdates(const char* label, Pid& pid, const V* errors, V dt, size_t updates) {
+  uint32_t best = UINT32_MAX;
+  uint64_t total = 0;
+  size_t done = 0;
+  size_t idx = 0;
+  while (done < updates) {
+    const uint32_t t0 = ESP.getCycleCount();
+    for (size_t k = 0; k < kBatch; ++k) {
+      pid.update(errors[idx], dt);
+      if (++idx == kOpenLoopSteps) idx = 0;
+    }
+    const uint32_t elapsed = ESP.getCycleCount() - t0;
+    if (elapsed < best) best = elapsed;
+    total += elapsed;
+    done += kBatch;
+  }
+  printf("  %-6s %8.2f cycles/update (mean)  %8.2f (best batch)\n",
+         label,
+         (double) total / done,
+         (double) best / kBatch);
+}
+
+int main(int argc, char** argv) {
+  size_t updates = 2000000;
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "--updates") && i + 1 < argc) {
+      updates = strtoul(argv[++i], nullptr, 10);
+    } else {
+      fprintf(stderr, "usage: %s [--updates N]\n", argv[0]);
+      return 1;
+    }
+  }
+  if (updates < kBatch) updates = kBatch;
+
+  buildErrorSequence();
+
+  const Gains sets[] = {
+      {"config.h PI", PID_KP, PID_KI, PID_KD},
+      {"PID with Kd", PID_KP, PID_KI, 0.01f},
+  };
+
+  printf("PIDT<float> vs PIDT<Q16>, dt %.2f s, limits [%.2f, %.2f]\n", kDt, PID_OUT_MIN, PID_OUT_MAX);
+  printf("Q16 gains (compile time): Kp %ld (%.6f)  Ki %ld (%.6f)  deadband %ld\n",
+         (long) PID_Q16_KP.raw,
+         PID_Q16_KP.toFloat(),
+         (long) PID_Q16_KI.raw,
+         PID_Q16_KI.toFloat(),
+         (long) PID_Q16_ERROR_DEADBAND.raw);
+
+  for (const Gains& g : sets) {
+    printf("\n%s: Kp %.4f Ki %.4f Kd %.4f\n", g.name, g.kp, g.ki, g.kd);
+    openLoop(g);
+    closedLoop(g);
+
+    PID pf(g.kp, g.ki, g.kd, PID_OUT_MIN, PID_OUT_MAX);
+    PIDQ16 pq(g.kp, g.ki, g.kd, PID_OUT_MIN, PID_OUT_MAX);
+    timeUpdates("float", pf, s_errors, kDt, updates);
+    timeUpdates("q16", pq, s_errorsQ, Q16::fromFloat(kDt), updates);
+  }
+  printf("\nHost cycles are wall-clock ns of the native build (x86 FPU): compare on the board for ESP32 numbers.\n");
+  return 0;
+}
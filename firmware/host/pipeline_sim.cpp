@@ -0,0 +1,414 @@
+// ====================================================
+// Host: Pipeline Scheduler Simulation
+// Purpose: Drive firmware/control/pipeline.cpp on a simulated
+//          two-core fixed-priority scheduler and compare control
+//          period jitter and sample-to-actuation latency against
+//          the classic delay(12) superloop.
+// Usage:   build/pipeline_sim [--mode pipeline|superloop|event] [--seconds N]
+//                             [--log ring|sync|off]
+// ====================================================
+//
+// Model notes:
+//   - Stage bodies are synthetic; each one charges the virtual clock
+//     with an execution-time estimate for the work it stands in for.
+//   - Each core is a fixed-priority preemptive scheduler. A stage body
+//     executes at dispatch; its CPU time is then accounted for and may be
+//     preempted by higher-priority releases on the same core. Context
+//     switch cost and tick quantization are ignored.
+//   - Superloop logging (--log): "sync" formats and writes each line
+//     inline (the pre-log_ring behaviour), "ring" only pushes into
+//     log_ring and the drainer runs on the other core, so its time is not
+//     charged to the loop, "off" disables logging.
+//   - "event" is the superloop with CONTROL_EVENT_DRIVEN: instead of
+//     delay(12) it sleeps until the next DS18B20 read is due, the next UI
+//     packet arrives, or CONTROL_IDLE_MAX_MS passes.
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../common/config.h"
+#include "../control/log_ring.h"
+#include "../control/pipeline.h"
+#include "hal/host_clock.h"
+
+// --- Execution-time estimates (µs) ---
+constexpr uint32_t kTempPollUs = 80;            // isConversionComplete(): one read slot + overhead
+constexpr uint32_t kTempReadPerSensorUs = 5400;  // getTempC(): reset + match ROM + 9-byte scratchpad
+constexpr uint32_t kTempSensors = 3;             // hot, cold, outlet converting together
+constexpr uint32_t kTempRequestUs = 1300;        // requestTemperatures(): reset + skip ROM + convert
+constexpr uint32_t kFlowUpdateUs = 10;
+constexpr uint32_t kCommPollUs = 15;
+constexpr uint32_t kControlStepUs = 150;         // fault ladder + PID + two servo writes
+constexpr uint32_t kLogFormatUs = 220;           // printf of ten floats
+constexpr uint32_t kLogLineBytes = 72;
+constexpr uint32_t kLogPushUs = 2;             // copy one LogRecord into the ring
+constexpr uint32_t kStatusDumpBytes = 420;       // occasional multi-line status dump
+constexpr uint32_t kStatusDumpPeriodMs = 2000;
+constexpr uint32_t kUartFifoBytes = 128;
+constexpr float kUartUsPerByte = 1e6f / 11520.0f;  // 115200 baud, 8N1
+
+constexpr uint32_t kConversionMs = TEMP_CONVERSION_TIME_MS;
+constexpr uint32_t kTempPeriodMs = TEMP_LOOP_DT_MS;
+constexpr uint32_t kCommandPeriodMs = 1000;      // UI heartbeat
+constexpr uint32_t kLoopDelayMs = 12;            // control.ino LOOP_DELAY_MS
+constexpr uint32_t kIdleMaxMs = CONTROL_IDLE_MAX_MS;
+constexpr uint32_t kLoggerPeriodMs = 100;        // control.ino LOGGER_PERIOD_MS
+
+enum class Mode { PIPELINE, SUPERLOOP, EVENT };
+enum class LogMode { RING, SYNC, OFF };
+
+// ====================================================
+// Synthetic stage bodies
+// ====================================================
+
+static uint32_t s_rng = 0x12345678u;
+
+// ±20% variation so worst cases differ from averages
+static uint32_t vary(uint32_t us) {
+  s_rng = s_rng * 1664525u + 1013904223u;
+  const float f = 0.8f + 0.4f * ((s_rng >> 8) & 0xffff) / 65535.0f;
+  return (uint32_t) (us * f);
+}
+
+static void busyUs(uint32_t us) { hostAdvanceUs(vary(us)); }
+
+// DS18B20 conversion cycle
+static int64_t s_nextRequestUs = 0;
+static int64_t s_readyUs = 0;
+static bool s_conversionPending = false;
+static uint32_t s_readsPending = 0;  // finished conversions not read yet (outlet first)
+static uint32_t s_sampleSeq = 0;
+static int64_t s_sampleReadyUs[64];
+
+// UART TX backlog (bytes still in the FIFO)
+static float s_uartBacklog = 0.0f;
+static int64_t s_uartLastUs = 0;
+static int64_t s_nextDumpUs = (int64_t) kStatusDumpPeriodMs * 1000;
+
+// Metrics
+struct Metrics {
+  uint32_t steps;
+  int64_t lastStepUs;
+  int64_t intervalMinUs;
+  int64_t intervalMaxUs;
+  double intervalSum;
+  double intervalSqSum;
+  uint32_t samples;
+  int64_t latencyMaxUs;
+  double latencySum;
+  uint32_t lastSeq;
+};
+
+static Metrics s_metrics{0, 0, INT64_MAX, 0, 0.0, 0.0, 0, 0, 0.0, 0};
+static Mode s_mode = Mode::PIPELINE;
+static LogMode s_logMode = LogMode::RING;
+static uint32_t s_offCoreLines = 0;
+static int64_t s_nextLogUs = 0;
+
+static void uartWrite(uint32_t bytes) {
+  const int64_t now = hostNowUs();
+  s_uartBacklog -= (now - s_uartLastUs) / kUartUsPerByte;
+  if (s_uartBacklog < 0.0f) s_uartBacklog = 0.0f;
+  s_uartBacklog += bytes;
+  // Serial.write() blocks until the remainder fits in the hardware FIFO
+  if (s_uartBacklog > kUartFifoBytes) {
+    hostAdvanceUs((int64_t) ((s_uartBacklog - kUartFifoBytes) * kUartUsPerByte));
+    s_uartBacklog = kUartFifoBytes;
+  }
+  s_uartLastUs = hostNowUs();
+}
+
+static bool simSense(SensorFrame& frame) {
+  const int64_t now = hostNowUs();
+  bool fresh = false;
+
+  if (s_conversionPending && now >= s_readyUs) {
+    // Three finished conversions; temperatureService() reads at most
+    // TEMP_MAX_READS_PER_SERVICE of them per call, outlet first
+    if (s_readsPending == 0) s_readsPending = kTempSensors;
+    const uint32_t reads = min(s_readsPending, (uint32_t) TEMP_MAX_READS_PER_SERVICE);
+    busyUs(reads * kTempReadPerSensorUs);
+    if (s_readsPending == kTempSensors) {
+      s_sampleSeq++;
+      s_sampleReadyUs[s_sampleSeq % 64] = s_readyUs;
+      fresh = true;
+    }
+    s_readsPending -= reads;
+    s_conversionPending = (s_readsPending != 0);
+  } else if (s_conversionPending) {
+    busyUs(kTempPollUs);
+  }
+
+  if (!s_conversionPending && hostNowUs() >= s_nextRequestUs) {
+    busyUs(kTempRequestUs);
+    s_readyUs = hostNowUs() + (int64_t) kConversionMs * 1000;
+    s_nextRequestUs += (int64_t) kTempPeriodMs * 1000;
+    if (s_nextRequestUs < hostNowUs()) s_nextRequestUs = hostNowUs();
+    s_conversionPending = true;
+  }
+
+  busyUs(kFlowUpdateUs);
+  frame.outlet.sampleMs = s_sampleSeq;
+  frame.outlet.valid = frame.outlet.present = (s_sampleSeq != 0);
+  return fresh;
+}
+
+// temperatureNextSampleMs(): read due (also a finished one still unread) or next request
+static uint32_t simSenseDueMs() {
+  const int64_t dueUs = s_conversionPending ? s_readyUs : s_nextRequestUs;
+  return (uint32_t) ((dueUs + 999) / 1000);
+}
+
+static int64_t s_nextCmdUs = 0;
+
+static bool simComm(CommCommand& cmd) {
+  busyUs(kCommPollUs);
+  if (hostNowUs() < s_nextCmdUs) return false;
+  s_nextCmdUs += (int64_t) kCommandPeriodMs * 1000;
+  cmd.setpointF = SETPOINT_DEFAULT_F;
+  cmd.runFlag = true;
+  cmd.lastOk = true;
+  return true;
+}
+
+static void simLog(const LogRecord& rec) {
+  (void) rec;
+  busyUs(kLogFormatUs);
+  uartWrite(kLogLineBytes);
+  if (hostNowUs() >= s_nextDumpUs) {
+    uartWrite(kStatusDumpBytes);
+    s_nextDumpUs += (int64_t) kStatusDumpPeriodMs * 1000;
+  }
+}
+
+static void simControl(const SensorFrame& frame, const CommCommand* cmd) {
+  (void) cmd;
+  const int64_t startUs = hostNowUs();
+  if (s_metrics.steps > 0) {
+    const int64_t interval = startUs - s_metrics.lastStepUs;
+    if (interval < s_metrics.intervalMinUs) s_metrics.intervalMinUs = interval;
+    if (interval > s_metrics.intervalMaxUs) s_metrics.intervalMaxUs = interval;
+    s_metrics.intervalSum += (double) interval;
+    s_metrics.intervalSqSum += (double) interval * (double) interval;
+  }
+  s_metrics.lastStepUs = startUs;
+  s_metrics.steps++;
+
+  busyUs(kControlStepUs);
+
+  // Latency: conversion complete on the sensor → valve command issued
+  const uint32_t seq = frame.outlet.sampleMs;
+  if (seq != 0 && seq != s_metrics.lastSeq) {
+    const int64_t latency = hostNowUs() - s_sampleReadyUs[seq % 64];
+    if (latency > s_metrics.latencyMaxUs) s_metrics.latencyMaxUs = latency;
+    s_metrics.latencySum += (double) latency;
+    s_metrics.samples++;
+    s_metrics.lastSeq = seq;
+  }
+
+  if (hostNowUs() >= s_nextLogUs) {
+    s_nextLogUs = hostNowUs() + (int64_t) kLoggerPeriodMs * 1000;
+    LogRecord rec{};
+    rec.ms = (uint32_t) millis();
+    if (s_mode == Mode::PIPELINE) {
+      (void) pipelinePostLog(rec);
+    } else if (s_logMode == LogMode::RING) {
+      busyUs(kLogPushUs);
+      (void) logRingPush(rec);
+    } else if (s_logMode == LogMode::SYNC) {
+      simLog(rec);
+    }
+  }
+}
+
+// ====================================================
+// Schedulers
+// ====================================================
+
+// Drainer on the other core: only counts lines, no time on this core
+static void offCoreLog(const LogRecord& rec) {
+  (void) rec;
+  s_offCoreLines++;
+}
+
+static void runSuperloop(int64_t endUs) {
+  const LogSink drainer{.ready = nullptr, .write = offCoreLog};
+  while (hostNowUs() < endUs) {
+    SensorFrame frame{};
+    (void) simSense(frame);
+    CommCommand cmd{};
+    const bool haveCmd = simComm(cmd);
+    simControl(frame, haveCmd ? &cmd : nullptr);
+    if (s_mode == Mode::EVENT) {
+      // Next wake-up: sample due (temperatureNextSampleMs), UI packet (rx hook) or idle cap
+      const int64_t now = hostNowUs();
+      int64_t wakeUs = now + (int64_t) kIdleMaxMs * 1000;
+      const int64_t sampleDueUs = s_conversionPending ? max(s_readyUs, s_nextRequestUs) : s_nextRequestUs;
+      wakeUs = min(wakeUs, max(sampleDueUs, now));
+      wakeUs = min(wakeUs, max(s_nextCmdUs, now));
+      hostSetNowUs(wakeUs);
+    } else {
+      hostAdvanceUs((int64_t) kLoopDelayMs * 1000);
+    }
+    (void) logRingDrain(drainer, LOG_RING_CAPACITY);
+  }
+}
+
+// A job whose body has already executed but whose CPU time is still being
+// accounted for (it may be preempted by higher-priority releases).
+struct Job {
+  int stage;
+  uint8_t priority;
+  int64_t remainingUs;
+};
+
+static void runPipeline(int64_t endUs) {
+  constexpr int kCores = 2;
+  constexpr int kMaxDepth = PIPELINE_STAGE_COUNT;
+  int64_t coreClock[kCores] = {0, 0};
+  Job stack[kCores][kMaxDepth];
+  int depth[kCores] = {0, 0};
+  int64_t nextRelease[PIPELINE_STAGE_COUNT] = {0};
+
+  for (;;) {
+    const int core = (coreClock[0] <= coreClock[1]) ? 0 : 1;
+    const int64_t now = coreClock[core];
+    if (now >= endUs) break;
+
+    const int runningPrio = depth[core] ? stack[core][depth[core] - 1].priority : -1;
+
+    // Highest-priority released stage that may preempt whatever is running
+    int pick = -1;
+    int64_t nextPreempt = INT64_MAX;
+    for (size_t i = 0; i < PIPELINE_STAGE_COUNT; ++i) {
+      const PipelineStageConfig& cfg = pipelineStageConfig(static_cast<PipelineStage>(i));
+      if (cfg.core != core || (int) cfg.priority <= runningPrio) continue;
+      if (nextRelease[i] <= now) {
+        if (pick < 0 || cfg.priority > pipelineStageConfig(static_cast<PipelineStage>(pick)).priority) {
+          pick = (int) i;
+        }
+      } else if (nextRelease[i] < nextPreempt) {
+        nextPreempt = nextRelease[i];
+      }
+    }
+
+    if (pick >= 0) {
+      // Dispatch: run the body now, then account for its CPU time
+      const PipelineStage stage = static_cast<PipelineStage>(pick);
+      hostSetNowUs(now);
+      pipelineRunStage(stage, nextRelease[pick]);
+      stack[core][depth[core]++] = Job{pick, pipelineStageConfig(stage).priority, hostNowUs() - now};
+      nextRelease[pick] = pipelineNextReleaseUs(stage, nextRelease[pick]);
+      continue;
+    }
+
+    if (depth[core] > 0) {
+      // Run the current job until it finishes or a higher-priority release arrives
+      Job& job = stack[core][depth[core] - 1];
+      const int64_t slice = (nextPreempt == INT64_MAX) ? job.remainingUs
+                                                        : min(job.remainingUs, nextPreempt - now);
+      coreClock[core] += slice;
+      job.remainingUs -= slice;
+      if (job.remainingUs <= 0) depth[core]--;
+      continue;
+    }
+
+    coreClock[core] = (nextPreempt == INT64_MAX) ? endUs : nextPreempt;
+  }
+}
+
+// ====================================================
+// Report
+// ====================================================
+
+static void printReport(Mode mode, double seconds) {
+  static const char* const kLogModeNames[] = {"ring", "sync", "off"};
+  static const char* const kModeNames[] = {"pipeline", "superloop", "event"};
+  printf("mode=%s  log=%s  duration=%.1f s\n",
+         kModeNames[(int) mode],
+         mode == Mode::PIPELINE ? "ring" : kLogModeNames[(int) s_logMode],
+         seconds);
+
+  if (mode == Mode::PIPELINE) {
+    printf("%-8s %5s %7s %10s %10s %10s %10s %9s %6s\n",
+           "stage", "core", "period", "runs", "jit_avg", "jit_max", "exec_max", "overruns", "drops");
+    for (size_t i = 0; i < PIPELINE_STAGE_COUNT; ++i) {
+      const PipelineStage stage = static_cast<PipelineStage>(i);
+      const PipelineStageConfig& cfg = pipelineStageConfig(stage);
+      const PipelineStageStats st = pipelineGetStats(stage);
+      printf("%-8s %5u %5lums %10lu %8.0fus %8luus %8luus %9lu %6lu\n",
+             cfg.name,
+             (unsigned) cfg.core,
+             (unsigned long) cfg.periodMs,
+             (unsigned long) st.runs,
+             st.runs ? (double) st.jitterSumUs / st.runs : 0.0,
+             (unsigned long) st.jitterMaxUs,
+             (unsigned long) st.execMaxUs,
+             (unsigned long) st.overruns,
+             (unsigned long) st.queueDrops);
+    }
+  }
+
+  const uint32_t n = s_metrics.steps > 1 ? s_metrics.steps - 1 : 1;
+  const double mean = s_metrics.intervalSum / n;
+  const double var = s_metrics.intervalSqSum / n - mean * mean;
+  printf("control interval: mean=%.0fus min=%lldus max=%lldus stddev=%.0fus (max-min=%lldus)\n",
+         mean,
+         (long long) s_metrics.intervalMinUs,
+         (long long) s_metrics.intervalMaxUs,
+         var > 0.0 ? sqrt(var) : 0.0,
+         (long long) (s_metrics.intervalMaxUs - s_metrics.intervalMinUs));
+  printf("sample->actuation latency: mean=%.0fus max=%lldus over %lu samples\n",
+         s_metrics.samples ? s_metrics.latencySum / s_metrics.samples : 0.0,
+         (long long) s_metrics.latencyMaxUs,
+         (unsigned long) s_metrics.samples);
+
+  const LogRingStats ring = logRingGetStats();
+  printf("log ring: pushed=%lu dropped=%lu drained=%lu high-water=%lu/%u\n",
+         (unsigned long) ring.pushed,
+         (unsigned long) ring.dropped,
+         (unsigned long) ring.drained,
+         (unsigned long) ring.highWater,
+         LOG_RING_CAPACITY);
+}
+
+int main(int argc, char** argv) {
+  double seconds = 60.0;
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "--mode") && i + 1 < argc) {
+      const char* m = argv[++i];
+      s_mode = !strcmp(m, "superloop") ? Mode::SUPERLOOP : (!strcmp(m, "event") ? Mode::EVENT : Mode::PIPELINE);
+    } else if (!strcmp(argv[i], "--seconds") && i + 1 < argc) {
+      seconds = atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--log") && i + 1 < argc) {
+      const char* m = argv[++i];
+      s_logMode = !strcmp(m, "sync") ? LogMode::SYNC : (!strcmp(m, "off") ? LogMode::OFF : LogMode::RING);
+    } else {
+      fprintf(stderr, "usage: %s [--mode pipeline|superloop|event] [--seconds N] [--log ring|sync|off]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  const int64_t endUs = (int64_t) (seconds * 1e6);
+  hostSetNowUs(0);
+
+  if (s_mode == Mode::PIPELINE) {
+    const PipelineHooks hooks{
+        .sense = simSense,
+        .comm = simComm,
+        .control = simControl,
+        .log = simLog,
+        .logReady = nullptr,
+        .senseDueMs = simSenseDueMs,
+    };
+    pipelineInit(hooks);
+    runPipeline(endUs);
+  } else {
+    runSuperloop(endUs);
+  }
+
+  printReport(s_mode, seconds);
+  return 0;
+}
@@ -0,0 +1,177 @@
+#include "plant.h"
+
+#include <math.h>
+
+#include "../control/config.h"
+
+static PlantParams s_p{};
+static PlantState s_s{};
+
+// Plug-flow history: mixed temperature tagged with cumulative volume
+static constexpr int kHistoryLen = 1024;
+static double s_histVol[kHistoryLen];
+static float s_histTemp[kHistoryLen];
+static int s_histHead = 0;  // index of newest entry
+static int s_histCount = 0;
+static double s_cumVolL = 0.0;
+static double s_pulseAcc = 0.0;
+static float s_hotStemUs = 0.0f;
+static float s_coldStemUs = 0.0f;
+
+PlantParams plantDefaultParams() {
+  PlantParams p{};
+  p.hotSupplyF = 116.0f;
+  p.coldSupplyF = 65.0f;
+  p.branchMaxLpm = 0.9f;
+  p.outletMaxLpm = 0.8f;
+  p.valveDeadFrac = 0.05f;
+  p.valveFullFrac = 0.80f;
+  p.valveExponent = 1.0f;
+  p.servoSlewUsPerSec = 3500.0f;
+  p.backlashUs = 12.0f;
+  p.pipeVolumeL = 0.02;
+  p.pipeLossLpm = 0.01f;  // ≈1 °F drop at 0.25 L/min, 100 °F water
+  p.ambientF = 72.0f;
+  p.sensorTauSec = 2.0;
+  p.lineSensorTauSec = 4.0f;
+  p.pulsesPerLiter = FLOW_K_PULSES_PER_ML * 1000.0f;
+  return p;
+}
+
+static float clamp01(float x) { return x < 0.0f ? 0.0f : (x > 1.0f ? 1.0f : x); }
+
+// Servo horn follows the command at a limited speed
+static float slew(float pos, float cmd, float maxStep) {
+  if (cmd > pos + maxStep) return pos + maxStep;
+  if (cmd < pos - maxStep) return pos - maxStep;
+  return cmd;
+}
+
+// Valve stem only moves once the horn takes up the play on either side
+static float backlash(float stem, float horn, float play) {
+  const float half = 0.5f * play;
+  if (horn > stem + half) return horn - half;
+  if (horn < stem - half) return horn + half;
+  return stem;
+}
+
+// Opening fraction from stem position (minUs = fully open, maxUs = closed)
+static float openFraction(float stemUs, float openUs, float closedUs) {
+  return clamp01((closedUs - stemUs) / (closedUs - openUs));
+}
+
+// Nonlinear port area: nothing until valveDeadFrac, saturated past valveFullFrac
+static float conductance(float open) {
+  const float x = clamp01((open - s_p.valveDeadFrac) / (s_p.valveFullFrac - s_p.valveDeadFrac));
+  return s_p.branchMaxLpm * powf(x, s_p.valveExponent);
+}
+
+static void pushHistory(float mixF) {
+  if (s_histCount > 0 && s_cumVolL - s_histVol[s_histHead] < s_p.pipeVolumeL / (kHistoryLen / 2)) {
+    s_histTemp[s_histHead] = mixF;
+    return;
+  }
+  s_histHead = (s_histHead + 1) % kHistoryLen;
+  s_histVol[s_histHead] = s_cumVolL;
+  s_histTemp[s_histHead] = mixF;
+  if (s_histCount < kHistoryLen) s_histCount++;
+}
+
+// Mixed temperature of the water parcel that is now at the outlet sensor
+static float waterAtSensor() {
+  const double target = s_cumVolL - s_p.pipeVolumeL;
+  const int oldest = (s_histHead - s_histCount + 1 + kHistoryLen) % kHistoryLen;
+  if (s_histCount == 0) return s_s.outletWaterF;
+  if (target <= s_histVol[oldest]) return s_histTemp[oldest];
+
+  // Binary search over the ring (volumes are monotonic)
+  int lo = 0;
+  int hi = s_histCount - 1;
+  while (lo < hi) {
+    const int mid = (lo + hi + 1) / 2;
+    if (s_histVol[(oldest + mid) % kHistoryLen] <= target)
+      lo = mid;
+    else
+      hi = mid - 1;
+  }
+  return s_histTemp[(oldest + lo) % kHistoryLen];
+}
+
+void plantInit(const PlantParams& params) {
+  s_p = params;
+  s_s = PlantState{};
+  s_s.hotSupplyF = params.hotSupplyF;
+  s_s.coldSupplyF = params.coldSupplyF;
+  s_s.hotServoUs = SERVO_HOT_MAX_US;
+  s_s.coldServoUs = SERVO_COLD_MAX_US;
+  s_hotStemUs = s_s.hotServoUs;
+  s_coldStemUs = s_s.coldServoUs;
+  // Standing water in the outlet pipe starts at cold-line temperature
+  s_s.mixF = s_s.outletWaterF = s_s.outletSensorF = params.coldSupplyF;
+  s_s.hotSensorF = params.hotSupplyF;
+  s_s.coldSensorF = params.coldSupplyF;
+  s_histHead = 0;
+  s_histCount = 0;
+  s_cumVolL = 0.0;
+  s_pulseAcc = 0.0;
+}
+
+void plantSetSupply(float hotF, float coldF) {
+  s_s.hotSupplyF = hotF;
+  s_s.coldSupplyF = coldF;
+}
+
+void plantStep(float dtSec, float hotCmdUs, float coldCmdUs) {
+  if (dtSec <= 0.0f) return;
+
+  // Actuators (a pulse width of 0 means the servo is not driven: horn stays put)
+  const float maxStep = s_p.servoSlewUsPerSec * dtSec;
+  if (hotCmdUs > 0.0f) s_s.hotServoUs = slew(s_s.hotServoUs, hotCmdUs, maxStep);
+  if (coldCmdUs > 0.0f) s_s.coldServoUs = slew(s_s.coldServoUs, coldCmdUs, maxStep);
+  s_hotStemUs = backlash(s_hotStemUs, s_s.hotServoUs, s_p.backlashUs);
+  s_coldStemUs = backlash(s_coldStemUs, s_s.coldServoUs, s_p.backlashUs);
+  s_s.hotOpen = openFraction(s_hotStemUs, SERVO_HOT_MIN_US, SERVO_HOT_MAX_US);
+  s_s.coldOpen = openFraction(s_coldStemUs, SERVO_COLD_MIN_US, SERVO_COLD_MAX_US);
+
+  // Hydraulics: parallel valves in series with the outlet restriction
+  const float gHot = conductance(s_s.hotOpen);
+  const float gCold = conductance(s_s.coldOpen);
+  const float gValves = gHot + gCold;
+  float total = 0.0f;
+  if (gValves > 1e-6f) {
+    total = 1.0f / sqrtf(1.0f / (gValves * gValves) + 1.0f / (s_p.outletMaxLpm * s_p.outletMaxLpm));
+    s_s.hotLpm = total * gHot / gValves;
+    s_s.coldLpm = total * gCold / gValves;
+    s_s.mixF = (s_s.hotLpm * s_s.hotSupplyF + s_s.coldLpm * s_s.coldSupplyF) / total;
+  } else {
+    s_s.hotLpm = s_s.coldLpm = 0.0f;
+  }
+  s_s.totalLpm = total;
+
+  // Transport delay (plug flow); water stands still when nothing flows
+  s_cumVolL += total * dtSec / 60.0;
+  pushHistory(s_s.mixF);
+  if (total > 0.0f) {
+    s_s.outletWaterF = s_p.ambientF + (waterAtSensor() - s_p.ambientF) * expf(-s_p.pipeLossLpm / total);
+  }
+
+  // Sensor lag
+  s_s.outletSensorF += (dtSec / s_p.sensorTauSec) * (s_s.outletWaterF - s_s.outletSensorF);
+  s_s.hotSensorF += (dtSec / s_p.lineSensorTauSec) * (s_s.hotSupplyF - s_s.hotSensorF);
+  s_s.coldSensorF += (dtSec / s_p.lineSensorTauSec) * (s_s.coldSupplyF - s_s.coldSensorF);
+
+  // Flow sensor pulses
+  s_pulseAcc += total / 60.0 * s_p.pulsesPerLiter * dtSec;
+}
+
+void plantSetOutletMaxLpm(float lpm) {
+  if (lpm > 0.0f) s_p.outletMaxLpm = lpm;
+}
+
+const PlantState& plantState() { return s_s; }
+
+uint32_t plantTakeFlowPulses() {
+  const uint32_t n = (uint32_t) s_pulseAcc;
+  s_pulseAcc -= n;
+  return n;
+}
@@ -0,0 +1,77 @@
+/*
+ * ================================================================
+ *  Module: plant
+ *  Purpose: Thermal/hydraulic model of the shower test bench used by
+ *           the host simulation. Covers hot/cold supply temperature,
+ *           servo slew + stem backlash, a nonlinear valve curve,
+ *           outlet restriction, pipe heat loss, plug-flow transport delay to the
+ *           outlet sensor, DS18B20 first-order lag and YF-S201 pulses.
+ *
+ *  Interface:
+ *    void plantInit(const PlantParams& params);
+ *    void plantStep(float dtSec, float hotCmdUs, float coldCmdUs);
+ *    void plantSetSupply(float hotF, float coldF);
+ *    void plantSetOutletMaxLpm(float lpm);
+ *    const PlantState& plantState();
+ *    uint32_t plantTakeFlowPulses();
+ * ================================================================
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+struct PlantParams {
+  float hotSupplyF;        // hot line water temperature
+  float coldSupplyF;       // cold line water temperature
+  float branchMaxLpm;      // flow through one fully open valve with no outlet restriction
+  float outletMaxLpm;      // flow limit of the outlet path alone
+  float valveDeadFrac;     // stem travel before the valve port starts to open (0–1)
+  float valveFullFrac;     // stem travel where the port is effectively fully open (0–1)
+  float valveExponent;     // curvature of the opening characteristic
+  float servoSlewUsPerSec; // servo horn speed
+  float backlashUs;        // stem play between servo and valve (µs of servo travel)
+  float pipeVolumeL;       // mixing tee → outlet sensor volume (transport delay = V / q)
+  float pipeLossLpm;       // outlet pipe heat loss: water reaches the sensor at
+                           // ambient + (mix - ambient) * exp(-pipeLossLpm / q)
+  float ambientF;
+  float sensorTauSec;      // DS18B20 + fitting thermal time constant
+  float lineSensorTauSec;  // hot/cold line sensor time constant
+  float pulsesPerLiter;    // YF-S201 K-factor
+};
+
+// Default parameters approximating the bench in tests/data
+PlantParams plantDefaultParams();
+
+struct PlantState {
+  float hotSupplyF;
+  float coldSupplyF;
+  float hotServoUs;     // actual horn position
+  float coldServoUs;
+  float hotOpen;        // valve opening fraction after backlash (0 = closed)
+  float coldOpen;
+  float hotLpm;
+  float coldLpm;
+  float totalLpm;
+  float mixF;           // temperature at the mixing tee
+  float outletWaterF;   // water temperature at the outlet sensor (after transport delay)
+  float outletSensorF;  // what the DS18B20 body sees (after thermal lag)
+  float hotSensorF;
+  float coldSensorF;
+};
+
+void plantInit(const PlantParams& params);
+
+// Advance the model by dtSec with the servo pulse widths currently commanded
+void plantStep(float dtSec, float hotCmdUs, float coldCmdUs);
+
+// Change supply temperatures (disturbances)
+void plantSetSupply(float hotF, float coldF);
+
+// Change the outlet restriction (flow-rate disturbance)
+void plantSetOutletMaxLpm(float lpm);
+
+const PlantState& plantState();
+
+// Whole flow-sensor pulses generated since the last call
+uint32_t plantTakeFlowPulses();
@@ -0,0 +1,243 @@
+// ====================================================
+// Host: RollingStats Check
+// Purpose: Compare the incremental RollingStats<N>
+//          (firmware/control/rolling_stats.h) against a brute-force
+//          recompute of the same window after every add()/expire().
+// Method:  random samples (random walk + jumps) at random intervals,
+//          including equal timestamps, gaps longer than the window
+//          (window empties), occasional reset(), and a clock that
+//          starts just before the uint32_t millis() wrap. Runs long
+//          enough to rebase the time origin (every 4 windows) many
+//          times. The reference keeps the samples in a deque with the
+//          same eviction rule and recomputes everything in double.
+// Usage:   build/rolling_stats_check [--samples N] [--seed S]
+//          Exit status 1 if any error exceeds its tolerance.
+// ====================================================
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <deque>
+
+#include "rolling_stats.h"
+
+// Worst-case error allowed against the double recompute: float rounding on
+// °F-sized values, with about 3x margin over 5M-sample runs
+static constexpr double kTolMean = 1e-3;
+static constexpr double kTolStd = 1e-2;
+static constexpr double kTolSlopeRel = 2e-2;  // relative to slopeScale()
+static constexpr double kTolIntervalMs = 1e-2;
+
+struct Sample {
+  uint32_t ms;
+  float value;
+};
+
+struct Errors {
+  double mean = 0.0;
+  double stddev = 0.0;
+  double slope = 0.0;
+  double interval = 0.0;
+  double intervalStd = 0.0;
+  uint32_t minMaxMismatches = 0;
+  uint32_t countMismatches = 0;
+  uint32_t checks = 0;
+  uint32_t emptied = 0;
+  uint32_t wraps = 0;
+};
+
+static uint32_t s_rng = 1;
+
+static uint32_t nextRand() {
+  s_rng = s_rng * 1664525u + 1013904223u;
+  return s_rng >> 8;
+}
+
+static double uniform() { return nextRand() / 16777216.0; }
+
+// Brute-force window with RollingStats' eviction rule
+template <size_t N>
+class Reference {
+ public:
+  explicit Reference(uint32_t windowMs) : windowMs_(windowMs) {}
+
+  void add(uint32_t ms, float value) {
+    if (q_.size() == N) q_.pop_front();
+    q_.push_back(Sample{ms, value});
+    expire(ms);
+  }
+
+  void expire(uint32_t nowMs) {
+    while (!q_.empty() && (uint32_t) (nowMs - q_.front().ms) > windowMs_) q_.pop_front();
+  }
+
+  void reset() { q_.clear(); }
+
+  const std::deque<Sample>& samples() const { return q_; }
+
+ private:
+  uint32_t windowMs_;
+  std::deque<Sample> q_;
+};
+
+// Slope errors scale with how badly conditioned the fit is: value spread over
+// time spread. Judge them relative to that (plus the slope itself).
+static double slopeScale(double slope, double valueSpread, double m2t) {
+  return fabs(slope) + valueSpread / sqrt(m2t);
+}
+
+template <size_t N>
+static void compare(const RollingStats<N>& rs, const Reference<N>& ref, Errors& err) {
+  const std::deque<Sample>& q = ref.samples();
+  err.checks++;
+  if (rs.count() != q.size()) {
+    err.countMismatches++;
+    return;
+  }
+  if (q.empty()) return;
+
+  const uint32_t t0 = q.front().ms;
+  double meanX = 0.0, meanT = 0.0;
+  float lo = q.front().value, hi = q.front().value;
+  for (const Sample& s : q) {
+    meanX += s.value;
+    meanT += (uint32_t) (s.ms - t0) / 1000.0;
+    lo = fminf(lo, s.value);
+    hi = fmaxf(hi, s.value);
+  }
+  meanX /= q.size();
+  meanT /= q.size();
+  double m2x = 0.0, m2t = 0.0, ctx = 0.0;
+  for (const Sample& s : q) {
+    const double dx = s.value - meanX;
+    const double dt = (uint32_t) (s.ms - t0) / 1000.0 - meanT;
+    m2x += dx * dx;
+    m2t += dt * dt;
+    ctx += dt * dx;
+  }
+  const double sd = q.size() > 1 ? sqrt(m2x / (q.size() - 1)) : 0.0;
+
+  err.mean = fmax(err.mean, fabs(rs.mean() - meanX));
+  err.stddev = fmax(err.stddev, fabs(rs.stddev() - sd));
+  if (rs.min() != lo || rs.max() != hi || rs.range() != hi - lo) err.minMaxMismatches++;
+
+  // RollingStats reports 0 below m2t = 1e-6 s²; skip fits that sit on that edge
+  if (m2t > 2e-6) {
+    const double slope = ctx / m2t;
+    err.slope = fmax(err.slope, fabs(rs.slopePerS() - slope) / slopeScale(slope, sqrt(m2x / q.size()) + 1e-3, m2t));
+  } else if (m2t < 0.5e-6 && rs.slopePerS() != 0.0f) {
+    err.slope = fmax(err.slope, 1.0);
+  }
+
+  // Gaps between consecutive kept samples
+  if (q.size() > 1) {
+    double meanI = 0.0;
+    for (size_t i = 1; i < q.size(); ++i) meanI += (uint32_t) (q[i].ms - q[i - 1].ms);
+    meanI /= (q.size() - 1);
+    double m2i = 0.0;
+    for (size_t i = 1; i < q.size(); ++i) {
+      const double d = (uint32_t) (q[i].ms - q[i - 1].ms) - meanI;
+      m2i += d * d;
+    }
+    const double sdI = q.size() > 2 ? sqrt(m2i / (q.size() - 2)) : 0.0;
+    err.interval = fmax(err.interval, fabs(rs.intervalMeanMs() - meanI));
+    err.intervalStd = fmax(err.intervalStd, fabs(rs.intervalStdMs() - sdI));
+  } else if (!isnan(rs.intervalMeanMs())) {
+    err.interval = fmax(err.interval, INFINITY);
+  }
+}
+
+// One configuration: capacity N, window, typical sample period
+template <size_t N>
+static bool run(const char* name, uint32_t windowMs, uint32_t periodMs, size_t samples) {
+  RollingStats<N> rs(windowMs);
+  Reference<N> ref(windowMs);
+  Errors err;
+
+  uint32_t nowMs = UINT32_MAX - 20 * windowMs;  // wrap early in the run
+  float value = 100.0f;
+  for (size_t i = 0; i < samples; ++i) {
+    // Mostly periodic with jitter; sometimes a repeat timestamp or a long gap
+    const double r = uniform();
+    uint32_t stepMs;
+    if (r < 0.02) {
+      stepMs = 0;
+    } else if (r < 0.025) {
+      stepMs = windowMs + 1 + nextRand() % (2 * windowMs);
+      err.emptied++;
+    } else {
+      stepMs = periodMs / 2 + nextRand() % (periodMs + 1);
+    }
+    const uint32_t prevMs = nowMs;
+    nowMs += stepMs;
+    if (nowMs < prevMs) err.wraps++;
+
+    // Random walk pulled back toward 100 (°F-sized values), with jumps
+    value += (float) ((uniform() - 0.5) * 0.5 - 0.01 * (value - 100.0f));
+    if (uniform() < 0.01) value += (float) ((uniform() - 0.5) * 40.0);
+    const float v = value + (float) ((uniform() - 0.5) * 0.125);  // DS18B20 LSB-sized noise
+
+    if (uniform() < 0.0005) {
+      rs.reset();
+      ref.reset();
+    }
+    rs.add(nowMs, v);
+    ref.add(nowMs, v);
+    compare(rs, ref, err);
+
+    // expire() between samples, as sensor_health does every pass
+    if (uniform() < 0.3) {
+      const uint32_t t = nowMs + nextRand() % (periodMs + 1);
+      rs.expire(t);
+      ref.expire(t);
+      compare(rs, ref, err);
+    }
+  }
+
+  const bool ok = err.countMismatches == 0 && err.minMaxMismatches == 0 && err.mean <= kTolMean &&
+                  err.stddev <= kTolStd && err.slope <= kTolSlopeRel && err.interval <= kTolIntervalMs &&
+                  err.intervalStd <= kTolIntervalMs;
+  printf("%-22s N=%-3u window=%5lums  checks=%lu emptied=%lu wraps=%lu\n",
+         name,
+         (unsigned) N,
+         (unsigned long) windowMs,
+         (unsigned long) err.checks,
+         (unsigned long) err.emptied,
+         (unsigned long) err.wraps);
+  printf("  max error: mean %.2e  sd %.2e  slope %.2e (rel)  interval %.2e ms  interval sd %.2e ms\n",
+         err.mean,
+         err.stddev,
+         err.slope,
+         err.interval,
+         err.intervalStd);
+  printf("  count mismatches %lu, min/max/range mismatches %lu  -> %s\n",
+         (unsigned long) err.countMismatches,
+         (unsigned long) err.minMaxMismatches,
+         ok ? "ok" : "FAIL");
+  return ok;
+}
+
+int main(int argc, char** argv) {
+  size_t samples = 500000;
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "--samples") && i + 1 < argc) {
+      samples = (size_t) atol(argv[++i]);
+    } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+      s_rng = (uint32_t) strtoul(argv[++i], nullptr, 0);
+    } else {
+      fprintf(stderr, "usage: %s [--samples N] [--seed S]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  bool ok = true;
+  // sensor_health: 64-sample ring, 5 s window (outlet fills it by time, flow by count)
+  ok &= run<64>("health, time-limited", 5000, 100, samples);
+  ok &= run<64>("health, ring-limited", 5000, 20, samples);
+  // faults: rapid-change swing window
+  ok &= run<16>("rapid-change window", 1000, 100, samples);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,508 @@
+// ====================================================
+// Host: Closed-Loop Shower Simulation
+// Purpose: Run the unmodified control firmware (control.ino + modules)
+//          against the plant model in plant.cpp, much faster than real
+//          time. The simulation plays the UI unit (ESP-NOW heartbeats
+//          with setpoint + RUN, optionally a flow target) and applies
+//          scheduled disturbances.
+// Output:  Firmware CSV logger on stdout (or --csv FILE), same columns
+//          as tests/data; step-response summary on stderr.
+// Usage:   build/shower_sim [--seconds N] [--setpoint F] [--hot F] [--cold F] [--outlet-lpm F]
+//                           [--setpoint-step T:F]... [--hot-step T:F]...
+//                           [--cold-step T:F]... [--outlet-lpm-step T:F]...
+//                           [--flow-target L] [--flow-target-step T:L]...
+//                           [--estop T:0|1]... [--unplug T:S]...
+//                           [--plug T:S]... [--truth FILE] [--profile 1]
+//          S = sensor index (0 hot, 1 cold, 2 outlet)
+// ====================================================
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../common/config.h"
+#include "../control/config.h"
+#include "backlash_comp.h"
+#include "hal/host_clock.h"
+#include "hal/host_io.h"
+#include "log_ring.h"
+#include "plant.h"
+#include "profiler.h"
+#include "sensor_health.h"
+#include "temperature.h"
+#include "valve_mix.h"
+
+// Firmware entry points (control.ino)
+void setup();
+void loop();
+
+constexpr uint32_t kPlantStepUs = 1000;     // plant integration step
+constexpr uint32_t kUiHeartbeatMs = 1000;   // matches UI_HEARTBEAT_MS
+constexpr uint32_t kRunStartMs = 1000;      // UI presses RUN after boot
+constexpr uint32_t kTruthPeriodMs = 100;
+constexpr float kSettleBandF = 1.0f;
+constexpr float kFlowBandFrac = 0.05f;      // flow settled within ±5 % of the target
+
+enum class EventKind { SETPOINT, FLOW_TARGET, HOT, COLD, OUTLET_LPM, ESTOP, UNPLUG, PLUG, CRC_ERROR };
+
+struct Event {
+  uint32_t ms;
+  EventKind kind;
+  float value;
+};
+
+static constexpr int kMaxEvents = 32;
+static Event s_events[kMaxEvents];
+static int s_eventCount = 0;
+static int s_nextEvent = 0;
+
+// Emulated UI unit
+static float s_uiSetpointF = SETPOINT_DEFAULT_F;
+static float s_uiFlowLpm = 0.0f;  // flow target; 0 = none sent
+static bool s_uiRun = false;
+static uint16_t s_uiSeq = 0;
+static uint32_t s_uiLastTxMs = 0;
+static float s_uiLinkLoss = 0.0f;  // fraction of UI packets dropped on the air
+static uint32_t s_uiLinkRng = 1;   // LCG state, fixed seed: runs repeat exactly
+static uint32_t s_uiDropped = 0;
+static uint32_t s_acks = 0;
+static uint32_t s_telemetryFrames = 0;
+static uint32_t s_uiReadoutMs = 0;     // last ACK / telemetry frame that refreshed the display
+static double s_uiReadoutAgeSum = 0.0;  // ms·s, for the time-weighted mean
+static double s_uiReadoutAgeSec = 0.0;
+static uint32_t s_uiReadoutAgeMaxMs = 0;
+static uint32_t s_flowPulses = 0;
+
+static FILE* s_truth = nullptr;
+static uint32_t s_nextTruthMs = 0;
+
+// Step-response metrics for the segment since the last event
+struct Segment {
+  uint32_t startMs;
+  float setpointF;
+  float startF;
+  float peakExcessF;   // furthest excursion beyond setpoint in the step direction
+  float peakAbsErrF;   // largest |outlet - setpoint| (disturbance rejection)
+  uint32_t lastOutsideMs;
+  double iae;
+  float flowTargetLpm;    // 0 = no flow target
+  bool flowReached;       // flow has been inside the band this segment
+  float flowPeakDevLpm;   // largest |flow - target| once reached (cross-coupling, ripple)
+  uint32_t flowLastOutsideMs;
+};
+
+static Segment s_seg{};
+static bool s_segActive = false;
+
+static float fToC(float f) { return (f - 32.0f) / 1.8f; }
+
+static const uint8_t* sensorAddr(int idx) {
+  switch (idx) {
+    case 0:
+      return TEMP_HOT_ADDR;
+    case 1:
+      return TEMP_COLD_ADDR;
+    default:
+      return TEMP_OUT_ADDR;
+  }
+}
+
+static void uiSend(uint32_t nowMs) {
+  COMM_Payload p{};
+  p.ms = nowMs;
+  p.seq = ++s_uiSeq;
+  p.setpointF = s_uiSetpointF;
+  p.flowLpm = s_uiFlowLpm;
+  p.flags = s_uiRun ? COMM_FLAG_RUN : 0;
+  if (s_uiFlowLpm > 0.0f) p.flags |= COMM_FLAG_FLOW_VALID;
+  s_uiLastTxMs = nowMs;
+  if (s_uiLinkLoss > 0.0f) {
+    s_uiLinkRng = s_uiLinkRng * 1664525u + 1013904223u;
+    if ((s_uiLinkRng >> 8) * (1.0f / 16777216.0f) < s_uiLinkLoss) {
+      s_uiDropped++;
+      return;
+    }
+  }
+  hostEspNowDeliver((const uint8_t*) &p, sizeof(p));
+}
+
+static void onFirmwareTx(const uint8_t* data, size_t len) {
+  if (len == sizeof(COMM_Payload)) {
+    s_acks++;
+    s_uiReadoutMs = millis();
+  } else if (commIsFrame(data, len, COMM_FRAME_TELEMETRY, sizeof(COMM_TelemetryFrame))) {
+    s_telemetryFrames++;
+    s_uiReadoutMs = millis();
+  }
+}
+
+static void printSegment(const Segment& seg, uint32_t endMs) {
+  // Settled = back inside the band and stayed there for the last 5 s of the segment
+  char settle[16] = "n/a";
+  if (endMs - seg.lastOutsideMs > 5000) {
+    snprintf(settle, sizeof(settle), "%.1f", (seg.lastOutsideMs - seg.startMs) / 1000.0f);
+  }
+  char flowSet[16] = "-";
+  char flowSettle[16] = "n/a";
+  char flowDev[16] = "n/a";
+  if (seg.flowTargetLpm > 0.0f) {
+    snprintf(flowSet, sizeof(flowSet), "%.2f", seg.flowTargetLpm);
+    if (endMs - seg.flowLastOutsideMs > 5000) {
+      snprintf(flowSettle, sizeof(flowSettle), "%.1f", (seg.flowLastOutsideMs - seg.startMs) / 1000.0f);
+    }
+    if (seg.flowReached) snprintf(flowDev, sizeof(flowDev), "%.3f", seg.flowPeakDevLpm);
+  }
+  fprintf(stderr,
+          "%8.1f %7.1f %7.1f %9s %11.2f %10.2f %9.1f %6s %9s %7s\n",
+          seg.startMs / 1000.0f,
+          seg.setpointF,
+          seg.startF,
+          settle,
+          seg.peakExcessF,
+          seg.peakAbsErrF,
+          seg.iae,
+          flowSet,
+          flowSettle,
+          flowDev);
+}
+
+static void startSegment(uint32_t nowMs) {
+  if (s_segActive) printSegment(s_seg, nowMs);
+  s_seg = Segment{nowMs, s_uiSetpointF, plantState().outletWaterF, 0.0f, 0.0f, nowMs, 0.0, s_uiFlowLpm, false, 0.0f, nowMs};
+  s_segActive = true;
+}
+
+static void applyEvent(const Event& ev, uint32_t nowMs) {
+  const PlantState& st = plantState();
+  switch (ev.kind) {
+    case EventKind::SETPOINT:
+      s_uiSetpointF = ev.value;
+      uiSend(nowMs);
+      break;
+    case EventKind::FLOW_TARGET:
+      s_uiFlowLpm = ev.value;
+      uiSend(nowMs);
+      break;
+    case EventKind::HOT:
+      plantSetSupply(ev.value, st.coldSupplyF);
+      break;
+    case EventKind::COLD:
+      plantSetSupply(st.hotSupplyF, ev.value);
+      break;
+    case EventKind::OUTLET_LPM:
+      plantSetOutletMaxLpm(ev.value);
+      break;
+    case EventKind::ESTOP:
+      // Switch to ground when pressed (INPUT_PULLUP); the edge raises the interrupt
+      hostSetPinLevel(ESTOP_PIN, ev.value != 0.0f ? LOW : HIGH);
+      hostFirePinInterrupt(ESTOP_PIN);
+      return;
+    case EventKind::UNPLUG:
+    case EventKind::PLUG:
+      hostDallasSetConnected(sensorAddr((int) ev.value), ev.kind == EventKind::PLUG);
+      break;
+    case EventKind::CRC_ERROR:
+      hostDallasCorruptReads(sensorAddr((int) ev.value), 1);
+      return;
+  }
+  startSegment(nowMs);
+}
+
+static void trackSegment(uint32_t nowMs, float dtSec) {
+  if (!s_segActive) return;
+  const float err = plantState().outletWaterF - s_seg.setpointF;
+  const float dir = (s_seg.setpointF >= s_seg.startF) ? 1.0f : -1.0f;
+  if (err * dir > s_seg.peakExcessF) s_seg.peakExcessF = err * dir;
+  if (fabsf(err) > s_seg.peakAbsErrF) s_seg.peakAbsErrF = fabsf(err);
+  if (fabsf(err) > kSettleBandF) s_seg.lastOutsideMs = nowMs;
+  s_seg.iae += fabsf(err) * dtSec;
+
+  if (s_seg.flowTargetLpm > 0.0f) {
+    const float flowErr = fabsf(plantState().totalLpm - s_seg.flowTargetLpm);
+    const bool inBand = flowErr <= kFlowBandFrac * s_seg.flowTargetLpm;
+    if (inBand) s_seg.flowReached = true;
+    if (!inBand) s_seg.flowLastOutsideMs = nowMs;
+    if (s_seg.flowReached && flowErr > s_seg.flowPeakDevLpm) s_seg.flowPeakDevLpm = flowErr;
+  }
+}
+
+// One plant integration step; runs whenever firmware code sleeps
+static void plantTick(uint32_t stepUs) {
+  hostAdvanceUs(stepUs);
+  const uint32_t nowMs = millis();
+
+  while (s_nextEvent < s_eventCount && s_events[s_nextEvent].ms <= nowMs) {
+    applyEvent(s_events[s_nextEvent++], nowMs);
+  }
+
+  if (!s_uiRun && nowMs >= kRunStartMs) {
+    s_uiRun = true;
+    uiSend(nowMs);
+    startSegment(nowMs);
+  } else if (s_uiRun && nowMs - s_uiLastTxMs >= kUiHeartbeatMs) {
+    uiSend(nowMs);
+  }
+  // Play the comm task (woken by the receive callback, on the other core)
+  (void) commService();
+
+  const float dtSec = stepUs / 1e6f;
+  plantStep(dtSec, hostServoPulseUs(SERVO_PIN_HOT), hostServoPulseUs(SERVO_PIN_COLD));
+
+  const PlantState& st = plantState();
+  hostDallasSetTempC(TEMP_OUT_ADDR, fToC(st.outletSensorF));
+  hostDallasSetTempC(TEMP_HOT_ADDR, fToC(st.hotSensorF));
+  hostDallasSetTempC(TEMP_COLD_ADDR, fToC(st.coldSensorF));
+
+  const uint32_t pulses = plantTakeFlowPulses();
+  s_flowPulses += pulses;
+  for (uint32_t n = pulses; n > 0; --n) {
+    hostFirePinInterrupt(FLOW_PIN);
+  }
+
+  trackSegment(nowMs, dtSec);
+
+  // How stale the UI's outlet/flow readout is while running
+  if (s_uiRun && s_uiReadoutMs != 0) {
+    const uint32_t ageMs = nowMs - s_uiReadoutMs;
+    s_uiReadoutAgeSum += ageMs * (double) dtSec;
+    s_uiReadoutAgeSec += dtSec;
+    if (ageMs > s_uiReadoutAgeMaxMs) s_uiReadoutAgeMaxMs = ageMs;
+  }
+
+  // Play the low-priority log drainer task (LOG_DRAIN_PERIOD_MS on the other core)
+  static uint32_t nextDrainMs = 0;
+  if (nowMs >= nextDrainMs) {
+    nextDrainMs = nowMs + LOG_DRAIN_PERIOD_MS;
+    (void) logRingService();
+  }
+
+  if (s_truth && nowMs >= s_nextTruthMs) {
+    s_nextTruthMs = nowMs + kTruthPeriodMs;
+    fprintf(s_truth,
+            "%lu,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.3f,%.3f,%.1f,%.1f\n",
+            (unsigned long) nowMs,
+            st.hotSupplyF,
+            st.coldSupplyF,
+            st.mixF,
+            st.outletWaterF,
+            st.outletSensorF,
+            s_uiSetpointF,
+            st.hotLpm,
+            st.coldLpm,
+            st.hotServoUs,
+            st.coldServoUs);
+  }
+}
+
+static void simDelay(uint32_t us) {
+  while (us > 0) {
+    const uint32_t step = us < kPlantStepUs ? us : kPlantStepUs;
+    plantTick(step);
+    us -= step;
+  }
+}
+
+static bool parseEvent(const char* arg, EventKind kind) {
+  float t = 0.0f;
+  float v = 0.0f;
+  if (sscanf(arg, "%f:%f", &t, &v) != 2 || s_eventCount >= kMaxEvents) return false;
+  s_events[s_eventCount++] = Event{(uint32_t) (t * 1000.0f), kind, v};
+  return true;
+}
+
+static int usage(const char* prog) {
+  fprintf(stderr,
+          "usage: %s [--seconds N] [--setpoint F] [--hot F] [--cold F] [--outlet-lpm F] [--backlash-us U]\n"
+          "          [--link-loss P] [--rssi DBM]\n"
+          "          [--setpoint-step T:F]... [--hot-step T:F]... [--cold-step T:F]...\n"
+          "          [--outlet-lpm-step T:F]... [--flow-target L] [--flow-target-step T:L]...\n"
+          "          [--estop T:0|1]... [--unplug T:S]... [--plug T:S]... [--crc-error T:S]...\n"
+          "          [--csv FILE] [--truth FILE] [--profile 1]\n",
+          prog);
+  return 1;
+}
+
+int main(int argc, char** argv) {
+  if (CONTROL_PIPELINE_ENABLED) {
+    fprintf(stderr, "shower_sim drives the superloop; set CONTROL_PIPELINE_ENABLED = false\n");
+    return 1;
+  }
+
+  PlantParams params = plantDefaultParams();
+  double seconds = 300.0;
+  FILE* csv = stdout;
+  bool profile = false;
+
+  for (int i = 1; i < argc; ++i) {
+    const char* a = argv[i];
+    const char* v = (i + 1 < argc) ? argv[i + 1] : nullptr;
+    if (!v) return usage(argv[0]);
+    ++i;
+    if (!strcmp(a, "--seconds")) {
+      seconds = atof(v);
+    } else if (!strcmp(a, "--setpoint")) {
+      s_uiSetpointF = (float) atof(v);
+    } else if (!strcmp(a, "--flow-target")) {
+      s_uiFlowLpm = (float) atof(v);
+    } else if (!strcmp(a, "--flow-target-step")) {
+      if (!parseEvent(v, EventKind::FLOW_TARGET)) return usage(argv[0]);
+    } else if (!strcmp(a, "--outlet-lpm")) {
+      params.outletMaxLpm = (float) atof(v);
+    } else if (!strcmp(a, "--hot")) {
+      params.hotSupplyF = (float) atof(v);
+    } else if (!strcmp(a, "--cold")) {
+      params.coldSupplyF = (float) atof(v);
+    } else if (!strcmp(a, "--backlash-us")) {
+      params.backlashUs = (float) atof(v);
+    } else if (!strcmp(a, "--link-loss")) {
+      s_uiLinkLoss = (float) atof(v);
+    } else if (!strcmp(a, "--rssi")) {
+      hostEspNowSetRssi((int8_t) atoi(v));
+    } else if (!strcmp(a, "--setpoint-step")) {
+      if (!parseEvent(v, EventKind::SETPOINT)) return usage(argv[0]);
+    } else if (!strcmp(a, "--hot-step")) {
+      if (!parseEvent(v, EventKind::HOT)) return usage(argv[0]);
+    } else if (!strcmp(a, "--cold-step")) {
+      if (!parseEvent(v, EventKind::COLD)) return usage(argv[0]);
+    } else if (!strcmp(a, "--outlet-lpm-step")) {
+      if (!parseEvent(v, EventKind::OUTLET_LPM)) return usage(argv[0]);
+    } else if (!strcmp(a, "--estop")) {
+      if (!parseEvent(v, EventKind::ESTOP)) return usage(argv[0]);
+    } else if (!strcmp(a, "--unplug")) {
+      if (!parseEvent(v, EventKind::UNPLUG)) return usage(argv[0]);
+    } else if (!strcmp(a, "--plug")) {
+      if (!parseEvent(v, EventKind::PLUG)) return usage(argv[0]);
+    } else if (!strcmp(a, "--crc-error")) {
+      if (!parseEvent(v, EventKind::CRC_ERROR)) return usage(argv[0]);
+    } else if (!strcmp(a, "--csv")) {
+      csv = fopen(v, "w");
+      if (!csv) return usage(argv[0]);
+    } else if (!strcmp(a, "--profile")) {
+      profile = atoi(v) != 0;
+    } else if (!strcmp(a, "--truth")) {
+      s_truth = fopen(v, "w");
+      if (!s_truth) return usage(argv[0]);
+      fprintf(s_truth, "ms,hot_supply_F,cold_supply_F,mix_F,outlet_water_F,outlet_sensor_F,setF,hot_lpm,cold_lpm,hot_us,cold_us\n");
+    } else {
+      return usage(argv[0]);
+    }
+  }
+
+  // Events must be applied in time order
+  for (int i = 1; i < s_eventCount; ++i) {
+    for (int j = i; j > 0 && s_events[j].ms < s_events[j - 1].ms; --j) {
+      const Event tmp = s_events[j];
+      s_events[j] = s_events[j - 1];
+      s_events[j - 1] = tmp;
+    }
+  }
+
+  Serial.setOutput(csv);
+  hostSetNowUs(0);
+  plantInit(params);
+  hostDallasSetConnected(TEMP_HOT_ADDR, true);
+  hostDallasSetConnected(TEMP_COLD_ADDR, true);
+  hostDallasSetConnected(TEMP_OUT_ADDR, true);
+  hostEspNowSetSink(onFirmwareTx);
+  hostSetDelayHook(simDelay);
+
+  fprintf(stderr, "%8s %7s %7s %9s %11s %10s %9s %6s %9s %7s\n", "t0_s", "setF", "startF", "settle_s", "overshoot_F",
+          "maxdev_F", "IAE_Fs", "setL", "fsettle_s", "fdev_L");
+
+  setup();
+  const int64_t endUs = (int64_t) (seconds * 1e6);
+  while (hostNowUs() < endUs) {
+    loop();
+  }
+
+  if (s_segActive) printSegment(s_seg, millis());
+  fprintf(stderr,
+          "simulated %.1f s, %lu ACKs + %lu telemetry frames from control, UI readout age mean %.0f ms / max %lu ms\n",
+          seconds,
+          (unsigned long) s_acks,
+          (unsigned long) s_telemetryFrames,
+          s_uiReadoutAgeSec > 0.0 ? s_uiReadoutAgeSum / s_uiReadoutAgeSec : 0.0,
+          (unsigned long) s_uiReadoutAgeMaxMs);
+  const CommRxStats rx = commRxStats();
+  fprintf(stderr,
+          "comm rx %lu frames (%lu dropped), ring high-water %lu/%u, RX -> ACK %lu/%lu us mean/max\n",
+          (unsigned long) rx.frames,
+          (unsigned long) rx.dropped,
+          (unsigned long) rx.highWater,
+          COMM_RX_QUEUE_LEN,
+          (unsigned long) rx.ackLatencyMeanUs,
+          (unsigned long) rx.ackLatencyMaxUs);
+  const LinkQualityStats link = commLinkQuality();
+  fprintf(stderr,
+          "link ui->ctrl %lu delivered, %lu lost (%lu dropped by the sim), %lu duplicates, "
+          "loss %.1f%% of last %u, RSSI mean %.1f dBm\n",
+          (unsigned long) link.delivered,
+          (unsigned long) link.lost,
+          (unsigned long) s_uiDropped,
+          (unsigned long) link.duplicates,
+          link.lossPct,
+          link.windowCount,
+          link.rssiMeanDbm);
+  const TempBusStats& bus = temperatureBusStats();
+  fprintf(stderr,
+          "1-Wire bus busy %.1f ms/s (%.1f%%), %lu scratchpad reads, %lu CRC errors, %lu no response, longest service read %lu us\n",
+          hostOneWireBusUs() / 1000.0 / seconds,
+          hostOneWireBusUs() / 1e4 / seconds,
+          (unsigned long) bus.reads,
+          (unsigned long) bus.crcErrors,
+          (unsigned long) bus.noResponse,
+          (unsigned long) bus.maxServiceReadUs);
+  fprintf(stderr,
+          "flow %lu pulses, %lu flow ISR calls (%s)\n",
+          (unsigned long) s_flowPulses,
+          (unsigned long) hostPinIsrCalls(FLOW_PIN),
+          FLOW_RECIPROCAL ? "reciprocal, GPIO ISR" : FLOW_USE_PCNT ? "PCNT" : "GPIO ISR");
+  const ValveMixStats& valves = valveMixStats();
+  fprintf(stderr,
+          "servo PWM %s, %lu of %lu valve updates written, driven %.1f s / held %.1f s (%lu holds)\n",
+          valves.ledc ? "LEDC" : "ESP32Servo",
+          (unsigned long) valves.writes,
+          (unsigned long) valves.updates,
+          valves.stateMs[static_cast<size_t>(ValveDriveState::DRIVEN)] / 1000.0f,
+          valves.stateMs[static_cast<size_t>(ValveDriveState::HELD)] / 1000.0f,
+          (unsigned long) valves.holds);
+  const BacklashStats& backlash = backlashCompStats();
+  fprintf(stderr,
+          "backlash estimate %.4f of full opening, %lu reversals, %lu rests, %lu up/down pairs\n",
+          backlash.width,
+          (unsigned long) backlash.reversals,
+          (unsigned long) backlash.rests,
+          (unsigned long) backlash.measured);
+
+  // Host-native stage costs (ns), same table the firmware prints on PROFILER_DUMP_KEY
+  if (profile) {
+    Serial.setOutput(stderr);
+    profilerDump();
+
+    // Sensor health table as the firmware holds it at the end of the run
+    const SensorHealthReport& health = sensorHealthGet();
+    fprintf(stderr, "%-7s %4s %8s %7s %9s %8s %13s %4s %4s %4s %4s\n",
+            "sensor", "n", "mean", "sd", "slope/s", "age_ms", "interval_ms", "crc", "nr", "fail", "drop");
+    for (size_t i = 0; i < HEALTH_CHANNEL_COUNT; ++i) {
+      const SensorHealth& h = health.channel[i];
+      fprintf(stderr, "%-7s %4u %8.3f %7.4f %9.4f %8lu %6.1f±%-5.1f %4lu %4lu %4lu %4lu\n",
+              sensorHealthName(static_cast<HealthChannel>(i)),
+              h.windowSamples,
+              h.mean,
+              h.stddev,
+              h.slopePerS,
+              (unsigned long) h.ageMs,
+              h.intervalMs,
+              h.intervalJitterMs,
+              (unsigned long) h.crcErrors,
+              (unsigned long) h.noResponse,
+              (unsigned long) h.failedReads,
+              (unsigned long) h.dropouts);
+    }
+  }
+
+  if (csv != stdout) fclose(csv);
+  if (s_truth) fclose(s_truth);
+  return 0;
+}
@@ -0,0 +1,143 @@
+// ====================================================
+// Host: Telemetry Decoder
+// Purpose: Turn the control unit's binary telemetry stream (telemetry.h)
+//          back into the logger CSV consumed by tests/scripts. Input is a
+//          raw serial capture (file or stdin); any interleaved text lines
+//          are skipped by the COBS delimiters.
+// Output:  CSV on stdout with the legacy columns
+//          ms,setF,T_out_raw,T_out_filt,ratio,u,Kp,Ki,flow_lpm,link_ok
+//          (--extended appends hot_F,cold_F,hot_us,cold_us,fault,run,estop,
+//          rssi_dBm,link_loss_pct,link_dup_pct);
+//          frame/CRC/drop counts on stderr.
+// Usage:   build/telemetry_decode [--extended] [capture.bin] > log.csv
+//          cat /dev/ttyUSB0 | build/telemetry_decode > log.csv
+// ====================================================
+
+#include <stdio.h>
+#include <string.h>
+
+#include "telemetry.h"
+
+struct DecodeCounts {
+  unsigned long ok;
+  unsigned long badCobs;
+  unsigned long badLength;  // usually text lines between frames
+  unsigned long badCrc;
+  unsigned long badVersion;
+  unsigned long seqGaps;    // frames lost on the device or on the wire
+};
+
+static void printRecord(const LogRecord& rec, bool extended) {
+  printf("%lu,%.1f,%.2f,%.2f,%.3f,%.3f,%.3f,%.3f,%.3f,%d",
+         (unsigned long) rec.ms,
+         rec.setpointF,
+         rec.outletRawF,
+         rec.outletFiltF,
+         rec.ratio,
+         rec.u,
+         rec.kp,
+         rec.ki,
+         rec.flowLpm,
+         rec.linkOk ? 1 : 0);
+  if (extended) {
+    printf(",%.2f,%.2f,%u,%u,%u,%d,%d,%d,%.0f,%.0f",
+           rec.hotF,
+           rec.coldF,
+           (unsigned) rec.hotUs,
+           (unsigned) rec.coldUs,
+           (unsigned) rec.fault,
+           rec.runFlag ? 1 : 0,
+           rec.estop ? 1 : 0,
+           (int) rec.linkRssiDbm,
+           rec.linkLossPct,
+           rec.linkDupPct);
+  }
+  printf("\n");
+}
+
+int main(int argc, char** argv) {
+  bool extended = false;
+  const char* path = nullptr;
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "--extended")) {
+      extended = true;
+    } else if (!path && argv[i][0] != '-') {
+      path = argv[i];
+    } else {
+      fprintf(stderr, "usage: %s [--extended] [capture.bin]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  FILE* in = path ? fopen(path, "rb") : stdin;
+  if (!in) {
+    fprintf(stderr, "cannot open %s\n", path);
+    return 1;
+  }
+
+  printf("ms,setF,T_out_raw,T_out_filt,ratio,u,Kp,Ki,flow_lpm,link_ok%s\n",
+         extended ? ",hot_F,cold_F,hot_us,cold_us,fault,run,estop,rssi_dBm,link_loss_pct,link_dup_pct" : "");
+
+  DecodeCounts counts{};
+  uint8_t chunk[256];
+  size_t len = 0;
+  bool overflow = false;
+  bool haveSeq = false;
+  uint16_t lastSeq = 0;
+
+  for (int c = fgetc(in); c != EOF; c = fgetc(in)) {
+    if (c != 0) {
+      if (len < sizeof(chunk)) {
+        chunk[len++] = (uint8_t) c;
+      } else {
+        overflow = true;
+      }
+      continue;
+    }
+
+    // Delimiter: decode what we collected (empty chunks are back-to-back delimiters)
+    if (len > 0) {
+      TelemetryFrame frame;
+      const TelemetryDecodeResult res =
+          overflow ? TelemetryDecodeResult::BAD_LENGTH : telemetryDecode(chunk, len, frame);
+      switch (res) {
+        case TelemetryDecodeResult::OK: {
+          if (haveSeq && frame.seq != (uint16_t) (lastSeq + 1)) {
+            counts.seqGaps += (uint16_t) (frame.seq - lastSeq - 1);
+          }
+          lastSeq = frame.seq;
+          haveSeq = true;
+          counts.ok++;
+          LogRecord rec{};
+          telemetryUnpack(frame, rec);
+          printRecord(rec, extended);
+          break;
+        }
+        case TelemetryDecodeResult::BAD_COBS:
+          counts.badCobs++;
+          break;
+        case TelemetryDecodeResult::BAD_LENGTH:
+          counts.badLength++;
+          break;
+        case TelemetryDecodeResult::BAD_CRC:
+          counts.badCrc++;
+          break;
+        case TelemetryDecodeResult::BAD_VERSION:
+          counts.badVersion++;
+          break;
+      }
+    }
+    len = 0;
+    overflow = false;
+  }
+
+  if (in != stdin) fclose(in);
+  fprintf(stderr,
+          "frames %lu, lost (seq gaps) %lu, crc errors %lu, bad version %lu, non-frame chunks %lu\n",
+          counts.ok,
+          counts.seqGaps,
+          counts.badCrc,
+          counts.badVersion,
+          counts.badCobs + counts.badLength);
+  return 0;
+}
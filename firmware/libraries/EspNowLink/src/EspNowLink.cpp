@@ -7,6 +7,7 @@
 
 static EspNowLinkConfig s_config{};
 static bool s_started = false;
+static volatile int8_t s_lastRssi = 0;  // written in the Wi-Fi task only
 
 // Add or update the single configured peer
 static EspNowLinkErr add_or_update_peer_() {
@@ -36,6 +37,7 @@ static void onRecv_cb(const esp_now_recv_info_t* info, const uint8_t* data, int
   if (!s_config.rxHandler || !info || !data || len <= 0) return;
   uint8_t mac[6];
   memcpy(mac, info->src_addr, 6);
+  if (info->rx_ctrl) s_lastRssi = (int8_t) info->rx_ctrl->rssi;
   s_config.rxHandler(mac, data, (size_t) len, s_config.ctx);
 }
 
@@ -114,3 +116,4 @@ EspNowLinkErr espnow_link_send(const void* data, size_t len) {
 
 const uint8_t* espnow_link_peer_mac() { return s_config.peerMac; }
 uint8_t espnow_link_channel() { return s_config.channel; }
+int8_t espnow_link_last_rssi() { return s_lastRssi; }
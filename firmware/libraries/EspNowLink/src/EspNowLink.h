@@ -3,7 +3,8 @@
  *  Module: EspNowLink
  *  Purpose: Thin wrapper around ESP-NOW for point-to-point link.
  *           Handles WiFi STA setup, channel locking, peer config,
- *           optional encryption, and user callbacks.
+ *           optional encryption, and user callbacks. Records the
+ *           RSSI of each received frame before its rxHandler runs.
  *
  *  Dependencies:
  *    - esp_err.h   (ESP-IDF error codes)
@@ -18,6 +19,7 @@
  *    EspNowLinkErr espnow_link_send(const void* data, size_t len);
  *    const uint8_t* espnow_link_peer_mac();
  *    uint8_t        espnow_link_channel();
+ *    int8_t         espnow_link_last_rssi();
  * ================================================================
  */
 
@@ -68,3 +70,7 @@ const uint8_t* espnow_link_peer_mac();
 
 // Return configured WiFi channel
 uint8_t espnow_link_channel();
+
+// RSSI (dBm) of the last received frame; inside rxHandler, of the frame being
+// delivered. 0 before the first frame.
+int8_t espnow_link_last_rssi();
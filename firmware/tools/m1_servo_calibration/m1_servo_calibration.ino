@@ -1,8 +1,9 @@
 // ====================================================
 // M1: Servo Calibration Tool (Cold / Hot Valves)
-// Purpose: Find fully closed and open µs limits for both servos.
+// Purpose: Find fully closed and open µs limits for both servos, then
+//          measure each valve's flow curve for the valve_mix lookup table.
 // Board: ESP32 (Control Unit)
-// Pins: GPIO 18 = Cold valve, GPIO 19 = Hot valve
+// Pins: GPIO 18 = Cold valve, GPIO 19 = Hot valve, FLOW_PIN = YF-S201
 // Power: 6 V DC supply (≥3 A) with common ground to ESP32
 // ====================================================
 //
@@ -15,6 +16,14 @@
 //   [G] Select Cold  [H] Select Hot
 //   [P] Print saved limits (#define)
 //   [R] Toggle auto sweep
+//   [K] Capture flow curve of the selected valve (other valve closed)
+//
+// Curve capture: needs both limits and water pressure on the selected line.
+// The selected valve is stepped from closed to open; at each step the flow
+// sensor pulses are counted after the valve settles. The curve is made
+// monotonic (running max), normalized to full flow and inverted onto
+// VALVE_LUT_POINTS evenly spaced flow fractions. Paste the printed
+// VALVE_*_LUT_US line into firmware/control/config.h.
 
 #include <ESP32Servo.h>
 
@@ -59,6 +68,14 @@ int usHot = 1500;
 bool autoSweep = false;
 int dirCold = +1, dirHot = -1;
 
+// Flow curve capture
+constexpr int CURVE_STEPS = 40;               // Steps closed → open (CURVE_STEPS + 1 points)
+constexpr uint32_t CURVE_SETTLE_MS = 1500;    // Servo travel + flow settling per step
+constexpr uint32_t CURVE_MEASURE_MS = 2000;   // Pulse counting window per step
+volatile uint32_t flowPulses = 0;
+
+void IRAM_ATTR onFlowPulse() { flowPulses++; }
+
 // Helpers / State
 bool hasColdCal() { return SERVO_COLD_MIN_US_VAL > 0 && SERVO_COLD_MAX_US_VAL > 0; }
 bool hasHotCal() { return SERVO_HOT_MIN_US_VAL > 0 && SERVO_HOT_MAX_US_VAL > 0; }
@@ -126,6 +143,9 @@ void setup() {
   sCold.writeMicroseconds(usCold);
   sHot.writeMicroseconds(usHot);
 
+  pinMode(FLOW_PIN, INPUT_PULLUP);
+  attachInterrupt(digitalPinToInterrupt(FLOW_PIN), onFlowPulse, RISING);
+
   banner();
 }
 
@@ -135,6 +155,7 @@ void banner() {
   Serial.println(F("      [Z/X]=Cold MIN/MAX  [C/V]=Hot MIN/MAX"));
   Serial.println(F("      [A]=MIN  [S]=MID  [D]=MAX  (uses config.h if present)"));
   Serial.println(F("      [Q/W/E] -5/-10/-25   [1/2/3] +5/+10/+25"));
+  Serial.println(F("      [K]=Capture flow curve of selected valve (LUT for config.h)"));
 
   Serial.printf("Pins: COLD=%d, HOT=%d  |  GUARD=%d us\n",
                 SERVO_PIN_COLD, SERVO_PIN_HOT, SERVO_GUARD_US);
@@ -288,6 +309,18 @@ void handleKey(int k) {
     case 'P':
       printDefines();
       break;
+
+    // Flow curve → lookup table
+    case 'k':
+    case 'K':
+      if (autoSweep) {
+        Serial.println("Curve capture blocked: stop auto-sweep first.");
+      } else if (!fullyCalibrated()) {
+        Serial.println("Curve capture blocked: define limits first (config.h or mark Z/X and C/V).");
+      } else {
+        captureCurve();
+      }
+      break;
   }
 
   if (!autoSweep) printState();
@@ -325,3 +358,86 @@ void printDefines() {
   maybePrintDef("SERVO_HOT_MAX_US", SERVO_HOT_MAX_US_VAL);
   Serial.println();
 }
+
+// Pulses counted over CURVE_MEASURE_MS at the current valve position
+static uint32_t measureFlow() {
+  delay(CURVE_SETTLE_MS);
+  noInterrupts();
+  flowPulses = 0;
+  interrupts();
+  delay(CURVE_MEASURE_MS);
+  noInterrupts();
+  const uint32_t n = flowPulses;
+  interrupts();
+  return n;
+}
+
+// Step the selected valve closed → open, then invert the measured curve
+void captureCurve() {
+  const bool hot = (ch == 1);
+  const int closedUs = hot ? SERVO_HOT_MAX_US_VAL : SERVO_COLD_MAX_US_VAL;
+  const int openUs = hot ? SERVO_HOT_MIN_US_VAL : SERVO_COLD_MIN_US_VAL;
+  const int dir = (openUs > closedUs) ? +1 : -1;
+  const int lo = closedUs + dir * SERVO_GUARD_US;  // guard band, as in valve_mix
+  const int hi = openUs - dir * SERVO_GUARD_US;
+
+  // Other valve closed so the sensor sees only the selected line
+  if (hot) {
+    usCold = clamp(SERVO_COLD_MAX_US_VAL);
+    sCold.writeMicroseconds(usCold);
+  } else {
+    usHot = clamp(SERVO_HOT_MAX_US_VAL);
+    sHot.writeMicroseconds(usHot);
+  }
+
+  int us[CURVE_STEPS + 1];
+  float flow[CURVE_STEPS + 1];
+  Serial.printf("\nCapturing %s curve: %d..%d us, %d steps\n", hot ? "Hot" : "Cold", lo, hi, CURVE_STEPS);
+  Serial.println("us,pulses");
+  for (int i = 0; i <= CURVE_STEPS; ++i) {
+    us[i] = lo + (int) lroundf((float) (hi - lo) * i / CURVE_STEPS);
+    setSel(us[i]);
+    flow[i] = (float) measureFlow();
+    Serial.printf("%d,%.0f\n", us[i], flow[i]);
+    if (Serial.available()) {  // any key aborts
+      Serial.read();
+      Serial.println("Curve capture aborted.");
+      setSel(closedUs);
+      return;
+    }
+  }
+  setSel(closedUs);
+
+  // Monotonic (running max), then normalized to full flow
+  for (int i = 1; i <= CURVE_STEPS; ++i) flow[i] = max(flow[i], flow[i - 1]);
+  const float full = flow[CURVE_STEPS] - flow[0];
+  if (full <= 0.0f) {
+    Serial.println("Curve capture failed: no flow measured (water on? FLOW_PIN wired?)");
+    return;
+  }
+  for (int i = 0; i <= CURVE_STEPS; ++i) flow[i] = (flow[i] - flow[0]) / full;
+
+  // Invert: pulse width where the normalized flow first reaches each fraction
+  uint16_t lut[VALVE_LUT_POINTS];
+  for (size_t j = 0; j < VALVE_LUT_POINTS; ++j) {
+    const float f = (float) j / (float) (VALVE_LUT_POINTS - 1);
+    int i = 1;
+    if (j == 0) {
+      while (i < CURVE_STEPS && flow[i] <= 0.0f) i++;  // last closed point
+      lut[j] = (uint16_t) us[i - 1];
+      continue;
+    }
+    while (i < CURVE_STEPS && flow[i] < f) i++;
+    const float span = flow[i] - flow[i - 1];
+    const float t = (span > 0.0f) ? (f - flow[i - 1]) / span : 1.0f;
+    int u = (int) lroundf(us[i - 1] + (us[i] - us[i - 1]) * t);
+    // Keep the table strictly monotonic for valve_mix's static_assert
+    if ((u - (int) lut[j - 1]) * dir <= 0) u = lut[j - 1] + dir;
+    lut[j] = (uint16_t) u;
+  }
+
+  Serial.println("\n// Paste into firmware/control/config.h");
+  Serial.printf("constexpr uint16_t VALVE_%s_LUT_US[VALVE_LUT_POINTS] = {", hot ? "HOT" : "COLD");
+  for (size_t j = 0; j < VALVE_LUT_POINTS; ++j) Serial.printf(j ? ", %u" : "%u", (unsigned) lut[j]);
+  Serial.println("};\n");
+}
@@ -4,17 +4,47 @@
 #include <EspNowLink.h>
 
 #include "../common/config.h"
+#include "../common/link_quality.h"
 #include "config.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/portmacro.h"
 
+// One message awaiting its ACK. User commands are retransmitted under the
+// same seq until ACKed, superseded or out of retries; heartbeats are sent once.
+struct TxSlot {
+  bool used;
+  bool user;
+  uint8_t retries;
+  uint32_t firstSentUs;   // delivery latency is measured from the first send
+  unsigned long lastSentMs;
+  COMM_Payload payload;   // ms restamped per send, so an echoed ms times that send
+};
+
 // TX sequence tracking
-static uint16_t s_seq = 0;          // next sequence to send
-static uint16_t s_inFlightSeq = 0;  // 0 = none in flight
-static bool s_inFlightUserTx = false;
-static unsigned long s_lastHeartbeatMs = 0;
+static uint16_t s_seq = 0;  // last sequence used (0 is never sent)
+static TxSlot s_window[UI_TX_WINDOW];
+static unsigned long s_lastTxMs = 0;  // any send (user or heartbeat)
 static float s_lastSetpointF = SETPOINT_DEFAULT_F;
 static bool s_lastRunFlag = false;
+static float s_lastFlowTargetLpm = FLOW_TARGET_DEFAULT_LPM;
+static CommTxStats s_txStats{};
+static uint64_t s_latencySumUs = 0;
+
+// Round trips: every send is delivered (ACKed while outstanding) or lost (no
+// ACK within UI_RETX_TIMEOUT_MS); an ACK for a seq no longer outstanding is a
+// duplicate. RTT and RSSI come from every ACK / every received frame.
+static LinkQuality s_link;
+
+// Seqs taken out of the window before their last send had an outcome
+// (superseded user commands, evicted heartbeats). A late ACK for one is a
+// delivery, not a duplicate; no ACK UI_RETX_TIMEOUT_MS after that send, or
+// being pushed out of the ring, is a loss.
+struct RetiredSeq {
+  uint16_t seq;  // 0 = empty
+  unsigned long lastSentMs;
+};
+static RetiredSeq s_retired[UI_RETIRED_SEQS];
+static size_t s_retiredHead = 0;
 
 // Current UI→CTRL communication status
 static CommStatus s_status{/*lastSeq=*/0,
@@ -24,46 +54,144 @@ static CommStatus s_status{/*lastSeq=*/0,
                            /*outletTempF=*/0.0f,
                            /*outletValid=*/false,
                            /*flowLpm=*/0.0f,
-                           /*flowValid=*/false};
+                           /*flowValid=*/false,
+                           /*hotTempF=*/0.0f,
+                           /*hotValid=*/false,
+                           /*coldTempF=*/0.0f,
+                           /*coldValid=*/false,
+                           /*ratio=*/0.0f,
+                           /*faultMask=*/0,
+                           /*ctrlRunning=*/false,
+                           /*telemetryCount=*/0,
+                           /*lastLatencyUs=*/0,
+                           /*ctrlRssiDbm=*/0,
+                           /*ctrlLossPct=*/0,
+                           /*ctrlDupPct=*/0};
 
 static volatile bool s_statusDirty = false;  // status changed since last poll
 
-// Protects s_status, s_statusDirty, s_inFlightSeq, s_inFlightUserTx
+// Protects s_status, s_statusDirty, s_window, s_retired, s_txStats and s_link
 static portMUX_TYPE s_statusMux = portMUX_INITIALIZER_UNLOCKED;
 
+// v2 status push from Control: refresh the readout without waiting for an ACK.
+// Link fields are read only if the sender appended them.
+static void onTelemetry(const uint8_t* data) {
+  const size_t len = ((const COMM_FrameHeader*) data)->len;  // checked against the frame by commIsFrame()
+  COMM_TelemetryFrame f{};
+  memcpy(&f, data, len < sizeof(f) ? len : sizeof(f));
+  const bool hasLink = len >= sizeof(f);
+
+  portENTER_CRITICAL(&s_statusMux);
+  s_status.outletTempF = f.outletF;
+  s_status.outletValid = (f.flags & COMM_TEL_OUTLET_VALID);
+  s_status.flowLpm = f.flowLpm;
+  s_status.flowValid = (f.flags & COMM_TEL_FLOW_VALID);
+  s_status.hotTempF = f.hotF;
+  s_status.hotValid = (f.flags & COMM_TEL_HOT_VALID);
+  s_status.coldTempF = f.coldF;
+  s_status.coldValid = (f.flags & COMM_TEL_COLD_VALID);
+  s_status.ratio = f.ratio;
+  s_status.faultMask = f.faultMask;
+  s_status.ctrlRunning = (f.flags & COMM_TEL_RUN);
+  if (hasLink) {
+    s_status.ctrlRssiDbm = f.rssiDbm;
+    s_status.ctrlLossPct = f.lossPct;
+    s_status.ctrlDupPct = f.dupPct;
+  }
+  s_status.telemetryCount++;
+  s_statusDirty = true;
+  portEXIT_CRITICAL(&s_statusMux);
+}
+
+// True while any user command is awaiting its ACK (call with s_statusMux held)
+static bool userInFlightLocked() {
+  for (const TxSlot& s : s_window) {
+    if (s.used && s.user) return true;
+  }
+  return false;
+}
+
+// Remember a slot leaving the window unanswered (call with s_statusMux held)
+static void retireLocked(const TxSlot& s) {
+  RetiredSeq& r = s_retired[s_retiredHead];
+  if (r.seq != 0) s_link.lost();
+  r = RetiredSeq{s.payload.seq, s.lastSentMs};
+  s_retiredHead = (s_retiredHead + 1) % UI_RETIRED_SEQS;
+}
+
+// True (and forgotten) if seq was retired unanswered (call with s_statusMux held)
+static bool takeRetiredLocked(uint16_t seq) {
+  for (RetiredSeq& r : s_retired) {
+    if (r.seq != seq) continue;
+    r.seq = 0;
+    return true;
+  }
+  return false;
+}
+
 static void on_rx(const uint8_t src_mac[6], const uint8_t* data, size_t len, void* ctx) {
+  const int8_t rssiDbm = espnow_link_last_rssi();  // of this frame while in the callback
+  portENTER_CRITICAL(&s_statusMux);
+  s_link.rssi(rssiDbm);
+  portEXIT_CRITICAL(&s_statusMux);
+
+  if (commIsFrame(data, len, COMM_FRAME_TELEMETRY, COMM_TELEMETRY_BASE_BYTES)) {
+    onTelemetry(data);
+    return;
+  }
   if (len != sizeof(COMM_Payload)) return;  // ignore malformed packets
 
   COMM_Payload p;
   memcpy(&p, data, sizeof(p));
+  if (!(p.flags & COMM_FLAG_ACK) || p.seq == 0) return;
 
-  if ((p.flags & COMM_FLAG_ACK) && p.seq == s_inFlightSeq) {
-    portENTER_CRITICAL(&s_statusMux);
+  const uint32_t nowUs = micros();
+  const uint32_t rttMs = millis() - p.ms;  // the ACK echoes the ms of the send it answers
+  bool matched = false;
+  portENTER_CRITICAL(&s_statusMux);
+  s_link.rtt(rttMs);
+  for (TxSlot& s : s_window) {
+    if (!s.used || s.payload.seq != p.seq) continue;
+    matched = true;
+    if (s.user) {
+      const uint32_t latencyUs = nowUs - s.firstSentUs;
+      s_status.lastLatencyUs = latencyUs;
+      s_txStats.userDelivered++;
+      s_txStats.latencyLastUs = latencyUs;
+      if (latencyUs > s_txStats.latencyMaxUs) s_txStats.latencyMaxUs = latencyUs;
+      s_latencySumUs += latencyUs;
+      s_txStats.latencyMeanUs = (uint32_t) (s_latencySumUs / s_txStats.userDelivered);
+    } else {
+      s_txStats.heartbeatsAcked++;
+    }
+    s.used = false;
     s_status.lastSeq = p.seq;
     s_status.lastOk = true;
-    if (s_inFlightUserTx) s_status.pending = false;
+    s_status.pending = userInFlightLocked();
     s_status.txCount++;
     s_status.outletTempF = p.setpointF;
     s_status.outletValid = (p.flags & COMM_FLAG_TEMP_VALID);
     s_status.flowLpm = p.flowLpm;
     s_status.flowValid = (p.flags & COMM_FLAG_FLOW_VALID);
-    s_inFlightSeq = 0;
-    s_inFlightUserTx = false;
     s_statusDirty = true;
-    portEXIT_CRITICAL(&s_statusMux);
+    break;
+  }
+  // A superseded or evicted send that gets its ACK was delivered; ACKs for
+  // timed-out or already ACKed seqs only count as duplicates
+  if (!matched) matched = takeRetiredLocked(p.seq);
+  if (matched) {
+    s_link.delivered();
+  } else {
+    s_link.duplicate();
   }
+  portEXIT_CRITICAL(&s_statusMux);
 }
 
 static void on_tx(const uint8_t dst_mac[6], bool ok, void* ctx) {
-  if (!ok && s_inFlightSeq != 0) {
+  // MAC-level failures are only counted; the retransmit timers recover
+  if (!ok) {
     portENTER_CRITICAL(&s_statusMux);
-    s_status.lastSeq = s_inFlightSeq;
-    s_status.lastOk = false;
-    if (s_inFlightUserTx) s_status.pending = false;
-    s_status.txCount++;
-    s_inFlightSeq = 0;
-    s_inFlightUserTx = false;
-    s_statusDirty = true;
+    s_txStats.macFails++;
     portEXIT_CRITICAL(&s_statusMux);
   }
 }
@@ -83,66 +211,122 @@ bool commInit() {
   return espnow_link_begin(config) == ENL_OK;
 }
 
-static bool sendCurrent(unsigned long nowMs, bool userTx) {
-  // Avoid stomping an in-flight packet (including heartbeats)
-  portENTER_CRITICAL(&s_statusMux);
-  if (s_inFlightSeq != 0) {
-    portEXIT_CRITICAL(&s_statusMux);
-    return false;
+// Fill a free window slot with the current state under a new seq. A user
+// command first retires every older user command (they carry stale state) and,
+// if the window is still full, the oldest heartbeat. Returns the slot or
+// nullptr (heartbeat with no free slot).
+static TxSlot* claimSlotLocked(unsigned long nowMs, bool user) {
+  TxSlot* free = nullptr;
+  TxSlot* oldestBeat = nullptr;
+  for (TxSlot& s : s_window) {
+    if (s.used && s.user && user) {
+      s.used = false;
+      s_txStats.superseded++;
+      retireLocked(s);
+    }
+    if (s.used && !s.user && (!oldestBeat || (int16_t) (s.payload.seq - oldestBeat->payload.seq) < 0)) {
+      oldestBeat = &s;
+    }
+    if (!s.used && !free) free = &s;
   }
-  portEXIT_CRITICAL(&s_statusMux);
-
-  COMM_Payload p{};
-  p.ms = nowMs;
-  p.seq = ++s_seq;
-  p.setpointF = s_lastSetpointF;
-  p.flowLpm = 0.0f;
-  p.flags = s_lastRunFlag ? COMM_FLAG_RUN : 0;
-
-  // Mark TX as in-flight
-  portENTER_CRITICAL(&s_statusMux);
-  s_inFlightSeq = p.seq;
-  s_inFlightUserTx = userTx;
-  if (userTx) {
-    s_status.pending = true;
-    s_statusDirty = true;
+  if (!free && user && oldestBeat) {
+    oldestBeat->used = false;  // never make a user command wait behind a heartbeat
+    s_txStats.heartbeatsLost++;
+    retireLocked(*oldestBeat);
+    free = oldestBeat;
   }
-  portEXIT_CRITICAL(&s_statusMux);
+  if (!free) return nullptr;
 
-  bool ok = espnow_link_send(&p, sizeof(p)) == ENL_OK;
-  s_lastHeartbeatMs = nowMs;
-
-  if (!ok) {
-    // Immediate send failure (no ACK expected)
-    portENTER_CRITICAL(&s_statusMux);
-    s_status.lastSeq = p.seq;
-    s_status.lastOk = false;
-    if (userTx) s_status.pending = false;
-    s_status.txCount++;
-    s_inFlightSeq = 0;
-    s_inFlightUserTx = false;
+  if (++s_seq == 0) s_seq = 1;
+  free->used = true;
+  free->user = user;
+  free->retries = 0;
+  free->firstSentUs = micros();
+  free->lastSentMs = nowMs;
+  free->payload = COMM_Payload{};
+  free->payload.ms = nowMs;
+  free->payload.seq = s_seq;
+  free->payload.setpointF = s_lastSetpointF;
+  free->payload.flowLpm = s_lastFlowTargetLpm;
+  free->payload.flags = s_lastRunFlag ? COMM_FLAG_RUN : 0;
+  if (s_lastFlowTargetLpm > 0.0f) free->payload.flags |= COMM_FLAG_FLOW_VALID;
+  if (user) {
+    s_txStats.userSent++;
+    s_status.pending = true;
     s_statusDirty = true;
-    portEXIT_CRITICAL(&s_statusMux);
+  } else {
+    s_txStats.heartbeatsSent++;
   }
+  return free;
+}
 
-  return ok;
+// Hand a copy to ESP-NOW outside the lock. An immediate failure leaves a user
+// command to its retransmit timer.
+static bool transmit(const COMM_Payload& p, unsigned long nowMs) {
+  s_lastTxMs = nowMs;
+  return espnow_link_send(&p, sizeof(p)) == ENL_OK;
 }
 
-bool commSendSetpoint(float setpointF, bool runFlag) {
+bool commSendSetpoint(float setpointF, bool runFlag, float flowTargetLpm) {
+  const unsigned long nowMs = millis();
   s_lastSetpointF = setpointF;
   s_lastRunFlag = runFlag;
-  return sendCurrent(millis(), /*userTx=*/true);
+  s_lastFlowTargetLpm = flowTargetLpm;
+
+  portENTER_CRITICAL(&s_statusMux);
+  TxSlot* slot = claimSlotLocked(nowMs, /*user=*/true);
+  const COMM_Payload p = slot->payload;  // user commands always get a slot
+  portEXIT_CRITICAL(&s_statusMux);
+
+  (void) transmit(p, nowMs);
+  return true;
 }
 
-void commHeartbeatTick(unsigned long nowMs) {
-  // Avoid overlapping with any in-flight packet
+void commService(unsigned long nowMs) {
+  // Per-seq timers: retransmit user commands, give up on heartbeats
+  COMM_Payload resend[UI_TX_WINDOW];
+  size_t resendCount = 0;
   portENTER_CRITICAL(&s_statusMux);
-  bool inFlight = (s_inFlightSeq != 0);
+  for (RetiredSeq& r : s_retired) {
+    if (r.seq == 0 || (nowMs - r.lastSentMs) < UI_RETX_TIMEOUT_MS) continue;
+    s_link.lost();
+    r.seq = 0;
+  }
+  for (TxSlot& s : s_window) {
+    if (!s.used || (nowMs - s.lastSentMs) < UI_RETX_TIMEOUT_MS) continue;
+    s_link.lost();
+    if (s.user && s.retries < UI_RETX_MAX) {
+      s.retries++;
+      s.lastSentMs = nowMs;
+      s.payload.ms = nowMs;
+      s_txStats.retransmits++;
+      resend[resendCount++] = s.payload;
+      continue;
+    }
+    if (s.user) {
+      s_txStats.userFailed++;
+    } else {
+      s_txStats.heartbeatsLost++;
+    }
+    s.used = false;
+    s_status.lastSeq = s.payload.seq;
+    s_status.lastOk = false;
+    s_status.pending = userInFlightLocked();
+    s_status.txCount++;
+    s_statusDirty = true;
+  }
   portEXIT_CRITICAL(&s_statusMux);
-  if (inFlight) return;
-  if ((nowMs - s_lastHeartbeatMs) < UI_HEARTBEAT_MS) return;
+  for (size_t i = 0; i < resendCount; ++i) (void) transmit(resend[i], nowMs);
 
-  (void) sendCurrent(nowMs, /*userTx=*/false);
+  // Heartbeat: keep the link alive when nothing else went out recently; it
+  // carries the last commanded state, like every packet
+  if ((nowMs - s_lastTxMs) < UI_HEARTBEAT_MS) return;
+  portENTER_CRITICAL(&s_statusMux);
+  TxSlot* slot = userInFlightLocked() ? nullptr : claimSlotLocked(nowMs, /*user=*/false);
+  COMM_Payload p{};
+  if (slot) p = slot->payload;
+  portEXIT_CRITICAL(&s_statusMux);
+  if (slot) (void) transmit(p, nowMs);
 }
 
 bool commPollStatus(CommStatus& outStatus) {
@@ -162,3 +346,21 @@ void commGetStatus(CommStatus& outStatus) {
   outStatus = s_status;
   portEXIT_CRITICAL(&s_statusMux);
 }
+
+CommTxStats commTxStats() {
+  portENTER_CRITICAL(&s_statusMux);
+  CommTxStats st = s_txStats;
+  st.inFlight = 0;
+  for (const TxSlot& s : s_window) {
+    if (s.used) st.inFlight++;
+  }
+  portEXIT_CRITICAL(&s_statusMux);
+  return st;
+}
+
+LinkQualityStats commLinkQuality() {
+  portENTER_CRITICAL(&s_statusMux);
+  const LinkQualityStats st = s_link.stats();
+  portEXIT_CRITICAL(&s_statusMux);
+  return st;
+}
@@ -2,35 +2,70 @@
  * ================================================================
  *  Module: communication
  *  Purpose: Provides UI-side communication functions for the shower
- *           controller. Handles transmission of setpoint and run-state
- *           commands to the Control Unit via ESP-NOW.
+ *           controller. Handles transmission of setpoint, run-state and
+ *           flow-target commands to the Control Unit via ESP-NOW.
  *
  *  Communication:
  *    - Sends COMM_Payload packets to Control Unit
- *    - Tracks sequence number, transmission count, and result status
+ *    - Sliding window of up to UI_TX_WINDOW messages awaiting ACK, each
+ *      with its own retransmit timer (UI_RETX_TIMEOUT_MS, UI_RETX_MAX).
+ *      Commands carry absolute state, so a new user command supersedes
+ *      any older one still in flight instead of queueing behind it, and
+ *      evicts a heartbeat if the window is full; heartbeats are sent
+ *      once and only when no user command is outstanding
+ *    - Tracks sequence number, transmission count, result status and
+ *      per-command delivery latency (first send → ACK)
+ *    - Takes the outlet/flow readout from ACKs (v1) and from the
+ *      COMM_TelemetryFrame that Control pushes on its own (v2), so the
+ *      display refreshes at the push rate, not the heartbeat rate
+ *    - Link quality (commLinkQuality): round-trip time of every ACK
+ *      (Control echoes the ms of the send it answers, restamped on each
+ *      retransmit), sends lost (no ACK within UI_RETX_TIMEOUT_MS) and
+ *      duplicate ACKs over a rolling window, and the RSSI of every
+ *      frame. Superseded or evicted sends stay tracked for
+ *      UI_RETX_TIMEOUT_MS (up to UI_RETIRED_SEQS of them), so their late
+ *      ACKs count as delivered, not duplicate. Control's view of the other
+ *      direction arrives in its telemetry frames (ctrlRssiDbm, ctrlLossPct,
+ *      ctrlDupPct)
  *    - Optional encryption (PMK/LMK handled in EspNowLink)
  *
  *  Dependencies:
  *    - <stdint.h>  (basic integer types)
  *    - EspNowLink  (transport layer)
  *    - config.h    (COMM_* constants and MAC addresses)
+ *    - ../common/link_quality.h (RTT/loss/duplicate/RSSI accounting)
  *
  *  Interface:
  *    bool commInit();
- *    bool commSendSetpoint(float setpointF, bool runFlag);
+ *    bool commSendSetpoint(float setpointF, bool runFlag, float flowTargetLpm);
+ *    void commService(unsigned long nowMs);
  *    bool commPollStatus(CommStatus& outStatus);
  *    void commGetStatus(CommStatus& outStatus);
+ *    CommTxStats commTxStats();
+ *    LinkQualityStats commLinkQuality();
  *
  *  Data Structures:
  *    struct CommStatus {
- *      uint16_t lastSeq;   // last transmitted sequence number
- *      uint32_t txCount;   // total successful or failed transmissions
- *      bool     lastOk;    // true=ACK received, false=TX failed
+ *      uint16_t lastSeq;   // last ACKed or failed sequence number
+ *      uint32_t txCount;   // total messages ACKed or failed
+ *      bool     lastOk;    // true=ACK received, false=retries exhausted / heartbeat lost
  *      bool     pending;   // true=awaiting ACK for user TX (setpoint/run)
  *      float    outletTempF;  // latest outlet temperature mirrored from Control
  *      bool     outletValid;  // true if outletTempF is valid
  *      float    flowLpm;      // latest flow rate (L/min) from Control
  *      bool     flowValid;    // true if flowLpm is valid
+ *      float    hotTempF;     // hot supply (°F), v2 telemetry only
+ *      bool     hotValid;
+ *      float    coldTempF;    // cold supply (°F), v2 telemetry only
+ *      bool     coldValid;
+ *      float    ratio;        // mix ratio in use, v2 telemetry only
+ *      uint32_t faultMask;    // Control's active faults, v2 telemetry only
+ *      bool     ctrlRunning;  // Control is running the mix, v2 telemetry only
+ *      uint32_t telemetryCount; // telemetry frames received (0 = v1 Control)
+ *      uint32_t lastLatencyUs;  // latest user command: first send → ACK
+ *      int8_t   ctrlRssiDbm;    // Control's RSSI of UI frames, v2 telemetry only
+ *      uint8_t  ctrlLossPct;    // UI packets Control missed, rolling (%)
+ *      uint8_t  ctrlDupPct;     // UI packets Control got twice, rolling (%)
  *    };
  * ================================================================
  */
@@ -39,6 +74,8 @@
 
 #include <stdint.h>
 
+#include "../common/link_quality.h"
+
 // Tracks UI→Control communication state
 struct CommStatus {
   uint16_t lastSeq;
@@ -49,20 +86,59 @@ struct CommStatus {
   bool outletValid;
   float flowLpm;
   bool flowValid;
+  float hotTempF;
+  bool hotValid;
+  float coldTempF;
+  bool coldValid;
+  float ratio;
+  uint32_t faultMask;
+  bool ctrlRunning;
+  uint32_t telemetryCount;
+  uint32_t lastLatencyUs;
+  int8_t ctrlRssiDbm;
+  uint8_t ctrlLossPct;
+  uint8_t ctrlDupPct;
+};
+
+// Sender counters since boot
+struct CommTxStats {
+  uint32_t userSent;         // user commands (setpoint/run/flow) sent
+  uint32_t userDelivered;    // ... ACKed
+  uint32_t userFailed;       // ... given up after UI_RETX_MAX retransmits
+  uint32_t superseded;       // ... replaced by a newer command before their ACK
+  uint32_t retransmits;      // user command resends
+  uint32_t heartbeatsSent;
+  uint32_t heartbeatsAcked;
+  uint32_t heartbeatsLost;   // no ACK within UI_RETX_TIMEOUT_MS, or evicted by a user command
+  uint32_t macFails;         // ESP-NOW reported no MAC-level delivery
+  uint32_t latencyLastUs;    // user command delivery latency (first send → ACK)
+  uint32_t latencyMeanUs;
+  uint32_t latencyMaxUs;
+  uint32_t inFlight;         // window slots in use now
 };
 
 // Initialize communication layer (ESP-NOW transport setup)
 bool commInit();
 
-// Send current setpoint and run-state to Control Unit
-bool commSendSetpoint(float setpointF, bool runFlag);
+// Send current setpoint, run-state and flow target (L/min, 0 = full flow)
+// to Control Unit. Sent at once, superseding any earlier command still
+// awaiting its ACK; retransmitted by commService() until ACKed. Returns true
+// once queued (a failed first send is retried like a lost one).
+bool commSendSetpoint(float setpointF, bool runFlag, float flowTargetLpm);
 
-// Heartbeat/service function to be called from loop() with millis()
-// Keeps link alive while runFlag is true using the last sent state
-void commHeartbeatTick(unsigned long nowMs);
+// Retransmit timers and heartbeat; call from loop() with millis(). Sends a
+// heartbeat with the last commanded state when nothing went out for
+// UI_HEARTBEAT_MS.
+void commService(unsigned long nowMs);
 
 // Check if communication status has changed since last poll
 bool commPollStatus(CommStatus& outStatus);
 
 // Retrieve latest communication status snapshot
 void commGetStatus(CommStatus& outStatus);
+
+// Sender counters and latency (snapshot)
+CommTxStats commTxStats();
+
+// Round trips, rolling loss/duplicates and RSSI as seen by the UI (snapshot)
+LinkQualityStats commLinkQuality();
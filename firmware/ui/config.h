@@ -34,6 +34,12 @@ constexpr unsigned long BTN_REPEAT_MS = 150;        // interval between subseque
 
 constexpr unsigned long UI_HEARTBEAT_MS = 1000;  // UI -> Control heartbeat interval
 
+// --- Reliable sender (communication.h) ---
+constexpr unsigned UI_TX_WINDOW = 4;               // Messages awaiting ACK at once
+constexpr unsigned long UI_RETX_TIMEOUT_MS = 100;  // No ACK after this: resend (user) / count lost (heartbeat)
+constexpr unsigned UI_RETX_MAX = 5;                // Resends before a user command is reported failed
+constexpr unsigned UI_RETIRED_SEQS = 8;            // Superseded/evicted seqs whose late ACK still counts as delivered
+
 // ====================================================
 // UI interaction pacing
 // ====================================================
@@ -47,7 +47,8 @@ void displayDraw(const DisplayState& s) {
   // Mode label for main value
   const bool showingFlow = s.showingFlow;
   const bool showingSetpoint = s.showingSetpoint && !showingFlow;  // flow overlay wins
-  oledDisplay.drawStr(0, 24, showingFlow ? "FLOW" : (showingSetpoint ? "SET" : "OUT"));
+  const bool showingFlowTarget = showingFlow && s.showingSetpoint;  // flow target edit
+  oledDisplay.drawStr(0, 24, showingFlow ? (showingFlowTarget ? "FSET" : "FLOW") : (showingSetpoint ? "SET" : "OUT"));
 
   // ─────────────────────────────
   // Center: main setpoint (large)
@@ -57,8 +58,8 @@ void displayDraw(const DisplayState& s) {
   float valueF;
   const char* unitStr;
   if (showingFlow) {
-    valueValid = s.flowValid;
-    valueF = s.flowLpm;
+    valueValid = showingFlowTarget ? s.flowTargetLpm > 0.0f : s.flowValid;
+    valueF = showingFlowTarget ? s.flowTargetLpm : s.flowLpm;
     unitStr = "L/m";
   } else {
     valueValid = showingSetpoint || s.outletValid;
@@ -77,7 +78,7 @@ void displayDraw(const DisplayState& s) {
       snprintf(tempStr, sizeof(tempStr), "%3.1f", valueF);
     }
   } else {
-    snprintf(tempStr, sizeof(tempStr), "---");
+    snprintf(tempStr, sizeof(tempStr), showingFlowTarget ? "MAX" : "---");  // no target: full flow
   }
 
   uint16_t tempW = oledDisplay.getStrWidth(tempStr);
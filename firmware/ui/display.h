@@ -21,8 +21,10 @@
  *      float outletTempF;     // latest outlet temperature from Control (°F)
  *      float stepF;           // current step size for adjustments
  *      float flowLpm;         // latest flow rate (L/min)
+ *      float flowTargetLpm;   // flow target (L/min, 0 = full flow)
  *      bool  showingSetpoint; // true when user is editing/pending
- *      bool  showingFlow;     // true when flow overlay is active
+ *      bool  showingFlow;     // true when flow overlay is active (with
+ *                             // showingSetpoint: the flow target)
  *      bool  outletValid;     // outletTempF is valid
  *      bool  flowValid;       // flowLpm is valid
  *      bool  runFlag;         // true=ON, false=OFF
@@ -45,6 +47,7 @@ struct DisplayState {
   float outletTempF;
   float stepF;
   float flowLpm;
+  float flowTargetLpm;
   bool showingSetpoint;
   bool showingFlow;
   bool outletValid;
@@ -3,14 +3,15 @@
  *  Module: ui
  *  Purpose: Handles the user interface for the shower controller.
  *           Reads button inputs, updates the OLED display, and
- *           transmits setpoint and run-state commands to the Control Unit.
+ *           transmits setpoint, run-state and flow-target commands to the
+ *           Control Unit.
  *
  *  Hardware:
  *    - SSD1309 128×64 OLED (SPI, U8g2 library)
  *    - 5 active-low pushbuttons (▲ ▼ ● A B)
  *
  *  Communication:
- *    - Sends setpoint and run-state data to Control Unit via ESP-NOW
+ *    - Sends setpoint, run-state and flow-target data to Control Unit via ESP-NOW
  *    - Optional encryption using PMK/LMK
  * ================================================================
  */
@@ -28,6 +29,17 @@ static bool setpointDirty = false;            // true when setpoint changed but
 static unsigned long lastSetpointEditMs = 0;  // last time the user adjusted setpoint
 static bool flowOverlayLatched = false;       // true while flow overlay is active
 
+static float flowTargetLpm = FLOW_TARGET_DEFAULT_LPM;  // 0 = full flow
+
+// ▲/▼ on the flow overlay: ▲ past FLOW_TARGET_MAX_LPM and ▼ from full flow
+// wrap between the selectable range and full flow (0)
+static float stepFlowTarget(float lpm, int dir) {
+  if (lpm <= 0.0f) return dir < 0 ? FLOW_TARGET_MAX_LPM : 0.0f;
+  lpm += dir * FLOW_TARGET_STEP_LPM;
+  if (lpm > FLOW_TARGET_MAX_LPM + 0.001f) return 0.0f;
+  return constrain(lpm, FLOW_TARGET_MIN_LPM, FLOW_TARGET_MAX_LPM);
+}
+
 // Map UI + comm status into DisplayState and draw on OLED
 static void updateDisplay(const CommStatus& st, bool showingFlow) {
   const bool showingSetpoint = setpointDirty || st.pending;
@@ -35,6 +47,7 @@ static void updateDisplay(const CommStatus& st, bool showingFlow) {
   ds.setpointF = setpointF;
   ds.outletTempF = st.outletTempF;
   ds.flowLpm = st.flowLpm;
+  ds.flowTargetLpm = flowTargetLpm;
   ds.stepF = stepF;
   ds.showingSetpoint = showingSetpoint;
   ds.showingFlow = showingFlow;
@@ -87,6 +100,10 @@ void loop() {
     else
       stepF = 0.5f;
     displayChanged = true;
+  } else if (flowOverlayLatched && (ev.upClick || ev.upRepeat || ev.downClick || ev.downRepeat)) {
+    flowTargetLpm = stepFlowTarget(flowTargetLpm, (ev.upClick || ev.upRepeat) ? 1 : -1);
+    markSetpointDirty();
+    displayChanged = true;
   } else if (ev.upClick || ev.upRepeat) {
     setpointF += stepF;
     markSetpointDirty();
@@ -113,9 +130,9 @@ void loop() {
     displayChanged = true;
   }
 
+  // ▲/▼ click/repeat edit the flow target and keep the overlay up
   auto anyNonFlowEvent = [&]() {
-    return ev.chordStepLong || ev.upClick || ev.upDblClick || ev.upLong || ev.upRepeat ||
-           ev.downClick || ev.downDblClick || ev.downLong || ev.downRepeat ||
+    return ev.chordStepLong || ev.upDblClick || ev.upLong || ev.downDblClick || ev.downLong ||
            ev.okClick || ev.okDblClick || ev.okLong || ev.okRepeat ||
            ev.aClick || ev.aDblClick || ev.aLong || ev.aRepeat ||
            ev.bClick || ev.bDblClick || ev.bLong || ev.bRepeat;
@@ -131,31 +148,30 @@ void loop() {
     setpointF = constrain(setpointF, SETPOINT_MIN_F, SETPOINT_MAX_F);
   }
 
-  // Heartbeat: keep link alive while running
-  commHeartbeatTick(nowMs);
+  // Retransmits and heartbeat (keeps the link alive)
+  commService(nowMs);
 
   // Send setpoint after a quiet period with no edits
   if (setpointDirty && (nowMs - lastSetpointEditMs) >= UI_SETPOINT_SEND_DELAY_MS) {
     sendNow = true;
   }
 
+  // Goes out at once, even with heartbeats in flight; commService() resends
+  // it until ACKed, and a newer send replaces it
   if (sendNow) {
-    bool ok = commSendSetpoint(setpointF, runFlag);
+    (void) commSendSetpoint(setpointF, runFlag, flowTargetLpm);
     txTriggered = true;
-    if (setpointDirty) {
-      setpointDirty = !ok;
-      if (!ok) lastSetpointEditMs = nowMs;
-    } else if (!ok) {
-      // retry after a short pause if immediate send failed
-      setpointDirty = true;
-      lastSetpointEditMs = nowMs;
-    }
+    setpointDirty = false;
   }
 
-  // Check if comm status changed (pending, ACK, or TX fail)
+  // Check if comm status changed (pending, ACK, TX fail, or telemetry push)
   CommStatus st{};
   bool statusChanged = commPollStatus(st);
 
+  // Telemetry pushes refresh the screen but are not TX results worth logging
+  static uint32_t loggedTxCount = 0;
+  static bool loggedPending = false;
+
   // Redraw and log when UI state or comm status changes
   if (displayChanged || statusChanged || txTriggered || setpointDirty) {
     if (!statusChanged) commGetStatus(st);
@@ -163,16 +179,27 @@ void loop() {
     flowOverlayActive = flowOverlayLatched;
     updateDisplay(st, flowOverlayActive);
 
-    if (txTriggered || statusChanged) {
+    if (txTriggered || st.txCount != loggedTxCount || st.pending != loggedPending) {
+      loggedTxCount = st.txCount;
+      loggedPending = st.pending;
       if (st.pending || setpointDirty)
         Serial.println("UI->CTRL TX pending");
       else if (!st.lastOk)
         Serial.println("UI<-CTRL TX failed");
-      else
-        Serial.printf("UI->CTRL setpoint=%.1fF run=%s seq=%lu\n",
+      else {
+        const LinkQualityStats link = commLinkQuality();
+        Serial.printf("UI->CTRL setpoint=%.1fF flow=%.2fL/m run=%s seq=%lu latency=%.1fms "
+                      "rtt=%.1fms rto=%lums rssi=%ddBm loss=%.1f%%\n",
                       setpointF,
+                      flowTargetLpm,
                       runFlag ? "ON" : "OFF",
-                      (unsigned long) st.lastSeq);
+                      (unsigned long) st.lastSeq,
+                      st.lastLatencyUs / 1000.0f,
+                      link.rttSmoothMs,
+                      (unsigned long) link.rtoMs,
+                      (int) link.rssiLastDbm,
+                      link.lossPct);
+      }
     }
   }
 
@@ -66,7 +66,7 @@ def main() -> None:
 
 
 def _plot_csv(csv_path: Path, plt):
-  df = pd.read_csv(csv_path)
+  df = pd.read_csv(csv_path, comment="#")
   df["t_s"] = df["ms"] / 1000.0
 
   fig, (ax_temp, ax_ctrl) = plt.subplots(2, 1, figsize=(10, 6), sharex=True)